@@ -17,14 +17,14 @@ struct String128Annotation
 // not used
 struct VarAnnotation
 {
-    shared_ptr<Var>                             base;
-    optional<variant<int32_t, shared_ptr<Var>>> index; // int32_t index is 0-based
+    Var*                                base;
+    optional<variant<int32_t, Var*>>    index; // int32_t index is 0-based
 };
 
 struct ArrayAnnotation
 {
-    shared_ptr<Var>                   base;
-    variant<int32_t, shared_ptr<Var>> index;    // int32_t index is 0-based
+    Var*                    base;
+    variant<int32_t, Var*>  index;    // int32_t index is 0-based
 };
 
 struct ModelAnnotation
@@ -69,7 +69,7 @@ struct DummyCommandAnnotation
 struct ReplacedCommandAnnotation
 {
     const Command& command;
-    std::vector<any> params;
+    small_vector<Commands::MatchArgument, 1> params;    // only integers and floats.
 };
 
 // Assigned to the node during parse.
@@ -77,3 +77,25 @@ struct DumpAnnotation
 {
     std::vector<uint8_t> bytes;
 };
+
+/// Every type a syntax tree node may be annotated with (see `SyntaxTree::set_annotation`).
+///
+/// This is a closed set so annotations live inline in the node, without any allocation or RTTI lookup.
+/// Symbols are referenced by plain pointers into the `SymTable` which owns them.
+using Annotation = variant<int32_t,
+                           float,
+                           Var*,
+                           Label*,
+                           Scope*,
+                           std::reference_wrapper<const Command>,
+                           TextLabelAnnotation,
+                           String128Annotation,
+                           ArrayAnnotation,
+                           ModelAnnotation,
+                           RepeatAnnotation,
+                           SwitchAnnotation,
+                           SwitchCaseAnnotation,
+                           IncDecAnnotation,
+                           DummyCommandAnnotation,
+                           ReplacedCommandAnnotation,
+                           DumpAnnotation>;
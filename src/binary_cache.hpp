@@ -0,0 +1,137 @@
+#pragma once
+#include <stdinc.h>
+#include "binary_fetcher.hpp"
+#include <random>
+
+//
+// Helpers for the binary cache files (precompiled configuration, build cache).
+//
+
+/// Thrown when the cache file is truncated or inconsistent.
+struct CacheError {};
+
+/// Appends little-endian values into a growing buffer.
+struct CacheWriter
+{
+    std::string bytes;
+
+    void u8(uint8_t value)
+    {
+        this->bytes.push_back(char(value));
+    }
+
+    void u16(uint16_t value)
+    {
+        u8(value & 0xFF);
+        u8(value >> 8);
+    }
+
+    void u32(uint32_t value)
+    {
+        u16(value & 0xFFFF);
+        u16(value >> 16);
+    }
+
+    void u64(uint64_t value)
+    {
+        u32(value & 0xFFFFFFFF);
+        u32(value >> 32);
+    }
+
+    void i32(int32_t value)
+    {
+        u32(static_cast<uint32_t>(value));
+    }
+
+    void string(const string_view& value)
+    {
+        u32(uint32_t(value.size()));
+        this->bytes.append(value.data(), value.size());
+    }
+};
+
+/// Fetches values sequentially from the cache file, throwing `CacheError` when going out of its bounds.
+struct CacheReader
+{
+    BinaryFetcher bf;
+    size_t        offset = 0;
+
+    explicit CacheReader(const void* data, size_t size) :
+        bf(data, size)
+    {}
+
+    template<typename T>
+    T check(optional<T> opt, size_t count)
+    {
+        if(!opt) throw CacheError();
+        this->offset += count;
+        return *opt;
+    }
+
+    uint8_t  u8()  { return check(bf.fetch_u8(offset), 1); }
+    uint16_t u16() { return check(bf.fetch_u16(offset), 2); }
+    uint32_t u32() { return check(bf.fetch_u32(offset), 4); }
+    int32_t  i32() { return check(bf.fetch_i32(offset), 4); }
+
+    uint64_t u64()
+    {
+        uint64_t lo = u32();
+        uint64_t hi = u32();
+        return lo | (hi << 32);
+    }
+
+    /// Fetches a count of elements, each of which takes at least `min_element_size` bytes.
+    uint32_t count(size_t min_element_size)
+    {
+        uint32_t value = u32();
+        if(uint64_t(value) * min_element_size > bf.size - offset)
+            throw CacheError();
+        return value;
+    }
+
+    /// Fetches a blob of bytes, prefixed by its size, into `dest`.
+    void blob(std::vector<uint8_t>& dest)
+    {
+        uint32_t size = count(1);
+        dest.assign(bf.bytes + offset, bf.bytes + offset + size);
+        this->offset += size;
+    }
+
+    string_view string()
+    {
+        uint32_t size = count(1);
+        string_view value(reinterpret_cast<const char*>(bf.bytes + offset), size);
+        this->offset += size;
+        return value;
+    }
+
+    bool at_end() const
+    {
+        return this->offset == bf.size;
+    }
+};
+
+/// Writes `bytes` into `cache_file` atomically.
+///
+/// The bytes are written into a temporary file first, so that concurrent compilers never see a partially written cache.
+inline bool write_cache_file(const fs::path& cache_file, const std::string& bytes)
+{
+    std::error_code ec;
+    fs::path temp_file = cache_file;
+    temp_file += fmt::format(".{:08x}.tmp", std::random_device()());
+
+    if(!write_file(temp_file, bytes.data(), bytes.size()))
+    {
+        fs::remove(temp_file, ec);
+        return false;
+    }
+
+    fs::rename(temp_file, cache_file, ec);
+    if(ec)
+    {
+        fs::remove(temp_file, ec);
+        return false;
+    }
+
+    return true;
+}
@@ -6,24 +6,31 @@
 struct BinaryWriter
 {
 public:
+    /// Writes into a buffer of its own, which grows as bytes are written.
     explicit BinaryWriter()
-        : offset(0), max_offset(0)
+        : bytecode(nullptr), offset(0), max_offset(0), growable(true)
     {}
 
     explicit BinaryWriter(size_t size) :
-        offset(0), max_offset(size), bytecode(new uint8_t[size])
+        storage(new uint8_t[size]), bytecode(storage.get()), offset(0), max_offset(size), growable(false)
+    {}
+
+    /// Writes into `buffer` instead of a buffer of its own.
+    /// \warning `buffer` must have room for `size` bytes and be alive as long as this object.
+    explicit BinaryWriter(void* buffer, size_t size) :
+        bytecode(static_cast<uint8_t*>(buffer)), offset(0), max_offset(size), growable(false)
     {}
 
     /// \returns the buffer with the generated bytes.
     const void* buffer() const
     {
-        return this->bytecode.get();
+        return this->bytecode;
     }
 
     /// \returns the size of the buffer with the generated bytes.
     size_t buffer_size() const
     {
-        return this->max_offset;
+        return this->growable? this->offset : this->max_offset;
     }
 
     size_t current_offset() const
@@ -33,7 +40,7 @@ public:
 
     void emplace_u8(uint8_t value)
     {
-        assert(this->offset + 1 <= max_offset);
+        this->reserve(1);
         bytecode[this->offset++] = reinterpret_cast<uint8_t&>(value);
     }
 
@@ -70,21 +77,21 @@ public:
 
     void emplace_bytes(size_t count, const void* bytes)
     {
-        assert(this->offset + count <= max_offset);
+        this->reserve(count);
         std::memcpy(&this->bytecode[offset], bytes, count);
         this->offset += count;
     }
 
     void emplace_fill(size_t count, uint8_t val)
     {
-        assert(this->offset + count <= max_offset);
+        this->reserve(count);
         std::memset(&this->bytecode[offset], val, count);
         this->offset += count;
     }
 
     void emplace_chars(size_t count, const char* data)
     {
-        assert(this->offset + count <= max_offset);
+        this->reserve(count);
         std::strncpy(reinterpret_cast<char*>(&this->bytecode[offset]), data, count);
         this->offset += count;
     }
@@ -100,7 +107,7 @@ public:
     template<typename FuncT>
     void emplace_chars(size_t count, const char* data, FuncT transform)
     {
-        assert(this->offset + count <= max_offset);
+        this->reserve(count);
         for(size_t i = 0; i < count; ++i)
         {
             if(*data == 0)
@@ -112,7 +119,27 @@ public:
     }
 
 private:
-    std::unique_ptr<uint8_t[]>  bytecode; // size == max_offset
+    /// Makes room for `count` more bytes.
+    void reserve(size_t count)
+    {
+        if(this->offset + count <= this->max_offset)
+            return;
+
+        assert(this->growable);
+        size_t new_size = std::max(this->offset + count, std::max(size_t(256), this->max_offset * 2));
+        std::unique_ptr<uint8_t[]> new_storage(new uint8_t[new_size]);
+        if(this->offset != 0)
+            std::memcpy(new_storage.get(), this->bytecode, this->offset);
+
+        this->storage = std::move(new_storage);
+        this->bytecode = this->storage.get();
+        this->max_offset = new_size;
+    }
+
+private:
+    std::unique_ptr<uint8_t[]>  storage;  // null when writing into a buffer of the caller
+    uint8_t*                    bytecode; // size == max_offset
     size_t                      offset;
     size_t                      max_offset;
+    bool                        growable;
 };
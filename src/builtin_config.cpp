@@ -0,0 +1,36 @@
+#include <stdinc.h>
+#include "builtin_config.hpp"
+
+#if defined(GTA3SC_BUILTIN_CONFIG)
+extern const BuiltinXml builtin_xml_common[];
+extern const BuiltinXml builtin_xml_gta3[];
+extern const BuiltinXml builtin_xml_gtavc[];
+extern const BuiltinXml builtin_xml_gtasa[];
+extern const size_t builtin_xml_common_count;
+extern const size_t builtin_xml_gta3_count;
+extern const size_t builtin_xml_gtavc_count;
+extern const size_t builtin_xml_gtasa_count;
+
+static const std::pair<const BuiltinXml*, const size_t&> builtin_xml_tables[] = {
+    { builtin_xml_common, builtin_xml_common_count },
+    { builtin_xml_gta3, builtin_xml_gta3_count },
+    { builtin_xml_gtavc, builtin_xml_gtavc_count },
+    { builtin_xml_gtasa, builtin_xml_gtasa_count },
+};
+#endif
+
+const BuiltinXml* BuiltinXml::find(const void* data, size_t size)
+{
+#if defined(GTA3SC_BUILTIN_CONFIG)
+    const uint64_t hash = fnv1a64(data, size);
+    for(auto& table : builtin_xml_tables)
+    {
+        for(size_t i = 0; i < table.second; ++i)
+        {
+            if(table.first[i].size == size && table.first[i].hash == hash)
+                return &table.first[i];
+        }
+    }
+#endif
+    return nullptr;
+}
@@ -0,0 +1,138 @@
+///
+/// Built-in configuration - The bundled XML definition files, translated into tables at build time.
+///
+/// The translation is done by utils/builtin_config.py. Any XML file whose contents match one of these
+/// tables is loaded from it by `Commands::from_xml` instead of being parsed.
+///
+#pragma once
+#include <stdinc.h>
+#include "commands.hpp"
+
+// Flags of a command.
+enum : uint8_t
+{
+    CMD_SUPPORTED   = 1 << 0,
+    CMD_INTERNAL    = 1 << 1,
+    CMD_EXTENSION   = 1 << 2,
+    CMD_HAS_ID      = 1 << 3,
+    CMD_HAS_HASH    = 1 << 4,
+};
+
+// Flags of a command argument.
+enum : uint16_t
+{
+    ARG_OPTIONAL            = 1 << 0,
+    ARG_IS_OUTPUT           = 1 << 1,
+    ARG_IS_REF              = 1 << 2,
+    ARG_ALLOW_CONSTANT      = 1 << 3,
+    ARG_ALLOW_GLOBAL_VAR    = 1 << 4,
+    ARG_ALLOW_LOCAL_VAR     = 1 << 5,
+    ARG_ALLOW_TEXT_LABEL    = 1 << 6,
+    ARG_ALLOW_POINTER       = 1 << 7,
+    ARG_PRESERVE_CASE       = 1 << 8,
+};
+
+/// 64-bit FNV-1a hash of a sequence of bytes.
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325)
+{
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+    for(size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+/// Packs the boolean properties of `arg` into `ARG_*` flags.
+inline uint16_t encode_arg_flags(const Command::Arg& arg)
+{
+    return (arg.optional? ARG_OPTIONAL : 0)
+         | (arg.is_output? ARG_IS_OUTPUT : 0)
+         | (arg.is_ref? ARG_IS_REF : 0)
+         | (arg.allow_constant? ARG_ALLOW_CONSTANT : 0)
+         | (arg.allow_global_var? ARG_ALLOW_GLOBAL_VAR : 0)
+         | (arg.allow_local_var? ARG_ALLOW_LOCAL_VAR : 0)
+         | (arg.allow_text_label? ARG_ALLOW_TEXT_LABEL : 0)
+         | (arg.allow_pointer? ARG_ALLOW_POINTER : 0)
+         | (arg.preserve_case? ARG_PRESERVE_CASE : 0);
+}
+
+/// Unpacks `ARG_*` flags into the boolean properties of `arg`.
+inline void decode_arg_flags(Command::Arg& arg, uint16_t flags)
+{
+    arg.optional         = (flags & ARG_OPTIONAL) != 0;
+    arg.is_output        = (flags & ARG_IS_OUTPUT) != 0;
+    arg.is_ref           = (flags & ARG_IS_REF) != 0;
+    arg.allow_constant   = (flags & ARG_ALLOW_CONSTANT) != 0;
+    arg.allow_global_var = (flags & ARG_ALLOW_GLOBAL_VAR) != 0;
+    arg.allow_local_var  = (flags & ARG_ALLOW_LOCAL_VAR) != 0;
+    arg.allow_text_label = (flags & ARG_ALLOW_TEXT_LABEL) != 0;
+    arg.allow_pointer    = (flags & ARG_ALLOW_POINTER) != 0;
+    arg.preserve_case    = (flags & ARG_PRESERVE_CASE) != 0;
+}
+
+/// The contents of a bundled XML definition file.
+///
+/// Everything is kept in document order and with the defaults of missing attributes already applied,
+/// but names (of enums and entities) are left unresolved, since they may refer to other files.
+struct BuiltinXml
+{
+    struct Constant
+    {
+        const char* name;
+        int32_t     value;
+    };
+
+    struct Enum
+    {
+        const char* name;
+        bool        is_global;
+        uint32_t    first_constant;
+        uint32_t    num_constants;
+    };
+
+    struct Arg
+    {
+        ArgType     type;
+        uint16_t    flags;          //< ARG_* flags.
+        const char* entity;         //< Name of the entity type, or `nullptr`.
+        const char* enum_name;      //< Name of the enum, or `nullptr`.
+    };
+
+    struct Command
+    {
+        const char* name;
+        uint8_t     flags;          //< CMD_* flags.
+        uint16_t    id;
+        uint32_t    hash;
+        uint32_t    first_arg;
+        uint32_t    num_args;
+    };
+
+    struct Alternator
+    {
+        const char* name;
+        uint32_t    first_alternative;
+        uint32_t    num_alternatives;
+    };
+
+    const char*             path;           //< Path relative to the configuration directory.
+    uint64_t                size;           //< Size of the file.
+    uint64_t                hash;           //< `fnv1a64` of the file.
+
+    const Constant*         constants;
+    const Enum*             enums;
+    size_t                  num_enums;
+
+    const Arg*              args;
+    const Command*          commands;
+    size_t                  num_commands;
+
+    const char* const*      alternatives;
+    const Alternator*       alternators;
+    size_t                  num_alternators;
+
+    /// Finds the bundled file whose contents are `data`.
+    static const BuiltinXml* find(const void* data, size_t size);
+};
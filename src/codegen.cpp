@@ -10,49 +10,109 @@
 ///
 template<typename T, typename TCodeGen>
 void generate_code(const T&, TCodeGen&);
-void generate_code(const CompiledData& data, CodeGenerator& codegen);
+void generate_code(const CompiledArg& arg, CodeGenerator& codegen);
+void generate_command(const CompiledIR::Instr& instr, CodeGenerator& codegen);
 void generate_code(const CompiledScmHeader& data, CodeGeneratorData& codegen);
 
-///
-/// This function should be overloaded/specialized for each pseudo-object generated by *compiler.hpp/cpp*.
-/// By default it calls `T.compiled_size()`.
-///
-template<typename T, typename TCodeGen>
-size_t compiled_size(const T&, const TCodeGen&);
-size_t compiled_size(const ArgVariant&, const CodeGenerator&);
-size_t compiled_size(const CompiledData&, const CodeGenerator&);
-
-uint32_t CodeGenerator::compute_labels()
+int32_t Relocation::resolve(uint32_t label_offset, uint32_t root_base, ProgramContext& program) const
 {
-    uint32_t offset = 0;
-    for(auto& op : this->compiled)
+    auto negated_offset = [&](int32_t offset)
     {
-        if(is<CompiledLabelDef>(op.data))
+        if(offset == 0)
         {
-            get<CompiledLabelDef>(op.data).label->code_position = offset;
+            program.error(nocontext, "compiled script references a label at the zero offset");
+            program.note(nocontext, "try using SCRIPT_NAME or NOP at the very top of your script");
         }
-        else
+        return -offset;
+    };
+
+    switch(this->kind)
+    {
+        case Kind::Absolute:
+            return static_cast<int32_t>(label_offset);
+        case Kind::NegatedAbsolute:
+            return negated_offset(static_cast<int32_t>(label_offset));
+        case Kind::NegatedLocal:
+            // local offsets are only used between scripts of the same root, see `generate_label`.
+            return negated_offset(static_cast<int32_t>(label_offset - root_base));
+        default:
+            Unreachable();
+    }
+}
+
+void Relocation::apply(void* code, uint32_t label_offset, uint32_t root_base, ProgramContext& program) const
+{
+    auto value = static_cast<uint32_t>(this->resolve(label_offset, root_base, program));
+    auto bytes = static_cast<uint8_t*>(code) + this->offset;
+    for(size_t i = 0; i < 4; ++i)
+        bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint32_t CodeGenerator::generate()
+{
+    this->bw = BinaryWriter();
+    this->relocations.clear();
+    this->symbol_references.clear();
+    this->local_labels.assign(this->compiled.num_local_labels, 0);
+
+    for(auto& instr : this->compiled.instrs)
+    {
+        switch(instr.op)
         {
-            offset += compiled_size(op, *this);
+            case CompiledIR::Op::Command:
+                generate_command(instr, *this);
+                break;
+            case CompiledIR::Op::LabelDef:
+            {
+                auto position = static_cast<uint32_t>(this->bw.current_offset());
+                if(this->compiled.is_local_label(instr.first))
+                    this->local_labels[instr.first - this->compiled.first_local_label] = position;
+                else
+                    this->symbols.label(instr.first).code_position = position;
+                break;
+            }
+            case CompiledIR::Op::Hex:
+                this->bw.emplace_bytes(instr.count, this->compiled.bytes.data() + instr.first);
+                break;
+            default:
+                Unreachable();
         }
     }
-    return offset;
+
+    return static_cast<uint32_t>(this->bw.buffer_size());
 }
 
-void CodeGenerator::generate()
+void CodeGenerator::relocate_into(void* output) const
 {
-    this->bw = BinaryWriter(this->script->code_size.value());
+    if(this->bw.buffer_size() != 0)
+        std::memcpy(output, this->bw.buffer(), this->bw.buffer_size());
+
+    auto code_offset = this->script->code_offset.value();
+    auto root_base = this->script->root_script()->base.value();
 
-    for(auto& op : this->compiled)
+    for(auto& reloc : this->relocations)
     {
-        generate_code(op, *this);
+        auto label_offset = this->compiled.is_local_label(reloc.label)?
+            code_offset + this->local_labels[reloc.label - this->compiled.first_local_label] :
+            this->symbols.label_offsets[reloc.label];
+        reloc.apply(output, label_offset, root_base, this->program);
     }
 }
 
-void CodeGeneratorData::generate()
+std::pair<const Script*, uint32_t> CodeGenerator::label_position(LabelId label) const
 {
-    visit_one(this->compiled, [this](const auto& h) {
-        this->bw = BinaryWriter(h.compiled_size());
+    if(this->compiled.is_local_label(label))
+        return { this->script.get(), this->local_labels[label - this->compiled.first_local_label] };
+
+    auto& symbol = this->symbols.label(label);
+    return { symbol.script, symbol.code_position.value() };
+}
+
+void CodeGeneratorData::generate(void* output)
+{
+    visit_one(this->compiled, [this, output](const auto& h) {
+        auto size = h.compiled_size();
+        this->bw = output? BinaryWriter(output, size) : BinaryWriter(size);
         generate_code(h, *this);
     });
 }
@@ -63,21 +123,21 @@ CustomHeaderOATC::CustomHeaderOATC(const std::vector<CodeGenerator*>& gens, Prog
 
     for(auto& pgen : gens)
     {
-        for(auto& op : pgen->ir())
+        for(auto& instr : pgen->ir().instrs)
         {
-            if(is<CompiledCommand>(op.data))
+            if(instr.op == CompiledIR::Op::Command)
             {
-                auto& ccmd = get<CompiledCommand>(op.data);
-                if(ccmd.command.hash)
+                auto& command = *instr.command;
+                if(command.hash)
                 {
-                    if(!this->find_opcode(ccmd.command))
+                    if(!this->find_opcode(command))
                     {
-                        this->ordinal_commands.emplace_back(&ccmd.command, (uint16_t) this->ordinal_commands.size());
+                        this->ordinal_commands.emplace_back(&command, (uint16_t) this->ordinal_commands.size());
                     }
                 }
-                else if(ccmd.command.id && this->starting_opcode < *ccmd.command.id)
+                else if(command.id && this->starting_opcode < *command.id)
                 {
-                    this->starting_opcode = *ccmd.command.id + 1;
+                    this->starting_opcode = *command.id + 1;
                 }
             }
         }
@@ -112,83 +172,6 @@ size_t CompiledHeaderList::compiled_size() const
 
 ////////////////////////////////////////////////////////////////////////
 
-template<typename T>
-inline size_t compiled_size(const T& x, const CodeGenerator&)
-{
-    return x.compiled_size();
-}
-
-inline size_t compiled_size(const EOAL&, const CodeGenerator&)
-{
-    return 1;
-}
-
-inline size_t compiled_size(const int8_t&, const CodeGenerator&)
-{
-    return 1 + sizeof(int8_t);
-}
-
-inline size_t compiled_size(const int16_t&, const CodeGenerator&)
-{
-    return 1 + sizeof(int16_t);
-}
-
-inline size_t compiled_size(const int32_t&, const CodeGenerator&)
-{
-    return 1 + sizeof(int32_t);
-}
-
-inline size_t compiled_size(const float& f, const CodeGenerator& codegen)
-{
-    if(codegen.program.opt.optimize_zero_floats && f == 0.0f)
-        return 1 + sizeof(int8_t);
-    if(codegen.program.opt.use_half_float)
-        return 1 + sizeof(int16_t);
-    return 1 + sizeof(float);
-}
-
-inline size_t compiled_size(const shared_ptr<Label>&, const CodeGenerator&)
-{
-    return 1 + sizeof(int32_t);
-}
-
-inline size_t compiled_size(const CompiledVar& v, const CodeGenerator&)
-{
-    if(v.index == nullopt || is<int32_t>(*v.index))
-        return 1 + sizeof(uint16_t);
-    else
-        return 1 + sizeof(uint16_t) * 2 + sizeof(uint8_t) * 2;
-}
-
-inline size_t compiled_size(const CompiledString& s, const CodeGenerator& codegen)
-{
-    switch(s.type)
-    {
-        case CompiledString::Type::TextLabel8:
-            return (codegen.program.opt.has_text_label_prefix? 1 : 0) + 8;
-        case CompiledString::Type::TextLabel16:
-            return 1 + 16;
-        case CompiledString::Type::StringVar:
-            return 1 + 1 + s.storage.size();
-        case CompiledString::Type::String128:
-            return 128;
-        default:
-            Unreachable();
-    }
-}
-
-inline size_t compiled_size(const ArgVariant& varg, const CodeGenerator& codegen)
-{
-    return visit_one(varg, [&](const auto& arg) { return ::compiled_size(arg, codegen); });
-}
-
-inline size_t compiled_size(const CompiledCommand& cmd, const CodeGenerator& codegen)
-{
-    size_t size = sizeof(uint16_t);
-    for(auto& a : cmd.args) size += ::compiled_size(a, codegen);
-    return size;
-}
-
 inline size_t CompiledScmHeader::compiled_size() const
 {
     switch(this->version)
@@ -222,11 +205,6 @@ inline size_t CustomHeaderOATC::compiled_size() const
     return size;
 }
 
-inline size_t compiled_size(const CompiledData& data, const CodeGenerator& codegen)
-{
-    return visit_one(data.data, [&](const auto& data) { return ::compiled_size(data, codegen); });
-}
-
 ////////////////////////////////////////////////////////////////////////
 
 template<typename T, typename CodeGen>
@@ -274,91 +252,120 @@ inline void generate_code(const float& value, CodeGenerator& codegen)
         static_assert(std::numeric_limits<float>::is_iec559
             && sizeof(float) == sizeof(uint32_t), "IEEE 754 floating point expected.");
 
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
         codegen.bw.emplace_u8(6);
-        codegen.bw.emplace_u32(reinterpret_cast<const uint32_t&>(value));
+        codegen.bw.emplace_u32(bits);
     }
 }
 
-inline void generate_code(const shared_ptr<Label>& label_ptr, CodeGenerator& codegen)
+inline void generate_label(LabelId label, CodeGenerator& codegen)
 {
     codegen.bw.emplace_u8(1);
 
-    auto emplace_local_offset = [&](int32_t offset)
-    {
-        if(offset == 0)
-        {
-            codegen.program.error(nocontext, "compiled script references a label at the zero offset");
-            codegen.program.note(nocontext, "try using SCRIPT_NAME or NOP at the very top of your script");
-        }
-        codegen.bw.emplace_i32(-offset);
-    };
+    const Script& label_script = codegen.ir().is_local_label(label)? *codegen.script : *codegen.symbols.label(label).script;
+
+    auto kind = Relocation::Kind::Absolute;
 
     if(!codegen.script->uses_local_offsets())
     {
         if(codegen.program.opt.use_local_offsets)
-        {
-            int32_t absolute_offset = static_cast<int32_t>(label_ptr->offset());
-            emplace_local_offset(absolute_offset);
-        }
-        else
-        {
-            codegen.bw.emplace_i32(label_ptr->offset());
-        }
+            kind = Relocation::Kind::NegatedAbsolute;
     }
     else // current script is mission/stream
     {
-        if(label_ptr->script.lock()->uses_local_offsets())
+        if(label_script.uses_local_offsets())
         {
-            assert(label_ptr->script.lock()->on_the_same_space_as(*codegen.script));
-            int32_t local_offset = static_cast<int32_t>(label_ptr->distance_from_base());
-            emplace_local_offset(local_offset);
+            assert(label_script.on_the_same_space_as(*codegen.script));
+            kind = Relocation::Kind::NegatedLocal;
         }
         else // label is within main block
         {
             if(codegen.program.opt.use_local_offsets)
                 codegen.program.error(*codegen.script, "cannot branch from this script into main block using local offsets [-mlocal-offsets]");
-
-            codegen.bw.emplace_i32(label_ptr->offset());
         }
     }
+
+    // the label may not be placed yet, the value is patched in by `CodeGenerator::relocate_into`.
+    codegen.relocations.emplace_back(Relocation { kind, static_cast<uint32_t>(codegen.bw.current_offset()), label });
+    codegen.bw.emplace_i32(0);
 }
 
-inline void generate_code(const CompiledString& str, CodeGenerator& codegen)
+inline void generate_model(const CompiledArg& model, CodeGenerator& codegen)
 {
+    auto value = model.integer();
+
+    uint8_t size = 4;
+    if(value >= std::numeric_limits<int8_t>::min() && value <= std::numeric_limits<int8_t>::max())
+        size = 1;
+    else if(value >= std::numeric_limits<int16_t>::min() && value <= std::numeric_limits<int16_t>::max())
+        size = 2;
+
+    // the value goes after the data type byte, and the link step keeps its size.
+    if(codegen.program.opt.emit_object)
+    {
+        auto offset = static_cast<uint32_t>(codegen.bw.current_offset() + 1);
+        codegen.symbol_references.emplace_back(SymbolReference { SymbolReference::Kind::Model, size, offset, model.b, 0 });
+    }
+
+    switch(size)
+    {
+        case 1: return generate_code(static_cast<int8_t>(value), codegen);
+        case 2: return generate_code(static_cast<int16_t>(value), codegen);
+        default: return generate_code(value, codegen);
+    }
+}
+
+/// Records a reference to the global variable `var` at the current offset, if emitting a relocatable object.
+inline void reference_global_var(const Var& var, int32_t addend, CodeGenerator& codegen)
+{
+    if(codegen.program.opt.emit_object)
+    {
+        auto offset = static_cast<uint32_t>(codegen.bw.current_offset());
+        codegen.symbol_references.emplace_back(SymbolReference { SymbolReference::Kind::GlobalVar, 2, offset, var.id, addend });
+    }
+}
+
+inline void generate_string(const CompiledArg& str, CodeGenerator& codegen)
+{
+    const char* storage = codegen.ir().string(str);
+
     switch(str.type)
     {
-        case CompiledString::Type::TextLabel8:
-            assert(str.storage.size() <= 8);
+        case CompiledArg::Type::TextLabel8:
+            assert(str.b <= 8);
             if(codegen.program.opt.has_text_label_prefix)
                 codegen.bw.emplace_u8(9);
-            codegen.bw.emplace_chars(8, str.storage.c_str(), !str.preserve_case);
+            codegen.bw.emplace_chars(8, storage, !str.preserve_case);
             break;
-        case CompiledString::Type::TextLabel16:
-            assert(str.storage.size() <= 16);
+        case CompiledArg::Type::TextLabel16:
+            assert(str.b <= 16);
             codegen.bw.emplace_u8(0xF);
-            codegen.bw.emplace_chars(16, str.storage.c_str(), !str.preserve_case);
+            codegen.bw.emplace_chars(16, storage, !str.preserve_case);
             break;
-        case CompiledString::Type::StringVar:
-            assert(str.storage.size() <= 127);
+        case CompiledArg::Type::StringVar:
+            assert(str.b <= 127);
             codegen.bw.emplace_u8(0xE);
-            codegen.bw.emplace_u8(static_cast<uint8_t>(str.storage.size()));
-            codegen.bw.emplace_chars(str.storage.size(), str.storage.c_str(), !str.preserve_case);
+            codegen.bw.emplace_u8(static_cast<uint8_t>(str.b));
+            codegen.bw.emplace_chars(str.b, storage, !str.preserve_case);
             break;
-        case CompiledString::Type::String128:
-            codegen.bw.emplace_chars(128, str.storage.c_str(), !str.preserve_case);
+        case CompiledArg::Type::String128:
+            codegen.bw.emplace_chars(128, storage, !str.preserve_case);
             break;
         default:
             Unreachable();
     }
 }
 
-inline void generate_code(const CompiledVar& v, CodeGenerator& codegen)
+inline void generate_var(const CompiledArg& v, CodeGenerator& codegen)
 {
-    bool global = v.var->global;
+    const Var& var = codegen.symbols.var(v.a);
+    bool global = var.global;
 
-    if(v.index == nullopt)
+    if(v.type != CompiledArg::Type::VarArrayVar)
     {
-        switch(v.var->type)
+        switch(var.type)
         {
             case VarType::Int:
             case VarType::Float:
@@ -374,99 +381,109 @@ inline void generate_code(const CompiledVar& v, CodeGenerator& codegen)
                 Unreachable();
         }
 
-        codegen.bw.emplace_u16(static_cast<uint16_t>(global? v.var->offset() : v.var->index));
+        int32_t actual_index = 0;
+        if(v.type == CompiledArg::Type::VarArrayConst)
+            actual_index = static_cast<int32_t>(v.b) * Var::space_taken(var.type);
+
+        if(global)
+            reference_global_var(var, actual_index * 4, codegen);
+
+        codegen.bw.emplace_u16(static_cast<uint16_t>(global? var.offset() + actual_index * 4 : var.index + actual_index));
     }
     else
     {
-        if(is<int32_t>(*v.index))
+        const Var& indexVar = codegen.symbols.var(v.b);
+        switch(var.type)
         {
-            switch(v.var->type)
-            {
-                case VarType::Int:
-                case VarType::Float:
-                    codegen.bw.emplace_u8(global? 0x2 : 0x3);
-                    break;
-                case VarType::TextLabel:
-                    codegen.bw.emplace_u8(global? 0xA : 0xB);
-                    break;
-                case VarType::TextLabel16:
-                    codegen.bw.emplace_u8(global? 0x10 : 0x11);
-                    break;
-                default:
-                    Unreachable();
-            }
-
-            auto actual_index = get<int32_t>(*v.index) * Var::space_taken(v.var->type);
-            codegen.bw.emplace_u16(static_cast<uint16_t>(global? v.var->offset() + actual_index * 4 : v.var->index + actual_index));
+            case VarType::Int:
+            case VarType::Float:
+                codegen.bw.emplace_u8(global? 0x7 : 0x8);
+                break;
+            case VarType::TextLabel:
+                codegen.bw.emplace_u8(global? 0xC : 0xD);
+                break;
+            case VarType::TextLabel16:
+                codegen.bw.emplace_u8(global? 0x12 : 0x13);
+                break;
+            default:
+                Unreachable();
         }
-        else
-        {
-            auto& indexVar = get<shared_ptr<Var>>(*v.index);
-            switch(v.var->type)
+
+        auto ivartype = [&]() -> uint8_t {
+            switch(var.type)
             {
-                case VarType::Int:
-                case VarType::Float:
-                    codegen.bw.emplace_u8(global? 0x7 : 0x8);
-                    break;
-                case VarType::TextLabel:
-                    codegen.bw.emplace_u8(global? 0xC : 0xD);
-                    break;
-                case VarType::TextLabel16:
-                    codegen.bw.emplace_u8(global? 0x12 : 0x13);
-                    break;
-                default:
-                    Unreachable();
+                case VarType::Int: return 0;
+                case VarType::Float: return 1;
+                case VarType::TextLabel: return 2;
+                case VarType::TextLabel16: return 3;
+                default: Unreachable();
             }
+        }();
 
-            auto ivartype = [&]() -> uint8_t {
-                switch(v.var->type)
-                {
-                    case VarType::Int: return 0;
-                    case VarType::Float: return 1;
-                    case VarType::TextLabel: return 2;
-                    case VarType::TextLabel16: return 3;
-                    default: Unreachable();
-                }
-            }();
+        if(global)
+            reference_global_var(var, 0, codegen);
 
-            codegen.bw.emplace_u16(static_cast<uint16_t>(global? v.var->offset() : v.var->index));
-            codegen.bw.emplace_u16(static_cast<uint16_t>(indexVar->global? indexVar->offset() : indexVar->index));
-            codegen.bw.emplace_u8(static_cast<uint8_t>(v.var->count.value()));
-            codegen.bw.emplace_u8((static_cast<uint8_t>(ivartype) & 0x7F) | (indexVar->global << 7));
-        }
+        codegen.bw.emplace_u16(static_cast<uint16_t>(global? var.offset() : var.index));
+
+        if(indexVar.global)
+            reference_global_var(indexVar, 0, codegen);
+
+        codegen.bw.emplace_u16(static_cast<uint16_t>(indexVar.global? indexVar.offset() : indexVar.index));
+        codegen.bw.emplace_u8(static_cast<uint8_t>(var.count.value()));
+        codegen.bw.emplace_u8((static_cast<uint8_t>(ivartype) & 0x7F) | (indexVar.global << 7));
     }
 }
 
-inline void generate_code(const ArgVariant& varg, CodeGenerator& codegen)
+inline void generate_code(const CompiledArg& arg, CodeGenerator& codegen)
 {
-    return visit_one(varg, [&](const auto& arg) { return ::generate_code(arg, codegen); });
+    switch(arg.type)
+    {
+        case CompiledArg::Type::EOAL:
+            return generate_code(EOAL{}, codegen);
+        case CompiledArg::Type::Int8:
+            return generate_code(static_cast<int8_t>(arg.integer()), codegen);
+        case CompiledArg::Type::Int16:
+            return generate_code(static_cast<int16_t>(arg.integer()), codegen);
+        case CompiledArg::Type::Int32:
+            return generate_code(arg.integer(), codegen);
+        case CompiledArg::Type::Float:
+            return generate_code(arg.floating(), codegen);
+        case CompiledArg::Type::Label:
+            return generate_label(arg.a, codegen);
+        case CompiledArg::Type::Model:
+            return generate_model(arg, codegen);
+        case CompiledArg::Type::Var:
+        case CompiledArg::Type::VarArrayConst:
+        case CompiledArg::Type::VarArrayVar:
+            return generate_var(arg, codegen);
+        case CompiledArg::Type::TextLabel8:
+        case CompiledArg::Type::TextLabel16:
+        case CompiledArg::Type::String128:
+        case CompiledArg::Type::StringVar:
+            return generate_string(arg, codegen);
+        default:
+            Unreachable();
+    }
 }
 
-inline void generate_code(const CompiledCommand& ccmd, CodeGenerator& codegen)
+inline void generate_command(const CompiledIR::Instr& instr, CodeGenerator& codegen)
 {
     optional<uint16_t> opcode;
 
     if(codegen.oatc)
-        opcode = codegen.oatc->find_opcode(ccmd.command);
+        opcode = codegen.oatc->find_opcode(*instr.command);
 
     if(opcode == nullopt)
-        opcode = ccmd.command.id;
+        opcode = instr.command->id;
 
     if(opcode == nullopt)
-        codegen.program.fatal_error(nocontext, "could not compile command {}, no id or no hash [-moatc]", ccmd.command.name);
+        codegen.program.fatal_error(nocontext, "could not compile command {}, no id or no hash [-moatc]", instr.command->name);
 
-    codegen.bw.emplace_u16(*opcode | (ccmd.not_flag? 0x8000 : 0x0000));
-    for(auto& arg : ccmd.args) ::generate_code(arg, codegen);
-}
+    codegen.bw.emplace_u16(*opcode | (instr.not_flag? 0x8000 : 0x0000));
 
-inline void generate_code(const CompiledLabelDef&, CodeGenerator&)
-{
-    // label definitions do not have a physical representation
-}
-
-inline void generate_code(const CompiledHex& hex, CodeGenerator& codegen)
-{
-    codegen.bw.emplace_bytes(hex.data.size(), hex.data.data());
+    auto args = codegen.ir().args_of(instr);
+    for(uint32_t i = 0; i < instr.count; ++i)
+        ::generate_code(args[i], codegen);
 }
 
 static void generate_skipper(CodeGeneratorData& codegen, int32_t skip_bytes, bool force_global_offset)//+8 +12
@@ -523,7 +540,6 @@ inline void generate_code(const CompiledScmHeader& header, CodeGeneratorData& co
     uint32_t multifile_size       = 0;
     uint32_t largest_mission_size = 0;
     uint32_t largest_streamed_size = 0;
-    uint32_t maximum_mission_local = 0;
 
     std::vector<shared_ptr<const Script>> missions;
     std::vector<shared_ptr<const Script>> streameds;
@@ -548,9 +564,6 @@ inline void generate_code(const CompiledScmHeader& header, CodeGeneratorData& co
             multifile_size += sc_full_size;
             if(largest_mission_size < sc_full_size)
                 largest_mission_size = sc_full_size;
-
-            auto pair = sc->find_maximum_locals();
-            maximum_mission_local = std::max({maximum_mission_local, pair.first, pair.second});
         }
         else if(sc->type == ScriptType::StreamedScript)
         {
@@ -593,7 +606,7 @@ inline void generate_code(const CompiledScmHeader& header, CodeGeneratorData& co
 
         if(header.version == CompiledScmHeader::Version::SanAndreas)
         {
-            codegen.bw.emplace_u32(maximum_mission_local);
+            codegen.bw.emplace_u32(header.maximum_mission_local);
         }
 
         for(auto& script_ptr : missions)
@@ -673,8 +686,3 @@ inline void CustomHeaderOATC::generate_code(CodeGeneratorData& codegen) const
         codegen.bw.emplace_bytes(name.size() + 1, name.c_str());
     }
 }
-
-inline void generate_code(const CompiledData& data, CodeGenerator& codegen)
-{
-    return visit_one(data.data, [&](const auto& data) { return ::generate_code(data, codegen); });
-}
@@ -11,6 +11,51 @@
 
 class CustomHeaderOATC;
 
+/// A reference to a label, whose value depends on where the scripts are placed in the output.
+///
+/// Code is generated before the scripts are placed, thus label references are recorded as relocations and patched
+/// once every script size is known. When emitting a relocatable object (`Options::emit_object`), they are left for
+/// the link step instead.
+struct Relocation
+{
+    enum class Kind : uint8_t
+    {
+        Absolute,           //< The global offset of the label.
+        NegatedAbsolute,    //< The global offset of the label, negated (i.e. -mlocal-offsets).
+        NegatedLocal,       //< The offset of the label relative to the base of its root script, negated.
+    };
+
+    Kind                kind;
+    uint32_t            offset;     //< Where the 32-bit value goes, relative to the script code.
+    LabelId             label;      //< May be local to the script this relocation is in (see `CompiledIR`).
+
+    /// Computes the value to be placed at `offset`, given the global offset of the label and the `Script::base` of
+    /// the root script of the script this relocation is in.
+    int32_t resolve(uint32_t label_offset, uint32_t root_base, ProgramContext& program) const;
+
+    /// Places the resolved value into `code`, the code of the script this relocation is in.
+    void apply(void* code, uint32_t label_offset, uint32_t root_base, ProgramContext& program) const;
+};
+
+/// A reference to a global variable or to a model, whose value is assigned by the link step.
+///
+/// Only recorded when emitting a relocatable object (`Options::emit_object`), since otherwise the global variables
+/// and the models header are known by the time code is generated.
+struct SymbolReference
+{
+    enum class Kind : uint8_t
+    {
+        GlobalVar,          //< The 16-bit offset of the global variable whose id is `target`, plus `addend`.
+        Model,              //< The model whose usage index in the script is `target` (see `Script::used_models`).
+    };
+
+    Kind                kind;
+    uint8_t             size;       //< Size of the value, in bytes.
+    uint32_t            offset;     //< Where the value goes, relative to the script code.
+    uint32_t            target;
+    int32_t             addend;
+};
+
 /// Converts intermediate representation (given by `CompilerContext`) into SCM bytecode.
 class CodeGenerator
 {
@@ -18,30 +63,21 @@ public:
     ProgramContext&                 program;
     BinaryWriter                    bw;
     const shared_ptr<const Script>  script;
+    SymTable&                       symbols;
     const CustomHeaderOATC*         oatc; // may be null for nullopt
+    std::vector<Relocation>         relocations; //< Label references in the generated code.
+    std::vector<SymbolReference>    symbol_references; //< Global variable and model references, see `SymbolReference`.
 
 private:
-    std::vector<CompiledData>       compiled;
+    CompiledIR                      compiled;
+    std::vector<uint32_t>           local_labels;   //< Positions of the labels local to `compiled`.
 
 public:
-    explicit CodeGenerator(shared_ptr<const Script> script_, std::vector<CompiledData>&& compiled, ProgramContext& program) :
-        program(program), script(std::move(script_)), compiled(std::move(compiled)), oatc(nullptr)
+    explicit CodeGenerator(shared_ptr<const Script> script_, CompiledIR&& compiled, SymTable& symbols, ProgramContext& program) :
+        program(program), script(std::move(script_)), symbols(symbols), compiled(std::move(compiled)), oatc(nullptr)
     {
     }
 
-    explicit CodeGenerator(CompilerContext&& context, ProgramContext& program) : // consumes the context
-        CodeGenerator(std::move(context.script), std::move(context).get_data(), program)
-    {}
-
-    /// Finds the `Label::local_offsets` for all labels that are inside this script.
-    ///
-    /// \returns the size of this script.
-    ///
-    /// \warning This method is not thread-safe because it modifies states! It modifies label objects which may be
-    /// in use by other code generation units.
-    ///
-    uint32_t compute_labels();
-
     /// Assigns an OATC lookup to this code generator.
     ///
     /// \warning reference to header must be alive as long as this object.
@@ -49,8 +85,22 @@ public:
     /// \warning This method is not thread-safe.
     void set_oatc(const CustomHeaderOATC& oatc) { this->oatc = std::addressof(oatc); }
 
-    /// Generates the code.
-    void generate();
+    /// Generates the code in a single pass, finding the position of the labels inside this script (for the labels
+    /// of the symbol table, their `Label::code_position`) and recording the label references into `relocations`.
+    ///
+    /// \returns the size of this script.
+    ///
+    /// Units may generate code concurrently, since the labels of other units are only read by `relocate_into`.
+    uint32_t generate();
+
+    /// Copies the generated code into `output`, resolving its label references.
+    ///
+    /// The scripts and labels must already be placed (see `Script::compute_script_offsets` and
+    /// `SymTable::compute_label_offsets`).
+    void relocate_into(void* output) const;
+
+    /// \returns the script the generated `label` is in, and its position relative to the code of such script.
+    std::pair<const Script*, uint32_t> label_position(LabelId label) const;
     
     /// Gets the resulting buffer of the generation.
     const void* buffer() const { return this->bw.buffer(); }
@@ -59,7 +109,7 @@ public:
     size_t buffer_size() const { return this->bw.buffer_size(); }
 
     ///
-    const std::vector<CompiledData>& ir() const { return this->compiled; };
+    const CompiledIR& ir() const { return this->compiled; };
 };
 
 /// Converts intermediate of pure-data things (such as the SCM header) into a bytecode.
@@ -83,8 +133,9 @@ public:
         program(program), compiled(compiled), script(std::move(script)), script_offset(script_offset)
     {}
 
-    /// Generates the data.
-    void generate();
+    /// Generates the data into a buffer of its own, or straight into `output` if it isn't null, in which case
+    /// `output` must have room for the `compiled_size()` of the header and stay alive as long as this object.
+    void generate(void* output = nullptr);
 
     /// Gets the resulting buffer of the generation.
     const void* buffer() const { return this->bw.buffer(); }
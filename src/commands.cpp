@@ -23,12 +23,29 @@ Commands::Commands(transparent_set<Command>&& commands_,
     this->enum_defaultmodels = it_defaultmodel->second;
     this->enum_scriptstream = it_scriptstream->second;
     
+    this->commands_by_id.resize(0x8000);
+    this->commands_by_atom.reserve(this->commands.size());
+
     for(auto& cmd : this->commands)
     {
         if(cmd.id)
-            this->commands_by_id.emplace(*cmd.id, std::addressof(cmd));
+        {
+            auto& by_id = this->commands_by_id[*cmd.id & 0x7FFF];
+            if(by_id == nullptr || (by_id->extension && !cmd.extension))
+                by_id = std::addressof(cmd);
+        }
+        if(cmd.hash)
+            this->commands_by_hash.emplace(*cmd.hash, std::addressof(cmd));
+        this->commands_by_atom.emplace(Atom::intern(cmd.name), std::addressof(cmd));
+    }
+
+    for(auto& alt : this->alternators)
+    {
+        this->alternators_by_atom.emplace(Atom::intern(alt.first), std::addressof(alt.second));
     }
 
+    this->index_constants();
+
     this->set_progress_total            = find_command("SET_PROGRESS_TOTAL");
     this->set_total_number_of_missions  = find_command("SET_TOTAL_NUMBER_OF_MISSIONS");
     this->set_collectable1_total        = find_command("SET_COLLECTABLE1_TOTAL");
@@ -94,65 +111,111 @@ void Commands::add_default_models(const insensitive_map<std::string, uint32_t>&
 {
     for(auto& model_pair : default_models)
     {
-        this->enum_defaultmodels->values.emplace(model_pair);
+        this->enum_defaultmodels->add(model_pair.first, model_pair.second);
     }
+    this->index_constants();
 }
 
-optional<int32_t> Commands::find_constant(const string_view& value, bool context_free_only) const
+void Commands::index_constants()
 {
-    for(auto& enum_pair : enums)
+    size_t num_values = 0;
+    for(auto& enum_pair : this->enums)
+        num_values += enum_pair.second->values.size();
+
+    this->constants_by_atom.clear();
+    this->constants_by_atom.reserve(num_values);
+
+    // The order of `enums` decides which value wins when many enums have the same identifier.
+    for(auto& enum_pair : this->enums)
     {
-        if(enum_pair.second->is_global == context_free_only)
+        const Enum& e = *enum_pair.second;
+        const bool is_defaultmodel = (enum_pair.second == this->enum_defaultmodels);
+
+        for(auto& value_pair : e.values)
         {
-            if(auto opt = enum_pair.second->find(value))
-                return opt;
+            ConstantEntry& entry = this->constants_by_atom[value_pair.first];
+            entry.values.emplace_back(&e, value_pair.second);
+
+            if(!entry.any || is_defaultmodel) // see find_constant_all
+                entry.any = value_pair.second;
+            if(is_defaultmodel)
+                entry.defaultmodel = value_pair.second;
+            if(e.is_global && !entry.global)
+                entry.global = value_pair.second;
+            if(!e.is_global && !entry.contextual)
+                entry.contextual = value_pair.second;
         }
     }
+}
+
+optional<int32_t> Commands::find_constant(const string_view& value, bool context_free_only) const
+{
+    if(auto atom = Atom::find(value))
+        return this->find_constant(atom, context_free_only);
+    return nullopt;
+}
+
+optional<int32_t> Commands::find_constant(Atom value, bool context_free_only) const
+{
+    if(auto entry = this->find_constant_entry(value))
+        return context_free_only? entry->global : entry->contextual;
     return nullopt;
 }
 
 optional<int32_t> Commands::find_constant_all(const string_view& value) const
 {
-    // See https://github.com/thelink2012/gta3sc/issues/60
-    if(auto opt = enum_defaultmodels->find(value))
-        return opt;
+    if(auto atom = Atom::find(value))
+        return this->find_constant_all(atom);
+    return nullopt;
+}
 
-    for(auto& enum_pair : enums)
-    {
-        if(&enum_pair.second == &enum_defaultmodels)
-            continue;
-        if(auto opt = enum_pair.second->find(value))
-            return opt;
-    }
+optional<int32_t> Commands::find_constant_all(Atom value) const
+{
+    // DEFAULTMODEL takes precedence over the other enums.
+    // See https://github.com/thelink2012/gta3sc/issues/60
+    if(auto entry = this->find_constant_entry(value))
+        return entry->any;
     return nullopt;
 }
 
 optional<int32_t> Commands::find_constant_for_arg(const string_view& value, const Command::Arg& arg) const
 {
+    if(auto atom = Atom::find(value))
+        return this->find_constant_for_arg(atom, arg);
+    return nullopt;
+}
+
+optional<int32_t> Commands::find_constant_for_arg(Atom value, const Command::Arg& arg) const
+{
+    auto entry = this->find_constant_entry(value);
+    if(entry == nullptr)
+        return nullopt;
+
     if(arg.type == ArgType::Constant)
     {
-        if(auto opt_const = this->find_constant_all(value))
-            return opt_const;
+        if(entry->any)
+            return entry->any;
     }
     else
     {
-        if(auto opt_const = arg.find_constant(value)) // constants stricly related to this Arg
-            return opt_const;
+        // constants stricly related to this Arg
+        for(auto& e : arg.enums)
+        {
+            for(auto& value_pair : entry->values)
+            {
+                if(value_pair.first == e.get())
+                    return value_pair.second;
+            }
+        }
     }
 
     // If the enum that the argument accepts is MODEL, and the above didn't find a match,
     // also try on the DEFAULTMODEL enum.
-    if(arg.uses_enum(this->enum_models))
-    {
-        if(auto opt_const = enum_defaultmodels->find(value))
-            return opt_const;
-    }
+    if(entry->defaultmodel && arg.uses_enum(this->enum_models))
+        return entry->defaultmodel;
 
     if(arg.type != ArgType::Constant)
-    {
-        if(auto opt_const = this->find_constant(value, true)) // global constants
-            return opt_const;
-    }
+        return entry->global; // global constants
 
     return nullopt;
 }
@@ -197,7 +260,7 @@ static auto args_from_tree(const SyntaxTree& cmdnode) -> T
     output.reserve(cmdnode.child_count() - 1);
 
     for(auto it = std::next(cmdnode.begin()); it != cmdnode.end(); ++it)
-        output.emplace_back(it->get());
+        output.emplace_back(*it);
 
     return output;
 }
@@ -242,7 +305,7 @@ static auto make_expected_error(const shared_ptr<const SyntaxTree>& hint,
 
 static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTree>& hint,
                       int32_t arg, const Command::Arg& arginfo, const SymTable& symtable,
-                      const shared_ptr<Scope>& scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
+                      const Scope* scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
 {
     if(!arginfo.allow_constant)
         return make_unexpected(MatchFailure{ hint, MatchFailure::LiteralValueDisallowed });
@@ -253,7 +316,7 @@ static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTre
 
 static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTree>& hint,
                       float arg, const Command::Arg& arginfo, const SymTable& symtable,
-                      const shared_ptr<Scope>& scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
+                      const Scope* scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
 {
     if(!arginfo.allow_constant)
         return make_unexpected(MatchFailure{ hint, MatchFailure::LiteralValueDisallowed });
@@ -264,9 +327,9 @@ static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTre
 
 static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTree>& hint,
                       const TagVar& arg, const Command::Arg& arginfo, const SymTable& symtable,
-                      const shared_ptr<Scope>& scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
+                      const Scope* scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
 {
-    auto var_matches = [](const shared_ptr<Var>& var, const Command::Arg& arginfo) -> bool
+    auto var_matches = [](const Var* var, const Command::Arg& arginfo) -> bool
     {
         switch(var->type)
         {
@@ -377,7 +440,7 @@ static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTre
 
 static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTree>& hint,
                       string_view text, const Command::Arg& arginfo, const SymTable& symtable,
-                      const shared_ptr<Scope>& scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
+                      const Scope* scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
 {
     switch(arginfo.type)
     {
@@ -468,7 +531,7 @@ static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTre
 
 static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTree>& hint,
                       const SyntaxTree& arg, const Command::Arg& arginfo, const SymTable& symtable,
-                      const shared_ptr<Scope>& scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
+                      const Scope* scope_ptr, const Options& options) -> expected<const Command::Arg*, MatchFailure>
 {
     switch(arg.type())
     {
@@ -490,9 +553,9 @@ static auto match_arg(const Commands& commands, const shared_ptr<const SyntaxTre
 }
 
 auto Commands::match(const SyntaxTree& cmdnode, const SymTable& symtable,
-                     const shared_ptr<Scope>& scope_ptr, const Options& options) const -> expected<const Command*, MatchFailure>
+                     const Scope* scope_ptr, const Options& options) const -> expected<const Command*, MatchFailure>
 {
-    auto command_name = cmdnode.child(0).text();
+    auto command_name = cmdnode.child(0).atom();
 
     if(auto opt_alternator = this->find_alternator(command_name))
     {
@@ -509,19 +572,19 @@ auto Commands::match(const SyntaxTree& cmdnode, const SymTable& symtable,
 }
 
 auto Commands::match(const Alternator& alternator, const SyntaxTree& cmdnode, const SymTable& symtable,
-                     const shared_ptr<Scope>& scope_ptr, const Options& options) const -> expected<const Command*, MatchFailure>
+                     const Scope* scope_ptr, const Options& options) const -> expected<const Command*, MatchFailure>
 {
     return this->match(alternator, cmdnode, args_from_tree<MatchArgumentList>(cmdnode), symtable, scope_ptr, options);
 }
 
 auto Commands::match(const Command& command, const SyntaxTree& cmdnode, const SymTable& symtable,
-                     const shared_ptr<Scope>& scope_ptr, const Options& options) const -> expected<const Command*, MatchFailure>
+                     const Scope* scope_ptr, const Options& options) const -> expected<const Command*, MatchFailure>
 {
     return this->match(command, cmdnode, args_from_tree<MatchArgumentList>(cmdnode), symtable, scope_ptr, options);
 }
 
 auto Commands::match(const Alternator& alternator, optional<const SyntaxTree&> cmdnode, const MatchArgumentList& args,
-                     const SymTable& symtable, const shared_ptr<Scope>& scope_ptr, const Options& options) const
+                     const SymTable& symtable, const Scope* scope_ptr, const Options& options) const
                                                                                                 -> expected<const Command*, MatchFailure>
 {
     for(auto& cmd : alternator)
@@ -533,7 +596,7 @@ auto Commands::match(const Alternator& alternator, optional<const SyntaxTree&> c
 }
 
 auto Commands::match(const Command& command, optional<const SyntaxTree&> cmdnode, const MatchArgumentList& args,
-                     const SymTable& symtable, const shared_ptr<Scope>& scope_ptr, const Options& options) const
+                     const SymTable& symtable, const Scope* scope_ptr, const Options& options) const
                                                                                                -> expected<const Command*, MatchFailure>
 {
     size_t i = 0;
@@ -584,14 +647,14 @@ auto Commands::match(const Command& command, optional<const SyntaxTree&> cmdnode
 }
 
 void Commands::annotate(SyntaxTree& cmdnode, const Command& command,
-                        const SymTable& symtable, const shared_ptr<Scope>& scope_ptr,
+                        const SymTable& symtable, const Scope* scope_ptr,
                         Script& script, ProgramContext& program) const
 {
     return this->annotate(args_from_tree<AnnotateArgumentList>(cmdnode), command, symtable, scope_ptr, script, program);
 }
 
 void Commands::annotate(const AnnotateArgumentList& args, const Command& command,
-                        const SymTable& symtable, const shared_ptr<Scope>& scope_ptr,
+                        const SymTable& symtable, const Scope* scope_ptr,
                         Script& script, ProgramContext& program) const
 {
     // Expects all args to match command.args!
@@ -645,7 +708,7 @@ void Commands::annotate(const AnnotateArgumentList& args, const Command& command
         else
         {
             if(node.is_annotated())
-                assert(node.maybe_annotation<const shared_ptr<Var>&>());
+                assert(node.maybe_annotation<Var*>());
             else
                 node.set_annotation(annotation.base);
         }
@@ -739,9 +802,9 @@ void Commands::annotate(const AnnotateArgumentList& args, const Command& command
                 if(arginfo.type == ArgType::Label)
                 {
                     if(node.is_annotated())
-                        assert(node.maybe_annotation<const shared_ptr<Label>&>());
+                        assert(node.maybe_annotation<Label*>());
                     else
-                        node.set_annotation(symtable.find_label(node.text()).value());
+                        node.set_annotation(symtable.find_label(node.atom()).value());
                 }
                 else if(arginfo.type == ArgType::TextLabel
                      || arginfo.type == ArgType::TextLabel16
@@ -771,7 +834,7 @@ void Commands::annotate(const AnnotateArgumentList& args, const Command& command
 
                     if(arginfo.type == ArgType::Integer || arginfo.type == ArgType::Float)
                     {
-                        if(auto opt_const = symtable.find_constant(node.text()))
+                        if(auto opt_const = symtable.find_constant(node.atom()))
                         {
                             if(node.is_annotated())
                                 assert(arginfo.type == ArgType::Integer?
@@ -21,14 +21,36 @@ using EntityType = uint16_t;
 /// Stores constant values associated with a identifiers.
 struct Enum
 {
-    insensitive_map<std::string, int32_t> values;
+    atom_map<int32_t> values;
+    atom_map<std::string> names;    //< The spelling each of the `values` was defined with.
     bool is_global = false;
 
-    explicit Enum(insensitive_map<std::string, int32_t> values, bool is_global) :
-        values(std::move(values)), is_global(is_global)
+    explicit Enum(bool is_global) :
+        is_global(is_global)
     {}
 
+    /// Adds the constant `name`, unless this enum has a constant of such name already.
+    void add(const string_view& name, int32_t value)
+    {
+        auto it = values.emplace(Atom::intern(name), value);
+        if(it.second)
+            names.emplace(it.first->first, name.to_string());
+    }
+
+    /// Gets the spelling the constant `value` was defined with.
+    const std::string& name_of(Atom value) const
+    {
+        return names.at(value);
+    }
+
     optional<int32_t> find(const string_view& value) const
+    {
+        if(auto atom = Atom::find(value))
+            return this->find(atom);
+        return nullopt;
+    }
+
+    optional<int32_t> find(Atom value) const
     {
         auto it = values.find(value);
         if(it != values.end())
@@ -67,6 +89,14 @@ struct Command
 
         /// Finds a constant associated with the enums of this argument.
         ::optional<int32_t> find_constant(const string_view& value) const
+        {
+            if(auto atom = Atom::find(value))
+                return this->find_constant(atom);
+            return nullopt;
+        }
+
+        /// Finds a constant associated with the enums of this argument.
+        ::optional<int32_t> find_constant(Atom value) const
         {
             for(auto& e : enums)
             {
@@ -210,6 +240,30 @@ public:
     static Commands from_xml(const std::string& config_name, const std::vector<fs::path>& xml_list);
     // TODO ^ make the paths of xml_list absolute? i.e. move modifies to outside?
 
+    /// Gets the path `from_xml` reads the XML file `xml_path` from.
+    static fs::path config_file_path(const std::string& config_name, const fs::path& xml_path);
+
+    /// Gets the default path of the precompiled configuration of the XML files in `xml_list`, which is in the cache
+    /// directory of the user (see `user_cache_path`).
+    static fs::path cache_file_path(const std::string& config_name, const std::vector<fs::path>& xml_list);
+
+    /// Loads the precompiled configuration `cache_file`, written by `write_cache`.
+    ///
+    /// \returns `nullopt` if the file is missing, corrupt, of another version, or if it was
+    /// built from XML files different (in path or content) than the ones in `xml_list`.
+    ///
+    /// The contents of a XML file are only hashed if its size or last write time changed.
+    static optional<Commands> from_cache(const fs::path& cache_file,
+                                         const std::string& config_name, const std::vector<fs::path>& xml_list);
+
+    /// Writes a precompiled configuration of these commands, which were read from `xml_list`, into `cache_file`.
+    ///
+    /// Must be called before any change made to the commands after `from_xml` (e.g. `add_default_models`).
+    /// Stale precompiled configurations next to `cache_file` are removed.
+    /// \returns whether the file was written.
+    bool write_cache(const fs::path& cache_file,
+                     const std::string& config_name, const std::vector<fs::path>& xml_list) const;
+
     /// Adds the default models associated with the program context into the DEFAULTMODEL enum.
     void add_default_models(const insensitive_map<std::string, uint32_t>&);
 
@@ -223,31 +277,34 @@ public:
     const shared_ptr<Enum>& get_scriptstream_enum() const { return this->enum_scriptstream; }
 
     // Argument matching methods.
-    expected<const Command*, MatchFailure> match(const SyntaxTree& cmdnode, const SymTable&, const shared_ptr<Scope>&, const Options&) const;
-    expected<const Command*, MatchFailure> match(const Command&, const SyntaxTree& cmdnode, const SymTable&, const shared_ptr<Scope>&, const Options&) const;
-    expected<const Command*, MatchFailure> match(const Alternator&, const SyntaxTree& cmdnode, const SymTable&, const shared_ptr<Scope>&, const Options&) const;
+    expected<const Command*, MatchFailure> match(const SyntaxTree& cmdnode, const SymTable&, const Scope*, const Options&) const;
+    expected<const Command*, MatchFailure> match(const Command&, const SyntaxTree& cmdnode, const SymTable&, const Scope*, const Options&) const;
+    expected<const Command*, MatchFailure> match(const Alternator&, const SyntaxTree& cmdnode, const SymTable&, const Scope*, const Options&) const;
     expected<const Command*, MatchFailure> match(const Command&, optional<const SyntaxTree&> cmdnode, const MatchArgumentList& args,
-                                                 const SymTable&, const shared_ptr<Scope>&, const Options&) const;
+                                                 const SymTable&, const Scope*, const Options&) const;
     expected<const Command*, MatchFailure> match(const Alternator&, optional<const SyntaxTree&> cmdnode, const MatchArgumentList& args,
-                                                 const SymTable&, const shared_ptr<Scope>&, const Options&) const;
+                                                 const SymTable&, const Scope*, const Options&) const;
 
     // Syntax tree annotation methods.
-    void annotate(SyntaxTree&, const Command&, const SymTable&, const shared_ptr<Scope>&, Script&, ProgramContext&) const;
-    void annotate(const AnnotateArgumentList&, const Command&, const SymTable&, const shared_ptr<Scope>&, Script&, ProgramContext&) const;
+    void annotate(SyntaxTree&, const Command&, const SymTable&, const Scope*, Script&, ProgramContext&) const;
+    void annotate(const AnnotateArgumentList&, const Command&, const SymTable&, const Scope*, Script&, ProgramContext&) const;
 
     /// Finds the integer value of the string constant `value`.
     ///
     /// The `context_free_only` is whether we only search for constants that can be used in 
     ///any occasion or  constants that can be used only in specific commands arguments.
     optional<int32_t> find_constant(const string_view& value, bool context_free_only) const;
+    optional<int32_t> find_constant(Atom value, bool context_free_only) const;
 
     /// Finds the integer value of a string constant 'value'.
     ///
     /// This version searches for all enums in order to allow CONST type arguments.
     optional<int32_t> find_constant_all(const string_view& value) const;
+    optional<int32_t> find_constant_all(Atom value) const;
 
     /// Finds the integer value of a string constant `value` assuming we're handling the argument `arg`.
     optional<int32_t> find_constant_for_arg(const string_view& value, const Command::Arg& arg) const;
+    optional<int32_t> find_constant_for_arg(Atom value, const Command::Arg& arg) const;
 
     /// Finds the name of the entity assigned to the id `type`.
     optional<std::string> find_entity_name(EntityType type) const;
@@ -255,40 +312,59 @@ public:
     /// Find a command based on its name.
     optional<const Command&> find_command(string_view name) const
     {
-        auto it = this->commands.find(name);
-        if(it != this->commands.end())
-            return *it;
+        if(auto atom = Atom::find(name))
+            return this->find_command(atom);
+        return nullopt;
+    }
+
+    /// Find a command based on its interned name.
+    optional<const Command&> find_command(Atom name) const
+    {
+        auto it = this->commands_by_atom.find(name);
+        if(it != this->commands_by_atom.end())
+            return *it->second;
         return nullopt;
     }
 
-    /// Find a command based on its hash.
+    /// Find a command based on its hash, or on its name if there's one.
     optional<const Command&> find_command(uint32_t hash, optional<string_view> name) const
     {
         if(name) return this->find_command(*name);
-        // TODO lookup by hash.
+
+        auto it = this->commands_by_hash.find(hash);
+        if(it != this->commands_by_hash.end())
+            return *it->second;
         return nullopt;
     }
 
     /// Finds a alternator based on its name.
     optional<const Alternator&> find_alternator(string_view name) const
     {
-        auto it = this->alternators.find(name);
-        if(it != this->alternators.end())
-            return it->second;
+        if(auto atom = Atom::find(name))
+            return this->find_alternator(atom);
+        return nullopt;
+    }
+
+    /// Finds a alternator based on its interned name.
+    optional<const Alternator&> find_alternator(Atom name) const
+    {
+        auto it = this->alternators_by_atom.find(name);
+        if(it != this->alternators_by_atom.end())
+            return *it->second;
         return nullopt;
     }
 
     /// Find a command based on its id.
+    ///
+    /// If many commands share the same id, gives the first (in name order) which is not an extension,
+    /// or the first one if all of them are extensions.
     optional<const Command&> find_command(uint16_t id) const
     {
-        auto range = this->commands_by_id.equal_range(id);
-        for(auto it = range.first; it != range.second; ++it)
+        if(id < this->commands_by_id.size())
         {
-            if(!it->second->extension)
-                return *it->second;
+            if(auto ptr = this->commands_by_id[id])
+                return *ptr;
         }
-        if(range.first != range.second)
-            return *range.first->second;
         return nullopt;
     }
 
@@ -320,12 +396,37 @@ public:
         return false;
     }
 
+private:
+    /// Every enum value named by some identifier, in the order of `enums`.
+    struct ConstantEntry
+    {
+        optional<int32_t> any;          //< Value found by `find_constant_all`.
+        optional<int32_t> global;       //< Value in the first global enum.
+        optional<int32_t> contextual;   //< Value in the first non-global enum.
+        optional<int32_t> defaultmodel; //< Value in the DEFAULTMODEL enum.
+        small_vector<std::pair<const Enum*, int32_t>, 2> values;
+    };
+
+    /// Builds `constants_by_atom` from the enums.
+    void index_constants();
+
+    /// Finds the index entry of the identifier `value`, if any enum has it.
+    const ConstantEntry* find_constant_entry(Atom value) const
+    {
+        auto it = this->constants_by_atom.find(value);
+        return it != this->constants_by_atom.end()? &it->second : nullptr;
+    }
+
 private:
     transparent_set<Command> commands;
     insensitive_map<std::string, std::vector<const Command*>> alternators;
-    std::multimap<uint16_t, const Command*> commands_by_id;
+    std::vector<const Command*> commands_by_id;                  //< Indexed by id, from 0x0000 to 0x7FFF.
+    flat_hash_map<uint32_t, const Command*> commands_by_hash;
+    atom_map<const Command*> commands_by_atom;
+    atom_map<const Alternator*> alternators_by_atom;
     transparent_map<std::string, shared_ptr<Enum>> enums;
     transparent_map<std::string, EntityType> entities;
+    atom_map<ConstantEntry> constants_by_atom;
 
     shared_ptr<Enum> enum_models;
     shared_ptr<Enum> enum_defaultmodels;
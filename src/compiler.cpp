@@ -5,21 +5,21 @@
 #include "program.hpp"
 
 template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
-static ArgVariant conv_int(T integral)
+static CompiledArg conv_int(T integral)
 {
     int32_t i = static_cast<int32_t>(integral);
 
     if(i >= std::numeric_limits<int8_t>::min() && i <= std::numeric_limits<int8_t>::max())
-        return int8_t(i);
+        return CompiledArg::i8(int8_t(i));
     else if(i >= std::numeric_limits<int16_t>::min() && i <= std::numeric_limits<int16_t>::max())
-        return int16_t(i);
+        return CompiledArg::i16(int16_t(i));
     else
-        return int32_t(i);
+        return CompiledArg::i32(int32_t(i));
 }
 
 void CompilerContext::compile()
 {
-    Expects(compiled.empty());
+    Expects(compiled.instrs.empty());
     Expects(script->top_label->code_position == nullopt);
     Expects(script->start_label->code_position == nullopt);
 
@@ -27,39 +27,56 @@ void CompilerContext::compile()
     program.supported_or_fatal(nocontext, commands.goto_, "GOTO");
     program.supported_or_fatal(nocontext, commands.goto_if_false, "GOTO_IF_FALSE");
 
-    compile_label(script->top_label);
-    compile_label(script->start_label);
+    compile_label(script->top_label->id);
+    compile_label(script->start_label->id);
     return compile_statements(*script->tree);
 }
 
-shared_ptr<Label> CompilerContext::make_internal_label()
+LabelId CompilerContext::make_internal_label()
 {
-    this->internal_labels.emplace_back(std::make_shared<Label>(this->current_scope, this->script));
-    return this->internal_labels.back();
+    return this->compiled.first_local_label + this->compiled.num_local_labels++;
 }
 
 void CompilerContext::compile_label(const SyntaxTree& label_node)
 {
-    return compile_label(label_node.annotation<shared_ptr<Label>>());
+    return compile_label(label_node.annotation<Label*>()->id);
 }
 
-void CompilerContext::compile_label(shared_ptr<Label> label_ptr)
+void CompilerContext::compile_label(LabelId label)
 {
-    this->compiled.emplace_back(std::move(label_ptr));
+    CompiledIR::Instr instr;
+    instr.op = CompiledIR::Op::LabelDef;
+    instr.first = label;
+    this->compiled.instrs.emplace_back(instr);
 }
 
-void CompilerContext::compile_command(const Command& command, ArgList args, bool not_flag)
+void CompilerContext::compile_command(const Command& command, std::initializer_list<CompiledArg> args, bool not_flag)
+{
+    auto first_arg = this->compiled.args.size();
+    this->compiled.args.insert(this->compiled.args.end(), args.begin(), args.end());
+    return compile_command_args(command, first_arg, not_flag);
+}
+
+void CompilerContext::compile_command_args(const Command& command, size_t first_arg, bool not_flag)
 {
     if(command.extension && program.opt.pedantic)
         program.pedantic(this->script, "use of command {} which is a language extension [-pedantic]", command.name);
 
+    auto& args = this->compiled.args;
+
     if(command.has_optional())
     {
-        assert(args.size() == 0 || !is<EOAL>(args.back()));
-        args.emplace_back(EOAL{});
+        assert(args.size() == first_arg || args.back().type != CompiledArg::Type::EOAL);
+        args.emplace_back(CompiledArg::eoal());
     }
 
-    this->compiled.emplace_back(CompiledCommand{ not_flag, command, std::move(args) });
+    CompiledIR::Instr instr;
+    instr.op = CompiledIR::Op::Command;
+    instr.not_flag = not_flag;
+    instr.command = &command;
+    instr.first = static_cast<uint32_t>(first_arg);
+    instr.count = static_cast<uint32_t>(args.size() - first_arg);
+    this->compiled.instrs.emplace_back(instr);
 }
 
 void CompilerContext::compile_command(const SyntaxTree& command_node, bool not_flag)
@@ -74,10 +91,14 @@ void CompilerContext::compile_command(const SyntaxTree& command_node, bool not_f
 
         if(commands.equal(command, commands.skip_cutscene_start_internal))
         {
-            this->label_skip_cutscene_end = any_cast<shared_ptr<Label>>(opt_annot->params[0]);
+            // placed just before the matching SKIP_CUTSCENE_END.
+            this->label_skip_cutscene_end = make_internal_label();
+            compile_command(command, { CompiledArg::label(*this->label_skip_cutscene_end) });
+        }
+        else
+        {
+            compile_command_args(command, get_args(opt_annot->command, opt_annot->params));
         }
-
-        compile_command(command, get_args(opt_annot->command, opt_annot->params));
     }
     else
     {
@@ -85,18 +106,18 @@ void CompilerContext::compile_command(const SyntaxTree& command_node, bool not_f
 
         if(commands.equal(command, commands.skip_cutscene_end) && this->label_skip_cutscene_end)
         {
-            compile_label(this->label_skip_cutscene_end);
-            this->label_skip_cutscene_end = nullptr;
+            compile_label(*this->label_skip_cutscene_end);
+            this->label_skip_cutscene_end = nullopt;
         }
 
-        compile_command(command, get_args(command, command_node), not_flag);
+        compile_command_args(command, get_args(command, command_node), not_flag);
     }
 }
 
 void CompilerContext::compile_statements(const SyntaxTree& base)
 {
     for(auto it = base.begin(); it != base.end(); ++it)
-        compile_statement(*it->get());
+        compile_statement(**it);
 }
 
 void CompilerContext::compile_statements(const SyntaxTree& parent, size_t from_id, size_t to_id_including)
@@ -186,7 +207,15 @@ void CompilerContext::compile_statement(const SyntaxTree& node, bool not_flag)
 
 void CompilerContext::compile_dump(const SyntaxTree& node)
 {
-    this->compiled.emplace_back(node.annotation<DumpAnnotation>().bytes);
+    auto& bytes = node.annotation<const DumpAnnotation&>().bytes;
+
+    CompiledIR::Instr instr;
+    instr.op = CompiledIR::Op::Hex;
+    instr.first = static_cast<uint32_t>(this->compiled.bytes.size());
+    instr.count = static_cast<uint32_t>(bytes.size());
+    this->compiled.instrs.emplace_back(instr);
+
+    this->compiled.bytes.insert(this->compiled.bytes.end(), bytes.begin(), bytes.end());
 }
 
 void CompilerContext::compile_scope(const SyntaxTree& scope_node)
@@ -196,7 +225,7 @@ void CompilerContext::compile_scope(const SyntaxTree& scope_node)
     });
 
     Expects(this->current_scope == nullptr);
-    this->current_scope = scope_node.annotation<shared_ptr<Scope>>();
+    this->current_scope = scope_node.annotation<Scope*>();
     compile_statements(scope_node.child(0));
 }
 
@@ -208,7 +237,7 @@ void CompilerContext::compile_if(const SyntaxTree& if_node)
         auto end_ptr  = make_internal_label();
         compile_conditions(if_node.child(0), else_ptr);
         compile_statements(if_node.child(1));
-        compile_command(*this->commands.goto_, { end_ptr });
+        compile_command(*this->commands.goto_, { CompiledArg::label(end_ptr) });
         compile_label(else_ptr);
         compile_statements(if_node.child(2));
         compile_label(end_ptr);
@@ -232,7 +261,7 @@ void CompilerContext::compile_while(const SyntaxTree& while_node)
     compile_label(beg_ptr);
     compile_conditions(while_node.child(0), end_ptr);
     compile_statements(while_node.child(1));
-    compile_command(*this->commands.goto_, { beg_ptr });
+    compile_command(*this->commands.goto_, { CompiledArg::label(beg_ptr) });
     compile_label(end_ptr);
 
     loop_stack.pop_back();
@@ -256,7 +285,7 @@ void CompilerContext::compile_repeat(const SyntaxTree& repeat_node)
     compile_label(continue_ptr);
     compile_command(annotation.add_var_with_one, { get_arg(var), get_arg(annotation.number_one) });
     compile_command(annotation.is_var_geq_times, { get_arg(var), get_arg(times) });
-    compile_command(*this->commands.goto_if_false, { loop_ptr });
+    compile_command(*this->commands.goto_if_false, { CompiledArg::label(loop_ptr) });
     compile_label(break_ptr);
 
     loop_stack.pop_back();
@@ -264,7 +293,7 @@ void CompilerContext::compile_repeat(const SyntaxTree& repeat_node)
 
 void CompilerContext::compile_switch(const SyntaxTree& switch_node)
 {
-    auto continue_ptr = nullptr;
+    auto continue_ptr = nullopt;
     auto break_ptr = make_internal_label();
 
     loop_stack.emplace_back(LoopInfo{ continue_ptr, break_ptr });
@@ -355,7 +384,7 @@ void CompilerContext::compile_switch(const SyntaxTree& switch_node)
     loop_stack.pop_back();
 }
 
-void CompilerContext::compile_switch_withop(const SyntaxTree& swnode, std::vector<Case>& cases, shared_ptr<Label> break_ptr)
+void CompilerContext::compile_switch_withop(const SyntaxTree& swnode, std::vector<Case>& cases, LabelId break_ptr)
 {
     std::vector<Case*> sorted_cases;   // does not contain default, unlike `cases`
     sorted_cases.resize(cases.size());
@@ -385,8 +414,8 @@ void CompilerContext::compile_switch_withop(const SyntaxTree& swnode, std::vecto
 
     for(size_t i = 0; i < sorted_cases.size(); )
     {
-        std::vector<ArgVariant> args;
-        args.reserve(18);
+        auto first_arg = this->compiled.args.size();
+        auto& args = this->compiled.args;
 
         const Command& switch_op = (i == 0? switch_start : switch_continued);
         size_t max_cases_here    = (i == 0? 7 : 9);
@@ -396,7 +425,7 @@ void CompilerContext::compile_switch_withop(const SyntaxTree& swnode, std::vecto
             args.emplace_back(get_arg(swnode.child(0)));
             args.emplace_back(conv_int(sorted_cases.size()));
             args.emplace_back(conv_int(has_default));
-            args.emplace_back(has_default? case_default->target : break_ptr);
+            args.emplace_back(CompiledArg::label(has_default? *case_default->target : break_ptr));
         }
 
         for(size_t k = 0; k < max_cases_here; ++k, ++i)
@@ -404,21 +433,21 @@ void CompilerContext::compile_switch_withop(const SyntaxTree& swnode, std::vecto
             if(i < sorted_cases.size())
             {
                 args.emplace_back(conv_int(*sorted_cases[i]->value));
-                args.emplace_back(sorted_cases[i]->target);
+                args.emplace_back(CompiledArg::label(*sorted_cases[i]->target));
             }
             else
             {
                 args.emplace_back(conv_int(-1));
-                args.emplace_back(break_ptr);
+                args.emplace_back(CompiledArg::label(break_ptr));
             }
         }
 
-        compile_command(switch_op, std::move(args));
+        compile_command_args(switch_op, first_arg);
     }
 
     for(auto it = cases.begin(); it != cases.end(); ++it)
     {
-        compile_label(it->target);
+        compile_label(*it->target);
         if(std::next(it) == cases.end() || !std::next(it)->same_body_as(*it))
         {
             compile_statements(swnode.child(1), it->first_statement_id, it->last_statement_id);
@@ -428,7 +457,7 @@ void CompilerContext::compile_switch_withop(const SyntaxTree& swnode, std::vecto
     compile_label(break_ptr);
 }
 
-void CompilerContext::compile_switch_ifchain(const SyntaxTree& swnode, std::vector<Case>& cases, shared_ptr<Label> break_ptr)
+void CompilerContext::compile_switch_ifchain(const SyntaxTree& swnode, std::vector<Case>& cases, LabelId break_ptr)
 {
     Case* default_case = nullptr;
 
@@ -466,7 +495,7 @@ void CompilerContext::compile_switch_ifchain(const SyntaxTree& swnode, std::vect
             else
                 default_case = std::addressof(*k);
         }
-        if(num_ifs) compile_command(*commands.goto_if_false, { next_ptr });
+        if(num_ifs) compile_command(*commands.goto_if_false, { CompiledArg::label(next_ptr) });
 
         compile_label(body_ptr);
         std::for_each(it, next_it, [&](Case& c) { c.target = body_ptr; });
@@ -478,12 +507,12 @@ void CompilerContext::compile_switch_ifchain(const SyntaxTree& swnode, std::vect
     {
         if(default_case->target)
         {
-            compile_command(*commands.goto_, { default_case->target });
+            compile_command(*commands.goto_, { CompiledArg::label(*default_case->target) });
         }
         else
         {
             default_case->target = make_internal_label();
-            compile_label(default_case->target);
+            compile_label(*default_case->target);
             compile_statements(swnode.child(1), default_case->first_statement_id, default_case->last_statement_id);
         }
     }
@@ -497,7 +526,7 @@ void CompilerContext::compile_break(const SyntaxTree& break_node)
     {
         if(it->break_label)
         {
-            compile_command(*commands.goto_, { it->break_label });
+            compile_command(*commands.goto_, { CompiledArg::label(*it->break_label) });
             return;
         }
     }
@@ -510,7 +539,7 @@ void CompilerContext::compile_continue(const SyntaxTree& continue_node)
     {
         if(it->continue_label)
         {
-            compile_command(*commands.goto_, { it->continue_label });
+            compile_command(*commands.goto_, { CompiledArg::label(*it->continue_label) });
             return;
         }
     }
@@ -598,7 +627,7 @@ void CompilerContext::compile_condition(const SyntaxTree& node, bool not_flag)
     }
 }
 
-void CompilerContext::compile_conditions(const SyntaxTree& conds_node, const shared_ptr<Label>& else_ptr)
+void CompilerContext::compile_conditions(const SyntaxTree& conds_node, LabelId else_ptr)
 {
     auto compile_multi_andor = [this](const auto& conds_node, size_t op)
     {
@@ -631,56 +660,51 @@ void CompilerContext::compile_conditions(const SyntaxTree& conds_node, const sha
             Unreachable();
     }
 
-    compile_command(*this->commands.goto_if_false, { else_ptr });
+    compile_command(*this->commands.goto_if_false, { CompiledArg::label(else_ptr) });
 }
 
-auto CompilerContext::get_args(const Command& command, const std::vector<any>& params) -> ArgList
+size_t CompilerContext::get_args(const Command& command, const small_vector<Commands::MatchArgument, 1>& params)
 {
-    ArgList args;
-    args.reserve(params.size());
+    auto first_arg = this->compiled.args.size();
 
     for(auto& p : params)
-        args.emplace_back(get_arg(p));
+        this->compiled.args.emplace_back(get_arg(p));
 
-    return args;
+    return first_arg;
 }
 
-auto CompilerContext::get_args(const Command& command, const SyntaxTree& command_node) -> ArgList
+size_t CompilerContext::get_args(const Command& command, const SyntaxTree& command_node)
 {
     Expects(command_node.child_count() >= 1); // command_name + [args...]
 
-    ArgList args;
-    args.reserve(command_node.child_count() - 1);
+    auto first_arg = this->compiled.args.size();
 
     for(auto it = std::next(command_node.begin()); it != command_node.end(); ++it)
-        args.emplace_back( get_arg(**it) );
+        this->compiled.args.emplace_back(get_arg(**it));
 
-    return args;
+    return first_arg;
 }
 
-ArgVariant CompilerContext::get_arg(const Commands::MatchArgument& a)
+CompiledArg CompilerContext::get_arg(const Commands::MatchArgument& a)
 {
     if(is<int32_t>(a))
         return conv_int(get<int32_t>(a));
     else if(is<float>(a))
-        return get<float>(a);
+        return CompiledArg::flt(get<float>(a));
     else
         return get_arg(*get<const SyntaxTree*>(a));
 }
 
-ArgVariant CompilerContext::get_arg(const any& param)
+CompiledArg CompilerContext::get_string_arg(CompiledArg::Type type, bool preserve_case, const std::string& string)
 {
-    if(auto opt = any_cast<int32_t>(&param))
-        return conv_int(*opt);
-    else if(auto opt = any_cast<float>(&param))
-        return *opt;
-    else if(auto opt = any_cast<shared_ptr<Label>>(&param))
-        return std::move(*opt);
-    else
-        Unreachable(); // implement more on necessity
+    CompiledArg arg { type, preserve_case };
+    arg.a = static_cast<uint32_t>(this->compiled.strings.size());
+    arg.b = static_cast<uint32_t>(string.size());
+    this->compiled.strings.append(string.c_str(), string.size() + 1);
+    return arg;
 }
 
-ArgVariant CompilerContext::get_arg(const SyntaxTree& arg_node)
+CompiledArg CompilerContext::get_arg(const SyntaxTree& arg_node)
 {
     switch(arg_node.type())
     {
@@ -691,7 +715,7 @@ ArgVariant CompilerContext::get_arg(const SyntaxTree& arg_node)
 
         case NodeType::Float:
         {
-            return arg_node.annotation<float>();
+            return CompiledArg::flt(arg_node.annotation<float>());
         }
 
         case NodeType::Text:
@@ -702,29 +726,29 @@ ArgVariant CompilerContext::get_arg(const SyntaxTree& arg_node)
             }
             else if(auto opt_flt = arg_node.maybe_annotation<float>())
             {
-                return *opt_flt;
+                return CompiledArg::flt(*opt_flt);
             }
-            else if(auto opt_var = arg_node.maybe_annotation<shared_ptr<Var>>())
+            else if(auto opt_var = arg_node.maybe_annotation<Var*>())
             {
-                return CompiledVar{ std::move(*opt_var), nullopt };
+                return CompiledArg::var((*opt_var)->id);
             }
             else if(auto opt_var = arg_node.maybe_annotation<const ArrayAnnotation&>())
             {
-                if(is<shared_ptr<Var>>(opt_var->index))
-                    return CompiledVar { opt_var->base, get<shared_ptr<Var>>(opt_var->index) };
+                if(is<Var*>(opt_var->index))
+                    return CompiledArg::var_array_var(opt_var->base->id, get<Var*>(opt_var->index)->id);
                 else
-                    return CompiledVar { opt_var->base, get<int32_t>(opt_var->index) };
+                    return CompiledArg::var_array(opt_var->base->id, get<int32_t>(opt_var->index));
             }
-            else if(auto opt_label = arg_node.maybe_annotation<shared_ptr<Label>>())
+            else if(auto opt_label = arg_node.maybe_annotation<Label*>())
             {
-                auto label = std::move(*opt_label);
+                auto label = *opt_label;
                 if(!label->may_branch_from(*this->script, program))
                 {
-                    auto sckind_ = to_string(label->script.lock()->type);
+                    auto sckind_ = to_string(label->script->type);
                     program.error(arg_node, "reference to local label outside of its {} script", sckind_);
-                    program.note(*label->script.lock(), "label belongs to this script");
+                    program.note(*label->script, "label belongs to this script");
                 }
-                return label;
+                return CompiledArg::label(label->id);
             }
             else if(auto opt_text = arg_node.maybe_annotation<const TextLabelAnnotation&>())
             {
@@ -732,14 +756,14 @@ ArgVariant CompilerContext::get_arg(const SyntaxTree& arg_node)
                 if(program.opt.warn_conflict_text_label_var && symbols.find_var(opt_text->string, this->current_scope))
                     program.warning(arg_node, "text label collides with some variable name");
 
-                auto type = opt_text->is_varlen? CompiledString::Type::StringVar : CompiledString::Type::TextLabel8;
-                return CompiledString{ type, opt_text->preserve_case, opt_text->string };
+                auto type = opt_text->is_varlen? CompiledArg::Type::StringVar : CompiledArg::Type::TextLabel8;
+                return get_string_arg(type, opt_text->preserve_case, opt_text->string);
             }
             else if(auto opt_umodel = arg_node.maybe_annotation<const ModelAnnotation&>())
             {
-                assert(opt_umodel->where.expired() == false);
-                int32_t i32 = opt_umodel->where.lock()->find_model_at(opt_umodel->id);
-                return conv_int(i32);
+                assert(opt_umodel->where.lock() == this->script);
+                int32_t i32 = this->script->find_model_at(opt_umodel->id);
+                return CompiledArg::model(i32, opt_umodel->id);
             }
             else
             {
@@ -752,12 +776,12 @@ ArgVariant CompilerContext::get_arg(const SyntaxTree& arg_node)
         {
             if(auto opt_text = arg_node.maybe_annotation<const TextLabelAnnotation&>())
             {
-                auto type = opt_text->is_varlen? CompiledString::Type::StringVar : CompiledString::Type::TextLabel8;
-                return CompiledString{ type, opt_text->preserve_case, opt_text->string };
+                auto type = opt_text->is_varlen? CompiledArg::Type::StringVar : CompiledArg::Type::TextLabel8;
+                return get_string_arg(type, opt_text->preserve_case, opt_text->string);
             }
             else if(auto opt_buffer = arg_node.maybe_annotation<const String128Annotation&>())
             {
-                return CompiledString { CompiledString::Type::String128, false, opt_buffer->string };
+                return get_string_arg(CompiledArg::Type::String128, false, opt_buffer->string);
             }
             else
             {
@@ -771,11 +795,16 @@ ArgVariant CompilerContext::get_arg(const SyntaxTree& arg_node)
     }
 }
 
-bool CompilerContext::is_same_var(const ArgVariant& lhs, const ArgVariant& rhs)
+bool CompilerContext::is_same_var(const CompiledArg& lhs, const CompiledArg& rhs)
 {
-    if(is<CompiledVar>(lhs) && is<CompiledVar>(rhs))
+    // variables are given a single id each, thus the same variable (or array element) compares equal.
+    switch(lhs.type)
     {
-        return get<CompiledVar>(lhs) == get<CompiledVar>(rhs);
+        case CompiledArg::Type::Var:
+        case CompiledArg::Type::VarArrayConst:
+        case CompiledArg::Type::VarArrayVar:
+            return lhs == rhs;
+        default:
+            return false;
     }
-    return false;
 }
@@ -10,78 +10,130 @@
 #include <stdinc.h>
 #include "program.hpp"
 
-/// IR for variable / array.
-struct CompiledVar
+/// IR for a single argument of a command.
+///
+/// Arguments are packed into a small trivially copyable record, referencing labels and variables by id and
+/// strings by their position in the string arena of the `CompiledIR` they belong to.
+struct CompiledArg
 {
-    shared_ptr<Var>                             var;
-    optional<variant<int32_t, shared_ptr<Var>>> index;
-
-    explicit CompiledVar(shared_ptr<Var> var, nullopt_t)
-        : var(std::move(var)), index(nullopt)
-    {}
-
-    explicit CompiledVar(shared_ptr<Var> var, int32_t index)
-        : var(std::move(var)), index(index)
-    {}
+    enum class Type : uint8_t
+    {
+        EOAL,
+        Int8,
+        Int16,
+        Int32,
+        Float,
+        Label,          //< `a` is the id of the label.
+        Model,          //< `a` is the value of the model, `b` its usage index in the script (see `Script::used_models`).
+        Var,            //< `a` is the id of the variable.
+        VarArrayConst,  //< `a` is the id of the array, `b` the (constant) index.
+        VarArrayVar,    //< `a` is the id of the array, `b` the id of the index variable.
+        TextLabel8,     //< `a` is the offset of the string in the arena, `b` its length.
+        TextLabel16,    //< Same as `TextLabel8`.
+        String128,      //< Same as `TextLabel8`.
+        StringVar,      //< Same as `TextLabel8`.
+    };
 
-    explicit CompiledVar(shared_ptr<Var> var, shared_ptr<Var> index)
-        : var(std::move(var)), index(std::move(index))
-    {}
+    Type        type;
+    bool        preserve_case = false;  //< For strings.
+    uint32_t    a = 0;
+    uint32_t    b = 0;
+
+    static CompiledArg eoal()                   { return CompiledArg { Type::EOAL }; }
+    static CompiledArg i8(int8_t value)         { return CompiledArg { Type::Int8, false, uint32_t(int32_t(value)) }; }
+    static CompiledArg i16(int16_t value)       { return CompiledArg { Type::Int16, false, uint32_t(int32_t(value)) }; }
+    static CompiledArg i32(int32_t value)       { return CompiledArg { Type::Int32, false, uint32_t(value) }; }
+    static CompiledArg label(LabelId label)     { return CompiledArg { Type::Label, false, label }; }
+    static CompiledArg model(int32_t value, uint32_t usage) { return CompiledArg { Type::Model, false, uint32_t(value), usage }; }
+    static CompiledArg var(VarId var)           { return CompiledArg { Type::Var, false, var }; }
+
+    static CompiledArg flt(float value)
+    {
+        static_assert(sizeof(float) == sizeof(uint32_t), "32 bits floating point expected.");
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return CompiledArg { Type::Float, false, bits };
+    }
 
-    bool operator==(const CompiledVar& rhs) const
+    static CompiledArg var_array(VarId var, int32_t index)
     {
-        return this->var == rhs.var && this->index == rhs.index;
+        return CompiledArg { Type::VarArrayConst, false, var, uint32_t(index) };
     }
-};
 
-/// IR for strings, no matter if it's a fixed size (8/16/128 bytes) or var length.
-struct CompiledString
-{
-    enum class Type : uint8_t
+    static CompiledArg var_array_var(VarId var, VarId index)
     {
-        TextLabel8,
-        TextLabel16,
-        String128,
-        StringVar,
-    };
+        return CompiledArg { Type::VarArrayVar, false, var, index };
+    }
 
-    Type        type;
-    bool        preserve_case;
-    std::string storage;
-};
+    /// \returns the value of a integer argument.
+    int32_t integer() const     { return int32_t(this->a); }
 
-/// IR for a single argument of a command.
-using ArgVariant = variant<EOAL, int8_t, int16_t, int32_t, float, shared_ptr<Label>, CompiledVar, CompiledString>;
+    /// \returns the value of a float argument.
+    float floating() const
+    {
+        float value;
+        std::memcpy(&value, &this->a, sizeof(value));
+        return value;
+    }
 
-/// IR for a single command plus its arguments.
-struct CompiledCommand
-{
-    bool                    not_flag;
-    const Command&          command;
-    std::vector<ArgVariant> args;
+    bool is_string() const      { return this->type >= Type::TextLabel8; }
+
+    bool operator==(const CompiledArg& rhs) const
+    {
+        return this->type == rhs.type && this->preserve_case == rhs.preserve_case
+            && this->a == rhs.a && this->b == rhs.b;
+    }
 };
 
-/// IR for label **definitions**.
+/// IR of a script.
+///
+/// A stream of pseudo-instructions whose arguments are packed into a single buffer, instead of a heap object
+/// per instruction and argument. Labels and variables are referenced by their id in the `SymTable`, and every
+/// string is pooled into one arena.
 ///
-/// This is just a helper to find out where the labels are.
-struct CompiledLabelDef
+/// The labels made up by the compiler (e.g. to branch around an IF) are local to this IR, and are given the ids
+/// from `first_local_label` onwards, i.e. past the labels of the symbol table.
+struct CompiledIR
 {
-    shared_ptr<Label> label;
+    enum class Op : uint8_t
+    {
+        Command,        //< A command, `first` is the index of its first argument and `count` the number of them.
+        LabelDef,       //< A label definition (no physical representation), `first` is the label id.
+        Hex,            //< Raw bytes, `first` is their offset in `bytes` and `count` the number of them.
+    };
 
-    size_t compiled_size() const
+    struct Instr
     {
-        return 0;
+        Op              op;
+        bool            not_flag = false;
+        const Command*  command = nullptr;
+        uint32_t        first = 0;
+        uint32_t        count = 0;
+    };
+
+    std::vector<Instr>              instrs;
+    std::vector<CompiledArg>        args;
+    std::string                     strings;    //< Arena of the string arguments, each one null-terminated.
+    std::vector<uint8_t>            bytes;      //< Arena of the raw bytes.
+    LabelId                         first_local_label = 0;
+    uint32_t                        num_local_labels = 0;
+
+    /// \returns whether `label` is local to this IR, instead of a label of the symbol table.
+    bool is_local_label(LabelId label) const
+    {
+        return label >= this->first_local_label;
     }
-};
 
-/// IR for HEX data.
-struct CompiledHex
-{
-    std::vector<uint8_t> data;
+    /// \returns the arguments of the command `instr`.
+    const CompiledArg* args_of(const Instr& instr) const
+    {
+        return this->args.data() + instr.first;
+    }
 
-    size_t compiled_size() const
+    /// \returns the characters of the string argument `arg`.
+    const char* string(const CompiledArg& arg) const
     {
-        return data.size();
+        return this->strings.data() + arg.a;
     }
 };
 
@@ -101,14 +153,17 @@ struct CompiledScmHeader
     std::vector<shared_ptr<const Script>> base_scripts;             //< All non-require scripts being compiled into the multifile/script.img.
     uint32_t                              num_missions;             //< Number of missions.
     uint32_t                              num_streamed;             //< Number of streamed scripts.
+    uint32_t                              maximum_mission_local;    //< Highest local variable index used by missions.
 
     explicit CompiledScmHeader(Version version, size_t size_globals,
                                std::vector<std::string> models_,
-                               const std::vector<shared_ptr<Script>>& scripts) :
+                               const std::vector<shared_ptr<Script>>& scripts,
+                               uint32_t maximum_mission_local) :
         version(version),
         size_global_vars_space(std::max(size_t(8), size_globals)),
         models(std::move(models_)),
-        num_missions(0), num_streamed(0)
+        num_missions(0), num_streamed(0),
+        maximum_mission_local(maximum_mission_local)
     {
         this->base_scripts.reserve(scripts.size());
         for(auto& sc : scripts)
@@ -129,46 +184,27 @@ struct CompiledScmHeader
     size_t compiled_size() const;
 };
 
-/// IR for a fundamental piece of compiled data. May be a label or a command.
-struct CompiledData
-{
-    variant<CompiledLabelDef, CompiledCommand, CompiledHex> data;
-
-    CompiledData(CompiledCommand x)
-        : data(std::move(x))
-    {}
-
-    CompiledData(std::vector<uint8_t> x)
-        : data(CompiledHex { std::move(x) })
-    {}
-
-    CompiledData(shared_ptr<Label> x)
-        : data(CompiledLabelDef{ std::move(x) })
-    {}
-};
-
 /// Transforms an annotated syntax tree into a intermediate representation (vector of pseudo-instructions).
 class CompilerContext
 {
 private:
     struct LoopInfo
     {
-        shared_ptr<Label> continue_label;   //< Where a CONTINUE should jump into (may be nullptr).
-        shared_ptr<Label> break_label;      //< Where a BREAK should jump into
+        optional<LabelId> continue_label;   //< Where a CONTINUE should jump into (may be nullopt).
+        optional<LabelId> break_label;      //< Where a BREAK should jump into
     };
 
     // Helpers
-    shared_ptr<Scope>              current_scope;
-    std::vector<shared_ptr<Label>> internal_labels;
+    const Scope*                   current_scope = nullptr;
     std::vector<LoopInfo>          loop_stack;
-    shared_ptr<Label>              label_skip_cutscene_end;
+    optional<LabelId>              label_skip_cutscene_end;
 
     // Inputs
     ProgramContext&                 program;
     const Commands&                 commands;
     
     // Output
-    std::vector<CompiledData>       compiled;
+    CompiledIR                      compiled;
 
 public:
     // Inputs
@@ -180,6 +216,7 @@ public:
         : script(std::move(script)), symbols(symbols), commands(program.commands), program(program)
     {
         this->loop_stack.reserve(16);
+        this->compiled.first_local_label = symbols.num_labels();
     }
 
     static auto compile(shared_ptr<const Script> script, const SymTable& symbols, ProgramContext& program) -> CompilerContext
@@ -193,18 +230,17 @@ public:
     void compile();
 
     /// Gets the result of `compile`.
-    const std::vector<CompiledData>& get_data() const& { return this->compiled; }
-    std::vector<CompiledData>& get_data() &            { return this->compiled; }
-    std::vector<CompiledData> get_data() &&            { return std::move(this->compiled); }
+    const CompiledIR& get_data() const& { return this->compiled; }
+    CompiledIR& get_data() &            { return this->compiled; }
+    CompiledIR get_data() &&            { return std::move(this->compiled); }
 
 private:
 
-    using ArgList = std::vector<ArgVariant>;
-
     struct Case;
     struct LoopInfo;
 
-    shared_ptr<Label> make_internal_label();
+    /// Makes up a label local to this script, see `CompiledIR::first_local_label`.
+    LabelId make_internal_label();
 
     void compile_statements(const SyntaxTree& parent, size_t from_id, size_t to_id_including);
 
@@ -214,9 +250,12 @@ private:
 
     void compile_label(const SyntaxTree& label_node);
 
-    void compile_label(shared_ptr<Label> label_ptr);
+    void compile_label(LabelId label);
+
+    void compile_command(const Command& command, std::initializer_list<CompiledArg> args, bool not_flag = false);
 
-    void compile_command(const Command& command, ArgList args, bool not_flag = false);
+    /// Compiles a command whose arguments were appended to `compiled.args` starting at `first_arg`.
+    void compile_command_args(const Command& command, size_t first_arg, bool not_flag = false);
 
     void compile_command(const SyntaxTree& command_node, bool not_flag = false);
 
@@ -232,9 +271,9 @@ private:
 
     // \warning mutates `cases`.
     // \warning expects no repeated Cases.
-    void compile_switch_withop(const SyntaxTree& swnode, std::vector<Case>& cases, shared_ptr<Label> break_ptr);
+    void compile_switch_withop(const SyntaxTree& swnode, std::vector<Case>& cases, LabelId break_ptr);
 
-    void compile_switch_ifchain(const SyntaxTree& swnode, std::vector<Case>& cases, shared_ptr<Label> break_ptr);
+    void compile_switch_ifchain(const SyntaxTree& swnode, std::vector<Case>& cases, LabelId break_ptr);
 
     void compile_break(const SyntaxTree& break_node);
 
@@ -248,30 +287,32 @@ private:
 
     void compile_condition(const SyntaxTree& node, bool not_flag = false);
 
-    void compile_conditions(const SyntaxTree& conds_node, const shared_ptr<Label>& else_ptr);
+    void compile_conditions(const SyntaxTree& conds_node, LabelId else_ptr);
 
     void compile_dump(const SyntaxTree& node);
 
 private:
 
-    ArgList get_args(const Command& command, const SyntaxTree& command_node);
+    /// Appends the arguments to `compiled.args`, returning the index of the first one.
+    size_t get_args(const Command& command, const SyntaxTree& command_node);
 
-    ArgList get_args(const Command& command, const std::vector<any>& params);
+    /// Appends the arguments to `compiled.args`, returning the index of the first one.
+    size_t get_args(const Command& command, const small_vector<Commands::MatchArgument, 1>& params);
 
-    ArgVariant get_arg(const Commands::MatchArgument& a);
+    CompiledArg get_arg(const Commands::MatchArgument& a);
 
-    ArgVariant get_arg(const SyntaxTree& arg_node);
+    CompiledArg get_arg(const SyntaxTree& arg_node);
 
-    ArgVariant get_arg(const any& param);
+    CompiledArg get_string_arg(CompiledArg::Type type, bool preserve_case, const std::string& string);
 
-    bool is_same_var(const ArgVariant& lhs, const ArgVariant& rhs);
+    bool is_same_var(const CompiledArg& lhs, const CompiledArg& rhs);
 
 private:
     /// Helper for the SWITCH statement.
     struct Case
     {
         optional<int32_t>            value;
-        shared_ptr<Label>            target;
+        optional<LabelId>            target;
         optional<const Command*>     is_var_eq_int;
         size_t                       first_statement_id = SIZE_MAX;
         size_t                       last_statement_id = SIZE_MAX;
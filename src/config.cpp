@@ -2,6 +2,7 @@
 #include "commands.hpp"
 #include "program.hpp"
 #include "system.hpp"
+#include "builtin_config.hpp"
 #include <rapidxml.hpp>
 #include <rapidxml_utils.hpp>
 
@@ -85,6 +86,31 @@ static ArgType xml_to_argtype(const char* string)
         throw ConfigError("unexpected 'Type' attribute: {}", string);
 }
 
+static Enum& find_or_add_enum(transparent_map<std::string, shared_ptr<Enum>>& enums, const char* name, bool is_global)
+{
+    auto eit = enums.find(name);
+    if(eit == enums.end())
+    {
+        auto enum_ptr = std::make_shared<Enum>(is_global);
+        eit = enums.emplace(name, std::move(enum_ptr)).first;
+    }
+    else
+    {
+        assert(is_global == eit->second->is_global);
+    }
+    return *eit->second;
+}
+
+static void insert_command(transparent_set<Command>& commands, Command command)
+{
+    auto insert_pair = commands.insert(std::move(command));
+    if(!insert_pair.second)
+    {
+        commands.erase(insert_pair.first);
+        insert_pair = commands.insert(std::move(command));
+    }
+}
+
 static void parse_enum_node(transparent_map<std::string, shared_ptr<Enum>>& enums, const rapidxml::xml_node<>* enum_node)
 {
     using namespace rapidxml;
@@ -96,18 +122,7 @@ static void parse_enum_node(transparent_map<std::string, shared_ptr<Enum>>& enum
         throw ConfigError("missing 'Name' attribute on '<Enum>' node");
 
     bool is_global = xml_to_bool(enum_global_attrib, false);
-    auto eit = enums.find(enum_name_attrib->value());
-    if(eit == enums.end())
-    {
-        auto enum_ptr = std::make_shared<Enum>(Enum { {}, is_global });
-        eit = enums.emplace(enum_name_attrib->value(), std::move(enum_ptr)).first;
-    }
-    else
-    {
-        assert(is_global == eit->second->is_global);
-    }
-
-    insensitive_map<std::string, int32_t>& constant_map = eit->second->values;
+    Enum& constant_enum = find_or_add_enum(enums, enum_name_attrib->value(), is_global);
     int32_t current_value = 0;
 
     for(auto value_node = enum_node->first_node(); value_node; value_node = value_node->next_sibling())
@@ -123,7 +138,7 @@ static void parse_enum_node(transparent_map<std::string, shared_ptr<Enum>>& enum
         if(value_value_attrib)
             current_value = xml_stoi(value_value_attrib->value());
 
-        constant_map.emplace(value_name_attrib->value(), current_value);
+        constant_enum.add(value_name_attrib->value(), current_value);
 
         ++current_value;
     }
@@ -270,6 +285,108 @@ static void
     }
 }
 
+static void load_builtin_enums(transparent_map<std::string, shared_ptr<Enum>>& enums, const BuiltinXml& xml)
+{
+    for(size_t i = 0; i < xml.num_enums; ++i)
+    {
+        auto& builtin_enum = xml.enums[i];
+        Enum& constant_enum = find_or_add_enum(enums, builtin_enum.name, builtin_enum.is_global);
+
+        for(size_t k = 0; k < builtin_enum.num_constants; ++k)
+        {
+            auto& constant = xml.constants[builtin_enum.first_constant + k];
+            constant_enum.add(constant.name, constant.value);
+        }
+    }
+}
+
+static void
+  load_builtin_commands(
+      transparent_set<Command>& commands,
+      transparent_map<std::string, EntityType>& entities,
+      const transparent_map<std::string, shared_ptr<Enum>>& enums,
+      const BuiltinXml& xml)
+{
+    for(size_t i = 0; i < xml.num_commands; ++i)
+    {
+        auto& builtin_command = xml.commands[i];
+
+        decltype(Command::args) args;
+        args.reserve(builtin_command.num_args);
+
+        for(size_t k = 0; k < builtin_command.num_args; ++k)
+        {
+            auto& builtin_arg = xml.args[builtin_command.first_arg + k];
+
+            Command::Arg arg;
+            arg.type = builtin_arg.type;
+            decode_arg_flags(arg, builtin_arg.flags);
+            arg.entity_type = 0;
+
+            if(builtin_arg.enum_name)
+            {
+                auto eit = enums.find(builtin_arg.enum_name);
+                if(eit != enums.end())
+                {
+                    arg.enums.emplace_back(eit->second);
+                    arg.enums.shrink_to_fit();
+                }
+            }
+
+            if(builtin_arg.entity)
+            {
+                auto it = entities.emplace(builtin_arg.entity, EntityType(1 + entities.size())).first;
+                arg.entity_type = it->second;
+            }
+
+            args.emplace_back(std::move(arg));
+        }
+
+        insert_command(commands, Command {
+            (builtin_command.flags & CMD_SUPPORTED) != 0,
+            (builtin_command.flags & CMD_INTERNAL) != 0,
+            (builtin_command.flags & CMD_EXTENSION) != 0,
+            (builtin_command.flags & CMD_HAS_ID)? optional<uint16_t>(builtin_command.id) : nullopt,
+            (builtin_command.flags & CMD_HAS_HASH)? optional<uint32_t>(builtin_command.hash) : nullopt,
+            std::move(args),
+            builtin_command.name,
+        });
+    }
+}
+
+static void
+  load_builtin_alternators(
+      insensitive_map<std::string, std::vector<const Command*>>& alternators,
+      const transparent_set<Command>& commands,
+      const BuiltinXml& xml)
+{
+    for(size_t i = 0; i < xml.num_alternators; ++i)
+    {
+        auto& builtin_alternator = xml.alternators[i];
+        auto& alternatives = alternators[builtin_alternator.name];
+
+        for(size_t k = 0; k < builtin_alternator.num_alternatives; ++k)
+        {
+            auto it = commands.find(xml.alternatives[builtin_alternator.first_alternative + k]);
+            if(it != commands.end())
+                alternatives.emplace_back(std::addressof(*it));
+        }
+    }
+}
+
+fs::path Commands::config_file_path(const std::string& config_name, const fs::path& xml_path)
+{
+    if(!xml_path.is_absolute())
+    {
+        auto begin = xml_path.begin();
+        if(begin != xml_path.end() && (*begin == "." || *begin == ".."))
+            return xml_path;
+        else
+            return config_path() / config_name / xml_path;
+    }
+    return xml_path;
+}
+
 Commands Commands::from_xml(const std::string& config_name, const std::vector<fs::path>& xml_list)
 {
     using namespace rapidxml;
@@ -285,8 +402,15 @@ Commands Commands::from_xml(const std::string& config_name, const std::vector<fs
         std::unique_ptr<xml_document<>> doc;
     };
 
+    struct XmlSection
+    {
+        int                 type;
+        xml_node<>*         node;       //< The section in a parsed XML file...
+        const BuiltinXml*   builtin;    //< ...or the bundled file it comes from.
+    };
+
     std::vector<XmlData> xml_vector;
-    std::vector<std::pair<int, xml_node<>*>> xml_sections;
+    std::vector<XmlSection> xml_sections;
 
     transparent_set<Command>                                    commands;
     insensitive_map<std::string, std::vector<const Command*>>   alternators;
@@ -294,53 +418,43 @@ Commands Commands::from_xml(const std::string& config_name, const std::vector<fs
     transparent_map<std::string, shared_ptr<Enum>>              enums;
 
     // fundamental enums
-    enums.emplace("MODEL", std::make_shared<Enum>(Enum { {}, false, }));
-    enums.emplace("DEFAULTMODEL", std::make_shared<Enum>(Enum { {}, false, }));
-    enums.emplace("SCRIPTSTREAM", std::make_shared<Enum>(Enum { {}, false, }));
+    enums.emplace("MODEL", std::make_shared<Enum>(false));
+    enums.emplace("DEFAULTMODEL", std::make_shared<Enum>(false));
+    enums.emplace("SCRIPTSTREAM", std::make_shared<Enum>(false));
 
-    auto xml_parse = [](const fs::path& path) -> XmlData
+    auto xml_parse = [](const fs::path& full_xml_path, std::string buffer) -> XmlData
     {
-        fs::path full_xml_path(path);
         try
         {
-            auto opt_buffer = read_file_utf8(full_xml_path);
-            if(opt_buffer == nullopt)
-                throw ConfigError("failed to read xml {}: {}", full_xml_path.generic_u8string(), "could not open file for reading");
-
             auto doc = std::make_unique<xml_document<>>(); // buffer should be alive as long as doc
-            doc->parse<0>(&(*opt_buffer)[0]); // buffer will get modified here
+            doc->parse<0>(&buffer[0]); // buffer will get modified here
 
-            return XmlData{ std::move(*opt_buffer), std::move(doc) };
+            return XmlData{ std::move(buffer), std::move(doc) };
         }
         catch(const rapidxml::parse_error& e)
         {
             throw ConfigError("failed to parse xml {}: {}", full_xml_path.generic_u8string(), e.what());
         }
-        catch(const bad_optional_access& e)
-        {
-            throw ConfigError("failed to read xml {}: {}", full_xml_path.generic_u8string(), e.what());
-        }
     };
 
     for(auto& xml_path : xml_list)
     {
-        fs::path path;
+        auto path = config_file_path(config_name, xml_path);
+
+        auto opt_buffer = read_file_utf8(path);
+        if(opt_buffer == nullopt)
+            throw ConfigError("failed to read xml {}: {}", path.generic_u8string(), "could not open file for reading");
+
+        // The bundled files need no parsing, their contents were translated into tables at build time.
+        if(auto builtin = BuiltinXml::find(opt_buffer->data(), opt_buffer->size()))
         {
-            if(!xml_path.is_absolute())
-            {
-                auto begin = xml_path.begin();
-                if(begin != xml_path.end() && (*begin == "." || *begin == ".."))
-                    path = xml_path;
-                else
-                    path = config_path() / config_name / xml_path;
-            }
-            else
-            {
-                path = xml_path;
-            }
+            xml_sections.push_back(XmlSection { XML_SECTION_CONSTANTS, nullptr, builtin });
+            xml_sections.push_back(XmlSection { XML_SECTION_COMMANDS, nullptr, builtin });
+            xml_sections.push_back(XmlSection { XML_SECTION_ALTERNATORS, nullptr, builtin });
+            continue;
         }
 
-        xml_vector.emplace_back(xml_parse(path));
+        xml_vector.emplace_back(xml_parse(path, std::move(*opt_buffer)));
 
         if(xml_node<>* root_node = xml_vector.back().doc->first_node("GTA3Script"))
         {
@@ -348,44 +462,47 @@ Commands Commands::from_xml(const std::string& config_name, const std::vector<fs
             {
                 if(!strcmp(node->name(), "Commands"))
                 {
-                    xml_sections.emplace_back(XML_SECTION_COMMANDS, node);
+                    xml_sections.push_back(XmlSection { XML_SECTION_COMMANDS, node, nullptr });
                 }
                 else if(!strcmp(node->name(), "Constants"))
                 {
-                    xml_sections.emplace_back(XML_SECTION_CONSTANTS, node);
+                    xml_sections.push_back(XmlSection { XML_SECTION_CONSTANTS, node, nullptr });
                 }
                 else if(!strcmp(node->name(), "Alternators"))
                 {
-                    xml_sections.emplace_back(XML_SECTION_ALTERNATORS, node);
+                    xml_sections.push_back(XmlSection { XML_SECTION_ALTERNATORS, node, nullptr });
                 }
             }
         }
     }
 
     std::stable_sort(xml_sections.begin(), xml_sections.end(), [](const auto& a, const auto& b) {
-        return a.first < b.first;
+        return a.type < b.type;
     });
 
-    for(auto& section_pair : xml_sections)
+    for(auto& section : xml_sections)
     {
-        xml_node<>* node = section_pair.second;
-        if(section_pair.first == XML_SECTION_COMMANDS)
+        xml_node<>* node = section.node;
+        if(section.builtin)
+        {
+            if(section.type == XML_SECTION_CONSTANTS)
+                load_builtin_enums(enums, *section.builtin);
+            else if(section.type == XML_SECTION_COMMANDS)
+                load_builtin_commands(commands, entities, enums, *section.builtin);
+            else if(section.type == XML_SECTION_ALTERNATORS)
+                load_builtin_alternators(alternators, commands, *section.builtin);
+        }
+        else if(section.type == XML_SECTION_COMMANDS)
         {
             for(auto cmd_node = node->first_node(); cmd_node; cmd_node = cmd_node->next_sibling())
             {
                 if(!strcmp(cmd_node->name(), "Command"))
                 {
-                    auto command = parse_command_node(cmd_node, entities, enums);
-                    auto insert_pair = commands.insert(std::move(command));
-                    if(!insert_pair.second)
-                    {
-                        commands.erase(insert_pair.first);
-                        insert_pair = commands.insert(std::move(command));
-                    }
+                    insert_command(commands, parse_command_node(cmd_node, entities, enums));
                 }
             }
         }
-        else if(section_pair.first == XML_SECTION_CONSTANTS)
+        else if(section.type == XML_SECTION_CONSTANTS)
         {
             for(auto const_node = node->first_node(); const_node; const_node = const_node->next_sibling())
             {
@@ -395,7 +512,7 @@ Commands Commands::from_xml(const std::string& config_name, const std::vector<fs
                 }
             }
         }
-        else if(section_pair.first == XML_SECTION_ALTERNATORS)
+        else if(section.type == XML_SECTION_ALTERNATORS)
         {
             for(auto alt_node = node->first_node(); alt_node; alt_node = alt_node->next_sibling())
             {
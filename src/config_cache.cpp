@@ -0,0 +1,466 @@
+#include <stdinc.h>
+#include "commands.hpp"
+#include "program.hpp"
+#include "system.hpp"
+#include "binary_cache.hpp"
+#include "builtin_config.hpp"
+
+//
+// Precompiled configuration.
+//
+// Parsing the XML definitions is the most expensive step when compiling small scripts, so the result of `from_xml`
+// is saved into a binary file, which is loaded instead whenever the XML files it was built from are unchanged.
+//
+// A XML file is unchanged if its size and last write time are the ones recorded, and only otherwise its contents are
+// hashed (e.g. the file was touched or copied over), in which case the recorded write times are refreshed.
+//
+// The files are kept in the cache directory of the user, one per compiler revision and list of XML files. Whenever
+// one is written, the others of the same revision built from XML files which no longer exist are removed. The ones
+// of other revisions are left alone, as they may belong to another gta3sc installed alongside.
+//
+// All integers are little-endian and all strings are a u32 length followed by its characters.
+//
+//  header:
+//      char[8]         magic ("GTA3SCCC")
+//      u32             version
+//      u64             revision (hash of the git sha1 of the compiler)
+//      u32             number of xml files
+//      { string path, u64 size, u64 last write time, u64 content hash }[]
+//
+//  enums (in name order):
+//      u32             count
+//      { string name, u8 is_global, u32 num_values, { string name, i32 value }[] }[]
+//
+//  entities:
+//      u32             count
+//      { string name, u16 type }[]
+//
+//  commands (in name order):
+//      u32             count
+//      { string name, u8 flags, u16 id, u32 hash, u8 num_args, arg[] }[]
+//
+//      arg: u8 type, u16 flags, u16 entity_type, u8 num_enums, u32 enum_index[]
+//
+//  alternators:
+//      u32             count
+//      { string name, u32 num_alternatives, u32 command_index[] }[]
+//
+
+extern const char* GTA3SC_GIT_SHA1;
+
+static constexpr char cache_magic[8] = { 'G', 'T', 'A', '3', 'S', 'C', 'C', 'C' };
+static constexpr uint32_t cache_version = 3;
+
+/// Identifies the compiler which wrote a cache.
+static uint64_t cache_revision()
+{
+    return fnv1a64(GTA3SC_GIT_SHA1, std::strlen(GTA3SC_GIT_SHA1));
+}
+
+/// Identifies the contents of a XML file.
+struct XmlFingerprint
+{
+    std::string path;
+    uint64_t    size;
+    uint64_t    mtime;
+    uint64_t    hash;
+};
+
+/// Gets the size and last write time of the file at `path`.
+static bool stat_xml(const fs::path& path, uint64_t& size, uint64_t& mtime)
+{
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if(ec)
+        return false;
+
+    auto time = fs::last_write_time(path, ec);
+    if(ec)
+        return false;
+
+    mtime = static_cast<uint64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+static optional<uint64_t> hash_xml(const fs::path& path)
+{
+    auto opt_buffer = read_file_utf8(path);
+    if(!opt_buffer)
+        return nullopt;
+    return fnv1a64(opt_buffer->data(), opt_buffer->size());
+}
+
+static optional<std::vector<XmlFingerprint>>
+  fingerprint_xml_list(const std::string& config_name, const std::vector<fs::path>& xml_list)
+{
+    std::vector<XmlFingerprint> fingerprints;
+    fingerprints.reserve(xml_list.size());
+
+    for(auto& xml_path : xml_list)
+    {
+        auto path = Commands::config_file_path(config_name, xml_path);
+
+        // taken before reading the file, so that a write in between is noticed on the next load.
+        XmlFingerprint xml;
+        if(!stat_xml(path, xml.size, xml.mtime))
+            return nullopt;
+
+        auto opt_hash = hash_xml(path);
+        if(!opt_hash)
+            return nullopt;
+
+        xml.path = path.generic_u8string();
+        xml.hash = *opt_hash;
+        fingerprints.push_back(std::move(xml));
+    }
+
+    return fingerprints;
+}
+
+/// Checks whether `cache_file` was written by this revision from XML files which no longer exist.
+static bool is_stale_cache(const fs::path& cache_file)
+{
+    size_t size = 0;
+    const void* data = map_file_readonly(cache_file, size);
+    if(data == nullptr)
+        return false;
+
+    auto guard = make_scope_guard([&] {
+        unmap_file(data, size);
+    });
+
+    // whether the header is the one this revision writes, thus whether the rest can be judged.
+    bool same_revision = false;
+
+    try
+    {
+        CacheReader r(data, size);
+
+        // caches of other versions or revisions are none of our business.
+        for(char c : cache_magic)
+        {
+            if(r.u8() != uint8_t(c))
+                return false;
+        }
+
+        if(r.u32() != cache_version || r.u64() != cache_revision())
+            return false;
+
+        same_revision = true;
+
+        for(size_t i = 0, n = r.count(28); i < n; ++i)
+        {
+            std::error_code ec;
+            auto path = fs::u8path(r.string().to_string());
+            if(!fs::exists(path, ec))
+                return true;
+            r.u64(); r.u64(); r.u64();
+        }
+
+        return false;
+    }
+    catch(const CacheError&)
+    {
+        return same_revision;
+    }
+}
+
+/// Removes the stale precompiled configurations (see `is_stale_cache`) in the directory of `cache_file`.
+static void prune_caches(const fs::path& cache_file)
+{
+    std::error_code ec;
+    for(auto it = fs::directory_iterator(cache_file.parent_path(), ec); !ec && it != fs::directory_iterator(); it.increment(ec))
+    {
+        auto& path = it->path();
+        auto filename = path.filename().generic_u8string();
+        if(path == cache_file || filename.compare(0, 9, "commands-") != 0 || path.extension() != ".cache")
+            continue;
+
+        if(is_stale_cache(path))
+        {
+            std::error_code remove_ec;
+            fs::remove(path, remove_ec);
+        }
+    }
+}
+
+fs::path Commands::cache_file_path(const std::string& config_name, const std::vector<fs::path>& xml_list)
+{
+    std::string key = GTA3SC_GIT_SHA1;
+    key += '\n';
+    for(auto& xml_path : xml_list)
+    {
+        key += config_file_path(config_name, xml_path).generic_u8string();
+        key += '\n';
+    }
+
+    // without a cache directory (e.g. no home), fallback to the directory of the configuration.
+    auto& cache_dir = user_cache_path();
+    auto base_dir = cache_dir.empty()? config_path() : cache_dir;
+    return base_dir / config_name / fmt::format("commands-{:016x}.cache", fnv1a64(key.data(), key.size()));
+}
+
+optional<Commands> Commands::from_cache(const fs::path& cache_file,
+                                        const std::string& config_name, const std::vector<fs::path>& xml_list)
+{
+    size_t size = 0;
+    const void* data = map_file_readonly(cache_file, size);
+    if(data == nullptr)
+        return nullopt;
+
+    auto guard = make_scope_guard([&] {
+        unmap_file(data, size);
+    });
+
+    // whether some XML file is unchanged but was written since the cache was.
+    bool refresh_cache = false;
+
+    try
+    {
+        CacheReader r(data, size);
+
+        for(char c : cache_magic)
+        {
+            if(r.u8() != uint8_t(c))
+                return nullopt;
+        }
+
+        if(r.u32() != cache_version || r.u64() != cache_revision())
+            return nullopt;
+
+        if(r.u32() != xml_list.size())
+            return nullopt;
+
+        for(auto& xml_path : xml_list)
+        {
+            auto path = Commands::config_file_path(config_name, xml_path);
+            if(r.string() != path.generic_u8string())
+                return nullopt;
+
+            auto cached_size = r.u64();
+            auto cached_mtime = r.u64();
+            auto cached_hash = r.u64();
+
+            uint64_t size, mtime;
+            if(!stat_xml(path, size, mtime) || size != cached_size)
+                return nullopt;
+
+            if(mtime != cached_mtime)
+            {
+                if(hash_xml(path) != cached_hash)
+                    return nullopt;
+                refresh_cache = true;
+            }
+        }
+
+        transparent_set<Command>                                    commands;
+        insensitive_map<std::string, std::vector<const Command*>>   alternators;
+        transparent_map<std::string, EntityType>                    entities;
+        transparent_map<std::string, shared_ptr<Enum>>              enums;
+
+        std::vector<shared_ptr<Enum>> enum_list(r.count(9));
+        for(auto& enum_ptr : enum_list)
+        {
+            auto name = r.string();
+            bool is_global = r.u8() != 0;
+
+            enum_ptr = std::make_shared<Enum>(is_global);
+
+            size_t num_values = r.count(8);
+            enum_ptr->values.reserve(num_values);
+            enum_ptr->names.reserve(num_values);
+            for(size_t i = 0; i < num_values; ++i)
+            {
+                auto value_name = r.string();
+                enum_ptr->add(value_name, r.i32());
+            }
+
+            enums.emplace(name.to_string(), enum_ptr);
+        }
+
+        for(size_t i = 0, n = r.count(6); i < n; ++i)
+        {
+            auto name = r.string();
+            entities.emplace(name.to_string(), r.u16());
+        }
+
+        std::vector<const Command*> command_list(r.count(13));
+        for(auto& command_ptr : command_list)
+        {
+            auto name = r.string();
+            uint8_t flags = r.u8();
+            uint16_t id = r.u16();
+            uint32_t hash = r.u32();
+
+            decltype(Command::args) args;
+            size_t num_args = r.u8();
+            args.reserve(num_args);
+            for(size_t i = 0; i < num_args; ++i)
+            {
+                Command::Arg arg;
+                arg.type = static_cast<ArgType>(r.u8());
+                if(arg.type > ArgType::Constant)
+                    throw CacheError();
+
+                decode_arg_flags(arg, r.u16());
+                arg.entity_type = r.u16();
+
+                for(size_t k = 0, num_enums = r.u8(); k < num_enums; ++k)
+                {
+                    uint32_t index = r.u32();
+                    if(index >= enum_list.size())
+                        throw CacheError();
+                    arg.enums.emplace_back(enum_list[index]);
+                }
+
+                args.emplace_back(std::move(arg));
+            }
+
+            auto it = commands.emplace_hint(commands.end(), Command {
+                (flags & CMD_SUPPORTED) != 0,
+                (flags & CMD_INTERNAL) != 0,
+                (flags & CMD_EXTENSION) != 0,
+                (flags & CMD_HAS_ID)? optional<uint16_t>(id) : nullopt,
+                (flags & CMD_HAS_HASH)? optional<uint32_t>(hash) : nullopt,
+                std::move(args),
+                name.to_string(),
+            });
+            command_ptr = std::addressof(*it);
+        }
+
+        if(commands.size() != command_list.size())
+            throw CacheError();
+
+        for(size_t i = 0, n = r.count(8); i < n; ++i)
+        {
+            auto name = r.string();
+            auto& alternatives = alternators[name.to_string()];
+            alternatives.resize(r.count(4));
+            for(auto& alternative : alternatives)
+            {
+                uint32_t index = r.u32();
+                if(index >= command_list.size())
+                    throw CacheError();
+                alternative = command_list[index];
+            }
+        }
+
+        if(!r.at_end())
+            throw CacheError();
+
+        if(!enums.count("MODEL") || !enums.count("DEFAULTMODEL") || !enums.count("SCRIPTSTREAM"))
+            throw CacheError();
+
+        Commands result { std::move(commands), std::move(alternators), std::move(entities), std::move(enums) };
+
+        if(refresh_cache)
+            result.write_cache(cache_file, config_name, xml_list);
+
+        return result;
+    }
+    catch(const CacheError&)
+    {
+        return nullopt;
+    }
+}
+
+bool Commands::write_cache(const fs::path& cache_file,
+                           const std::string& config_name, const std::vector<fs::path>& xml_list) const
+{
+    auto opt_fingerprints = fingerprint_xml_list(config_name, xml_list);
+    if(!opt_fingerprints)
+        return false;
+
+    CacheWriter w;
+
+    for(char c : cache_magic)
+        w.u8(uint8_t(c));
+    w.u32(cache_version);
+    w.u64(cache_revision());
+
+    w.u32(uint32_t(opt_fingerprints->size()));
+    for(auto& xml : *opt_fingerprints)
+    {
+        w.string(xml.path);
+        w.u64(xml.size);
+        w.u64(xml.mtime);
+        w.u64(xml.hash);
+    }
+
+    std::map<const Enum*, uint32_t> enum_indices;
+    w.u32(uint32_t(this->enums.size()));
+    for(auto& e : this->enums)
+    {
+        enum_indices.emplace(e.second.get(), uint32_t(enum_indices.size()));
+
+        w.string(e.first);
+        w.u8(e.second->is_global);
+        w.u32(uint32_t(e.second->values.size()));
+        for(auto& value : e.second->values)
+        {
+            w.string(e.second->name_of(value.first));
+            w.i32(value.second);
+        }
+    }
+
+    w.u32(uint32_t(this->entities.size()));
+    for(auto& entity : this->entities)
+    {
+        w.string(entity.first);
+        w.u16(entity.second);
+    }
+
+    std::map<const Command*, uint32_t> command_indices;
+    w.u32(uint32_t(this->commands.size()));
+    for(auto& command : this->commands)
+    {
+        command_indices.emplace(std::addressof(command), uint32_t(command_indices.size()));
+
+        w.string(command.name);
+        w.u8((command.supported? CMD_SUPPORTED : 0)
+           | (command.internal? CMD_INTERNAL : 0)
+           | (command.extension? CMD_EXTENSION : 0)
+           | (command.id? CMD_HAS_ID : 0)
+           | (command.hash? CMD_HAS_HASH : 0));
+        w.u16(command.id.value_or(0));
+        w.u32(command.hash.value_or(0));
+
+        if(command.args.size() > UINT8_MAX)
+            return false;
+
+        w.u8(uint8_t(command.args.size()));
+        for(auto& arg : command.args)
+        {
+            w.u8(uint8_t(arg.type));
+            w.u16(encode_arg_flags(arg));
+            w.u16(arg.entity_type);
+
+            w.u8(uint8_t(arg.enums.size()));
+            for(auto& e : arg.enums)
+            {
+                auto it = enum_indices.find(e.get());
+                if(it == enum_indices.end())
+                    return false;
+                w.u32(it->second);
+            }
+        }
+    }
+
+    w.u32(uint32_t(this->alternators.size()));
+    for(auto& alt : this->alternators)
+    {
+        w.string(alt.first);
+        w.u32(uint32_t(alt.second.size()));
+        for(auto& command : alt.second)
+            w.u32(command_indices.at(command));
+    }
+
+    std::error_code ec;
+    fs::create_directories(cache_file.parent_path(), ec);
+
+    if(!write_cache_file(cache_file, w.bytes))
+        return false;
+
+    prune_caches(cache_file);
+    return true;
+}
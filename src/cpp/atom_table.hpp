@@ -0,0 +1,247 @@
+///
+/// Atom Table - Interns case-insensitive identifiers into small integers.
+///
+#pragma once
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+/// An identifier interned in the global `AtomTable`.
+///
+/// Atoms are case-insensitive, that is, `Atom::intern("abc") == Atom::intern("ABC")`.
+/// Comparing or hashing an atom is as cheap as comparing or hashing an integer.
+class Atom
+{
+public:
+    /// Constructs the null atom, which is never equal to the atom of an identifier.
+    Atom() = default;
+
+    /// Interns `name`, giving back the same atom given to any identifier case-insensitively equal to it.
+    static Atom intern(const string_view& name);
+
+    /// Finds the atom of `name`, or the null atom if no such identifier was ever interned.
+    static Atom find(const string_view& name);
+
+    /// Unique number of this atom. Zero for the null atom.
+    uint32_t id() const { return this->id_; }
+
+    /// Case-insensitive hash of this identifier (see `ihash`).
+    uint32_t hash() const { return this->hash_; }
+
+    /// The identifier this atom was first interned with.
+    ///
+    /// \note which spelling came first depends on everything interned before (e.g. by previous requests to the
+    /// compile server), thus it must not be written into any output.
+    string_view name() const;
+
+    explicit operator bool() const { return this->id_ != 0; }
+
+    friend bool operator==(const Atom& lhs, const Atom& rhs) { return lhs.id_ == rhs.id_; }
+    friend bool operator!=(const Atom& lhs, const Atom& rhs) { return lhs.id_ != rhs.id_; }
+    friend bool operator<(const Atom& lhs, const Atom& rhs)  { return lhs.id_ < rhs.id_; }
+
+private:
+    friend class AtomTable;
+
+    explicit Atom(uint32_t id, uint32_t hash) :
+        id_(id), hash_(hash)
+    {}
+
+    uint32_t id_ = 0;
+    uint32_t hash_ = 0;
+};
+
+namespace std
+{
+    template<>
+    struct hash<Atom>
+    {
+        size_t operator()(const Atom& atom) const
+        {
+            return atom.hash();
+        }
+    };
+}
+
+/// Table of interned identifiers.
+///
+/// The table is split in shards, each with its own lock, so that many threads
+/// (e.g. tokenizing different scripts) may intern identifiers at the same time.
+/// Names are never moved nor freed, thus `Atom::name` needs no locking.
+class AtomTable
+{
+public:
+    AtomTable() = default;
+
+    AtomTable(const AtomTable&) = delete;
+    AtomTable& operator=(const AtomTable&) = delete;
+
+    ~AtomTable()
+    {
+        for(auto& chunk : this->chunks)
+            delete[] chunk.load();
+    }
+
+    /// Gets the table used by `Atom`.
+    static AtomTable& global()
+    {
+        static AtomTable table;
+        return table;
+    }
+
+    /// See `Atom::intern`.
+    Atom intern(const string_view& name)
+    {
+        Key key { name, ihash::hash(name) };
+        auto& shard = this->shard_for(key);
+
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.atoms.find(key);
+            if(it != shard.atoms.end())
+                return it->second;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.atoms.find(key);
+        if(it != shard.atoms.end())
+            return it->second;
+
+        uint32_t id = this->next_id.fetch_add(1);
+        if(id >= chunk_size * max_chunks)
+            throw std::length_error("too many identifiers");
+
+        std::string& stored = this->slot(id);
+        stored.assign(name.data(), name.size());
+
+        Atom atom(id, key.hash);
+        shard.atoms.emplace(Key { string_view(stored), key.hash }, atom);
+        return atom;
+    }
+
+    /// See `Atom::find`.
+    Atom find(const string_view& name) const
+    {
+        Key key { name, ihash::hash(name) };
+        auto& shard = this->shard_for(key);
+
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.atoms.find(key);
+        if(it != shard.atoms.end())
+            return it->second;
+        return Atom();
+    }
+
+    /// See `Atom::name`.
+    string_view name(const Atom& atom) const
+    {
+        if(!atom)
+            return string_view();
+        const std::string* chunk = this->chunks[atom.id() / chunk_size].load(std::memory_order_acquire);
+        return string_view(chunk[atom.id() % chunk_size]);
+    }
+
+    /// Number of identifiers interned in this table.
+    size_t size() const
+    {
+        return this->next_id.load() - 1;
+    }
+
+    /// Forgets every identifier interned in this table, releasing their memory.
+    ///
+    /// This is meant for long-lived processes (e.g. the compile server), whose table would otherwise keep growing.
+    ///
+    /// \warning no atom given by this table may be in use, neither during nor after this call.
+    void clear()
+    {
+        for(auto& shard : this->shards)
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.atoms.clear();
+        }
+
+        for(auto& chunk : this->chunks)
+            delete[] chunk.exchange(nullptr);
+
+        this->next_id = 1;
+    }
+
+private:
+    static constexpr size_t num_shards = 32;
+    static constexpr size_t chunk_size = 4096;
+    static constexpr size_t max_chunks = 4096;
+
+    struct Key
+    {
+        string_view name;
+        uint32_t    hash;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const { return key.hash; }
+    };
+
+    struct KeyEqual
+    {
+        bool operator()(const Key& lhs, const Key& rhs) const
+        {
+            return lhs.hash == rhs.hash && iequal_to()(lhs.name, rhs.name);
+        }
+    };
+
+    struct Shard
+    {
+        mutable std::shared_mutex                           mutex;
+        std::unordered_map<Key, Atom, KeyHash, KeyEqual>    atoms;
+    };
+
+    Shard& shard_for(const Key& key)
+    {
+        return this->shards[(key.hash >> 16) % num_shards];
+    }
+
+    const Shard& shard_for(const Key& key) const
+    {
+        return this->shards[(key.hash >> 16) % num_shards];
+    }
+
+    /// Gets the storage for the name of the atom `id`, allocating its chunk if needed.
+    std::string& slot(uint32_t id)
+    {
+        auto& chunk = this->chunks[id / chunk_size];
+        std::string* ptr = chunk.load(std::memory_order_acquire);
+        if(ptr == nullptr)
+        {
+            std::unique_ptr<std::string[]> fresh(new std::string[chunk_size]);
+            if(chunk.compare_exchange_strong(ptr, fresh.get(), std::memory_order_acq_rel))
+                ptr = fresh.release();
+        }
+        return ptr[id % chunk_size];
+    }
+
+private:
+    std::array<Shard, num_shards>                       shards;
+    std::array<std::atomic<std::string*>, max_chunks>   chunks {};
+    std::atomic<uint32_t>                               next_id {1};
+};
+
+inline Atom Atom::intern(const string_view& name)
+{
+    return AtomTable::global().intern(name);
+}
+
+inline Atom Atom::find(const string_view& name)
+{
+    return AtomTable::global().find(name);
+}
+
+inline string_view Atom::name() const
+{
+    return AtomTable::global().name(*this);
+}
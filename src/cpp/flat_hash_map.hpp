@@ -0,0 +1,458 @@
+///
+/// Flat Hash Map - An open-addressing hash map with linear probing.
+///
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// Hash map storing its entries inline in a single power-of-two sized array.
+///
+/// Collisions are resolved by linear probing and erasure shifts the following entries back, so there are no
+/// tombstones. Besides the entries, the map keeps a parallel array with (part of) the hash of each slot, which
+/// both marks empty slots (zero) and avoids most key comparisons while probing.
+///
+/// Lookups are heterogeneous: `find(k)`, `count(k)` and friends accept anything `Hash` and `KeyEqual` accept,
+/// e.g. a `string_view` for a map keyed by `std::string` whose hasher and comparator take `string_view`s.
+///
+/// The iteration order is unspecified and changes as the map grows, thus, where the order is visible
+/// to the user, sort the entries before visiting them. Iterators and references are invalidated by insertions
+/// and erasures.
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class flat_hash_map
+{
+public:
+    using key_type          = Key;
+    using mapped_type       = Value;
+    using value_type        = std::pair<const Key, Value>;
+    using size_type         = size_t;
+    using hasher            = Hash;
+    using key_equal         = KeyEqual;
+    using reference         = value_type&;
+    using const_reference   = const value_type&;
+
+private:
+    template<bool IsConst>
+    class basic_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = typename flat_hash_map::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference         = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        basic_iterator() = default;
+
+        template<bool WasConst, typename = std::enable_if_t<IsConst && !WasConst>>
+        basic_iterator(const basic_iterator<WasConst>& other) :
+            map(other.map), index(other.index)
+        {}
+
+        reference operator*() const { return map->slot(index); }
+        pointer operator->() const  { return std::addressof(map->slot(index)); }
+
+        basic_iterator& operator++()
+        {
+            this->index = map->next_used(this->index + 1);
+            return *this;
+        }
+
+        basic_iterator operator++(int)
+        {
+            auto copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        friend bool operator==(const basic_iterator& lhs, const basic_iterator& rhs) { return lhs.index == rhs.index; }
+        friend bool operator!=(const basic_iterator& lhs, const basic_iterator& rhs) { return lhs.index != rhs.index; }
+
+    private:
+        friend class flat_hash_map;
+        using map_pointer = std::conditional_t<IsConst, const flat_hash_map*, flat_hash_map*>;
+
+        basic_iterator(map_pointer map, size_t index) :
+            map(map), index(index)
+        {}
+
+        map_pointer map = nullptr;
+        size_t      index = 0;
+    };
+
+public:
+    using iterator          = basic_iterator<false>;
+    using const_iterator    = basic_iterator<true>;
+
+    flat_hash_map() = default;
+
+    flat_hash_map(std::initializer_list<value_type> list)
+    {
+        this->reserve(list.size());
+        for(auto& value : list)
+            this->insert(value);
+    }
+
+    flat_hash_map(const flat_hash_map& other) :
+        hash_function_(other.hash_function_), key_eq_(other.key_eq_)
+    {
+        this->reserve(other.size());
+        for(auto& value : other)
+            this->insert(value);
+    }
+
+    flat_hash_map(flat_hash_map&& other) noexcept :
+        slots(std::move(other.slots)), hashes(std::move(other.hashes)),
+        capacity_(other.capacity_), size_(other.size_),
+        hash_function_(std::move(other.hash_function_)), key_eq_(std::move(other.key_eq_))
+    {
+        other.capacity_ = 0;
+        other.size_ = 0;
+    }
+
+    flat_hash_map& operator=(const flat_hash_map& other)
+    {
+        if(this != &other)
+        {
+            flat_hash_map copy(other);
+            this->swap(copy);
+        }
+        return *this;
+    }
+
+    flat_hash_map& operator=(flat_hash_map&& other) noexcept
+    {
+        if(this != &other)
+        {
+            this->destroy_all();
+            this->slots = std::move(other.slots);
+            this->hashes = std::move(other.hashes);
+            this->capacity_ = other.capacity_;
+            this->size_ = other.size_;
+            this->hash_function_ = std::move(other.hash_function_);
+            this->key_eq_ = std::move(other.key_eq_);
+            other.capacity_ = 0;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~flat_hash_map()
+    {
+        this->destroy_all();
+    }
+
+    void swap(flat_hash_map& other) noexcept
+    {
+        using std::swap;
+        swap(this->slots, other.slots);
+        swap(this->hashes, other.hashes);
+        swap(this->capacity_, other.capacity_);
+        swap(this->size_, other.size_);
+        swap(this->hash_function_, other.hash_function_);
+        swap(this->key_eq_, other.key_eq_);
+    }
+
+    iterator begin()                { return iterator(this, this->next_used(0)); }
+    iterator end()                  { return iterator(this, this->capacity_); }
+    const_iterator begin() const    { return const_iterator(this, this->next_used(0)); }
+    const_iterator end() const      { return const_iterator(this, this->capacity_); }
+    const_iterator cbegin() const   { return this->begin(); }
+    const_iterator cend() const     { return this->end(); }
+
+    bool empty() const              { return this->size_ == 0; }
+    size_type size() const          { return this->size_; }
+    size_type bucket_count() const  { return this->capacity_; }
+
+    hasher hash_function() const    { return this->hash_function_; }
+    key_equal key_eq() const        { return this->key_eq_; }
+
+    void clear()
+    {
+        for(size_t i = 0; i < this->capacity_; ++i)
+        {
+            if(this->hashes[i])
+            {
+                this->slot(i).~value_type();
+                this->hashes[i] = 0;
+            }
+        }
+        this->size_ = 0;
+    }
+
+    /// Makes room for at least `count` entries without further rehashing.
+    void reserve(size_type count)
+    {
+        size_t wanted = min_capacity;
+        while(wanted - wanted / 4 < count)
+            wanted *= 2;
+        if(wanted > this->capacity_)
+            this->rehash(wanted);
+    }
+
+    template<typename K>
+    iterator find(const K& key)
+    {
+        return iterator(this, this->find_index(key));
+    }
+
+    template<typename K>
+    const_iterator find(const K& key) const
+    {
+        return const_iterator(this, this->find_index(key));
+    }
+
+    template<typename K>
+    size_type count(const K& key) const
+    {
+        return this->find_index(key) != this->capacity_? 1 : 0;
+    }
+
+    template<typename K>
+    Value& at(const K& key)
+    {
+        auto it = this->find(key);
+        if(it == this->end())
+            throw std::out_of_range("flat_hash_map::at");
+        return it->second;
+    }
+
+    template<typename K>
+    const Value& at(const K& key) const
+    {
+        auto it = this->find(key);
+        if(it == this->end())
+            throw std::out_of_range("flat_hash_map::at");
+        return it->second;
+    }
+
+    Value& operator[](const Key& key)
+    {
+        return this->try_emplace(key).first->second;
+    }
+
+    Value& operator[](Key&& key)
+    {
+        return this->try_emplace(std::move(key)).first->second;
+    }
+
+    /// Inserts `Value(args...)` under `key` unless the key is already in the map, in which case nothing is constructed.
+    template<typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+        const size_t hash = this->hash_of(key);
+        size_t index = this->find_index(key, hash);
+        if(index != this->capacity_)
+            return std::make_pair(iterator(this, index), false);
+
+        if(this->size_ + 1 > this->capacity_ - this->capacity_ / 4)
+            this->rehash(this->capacity_? this->capacity_ * 2 : min_capacity);
+
+        index = this->free_index(hash);
+        new (std::addressof(this->slot(index))) value_type(std::piecewise_construct,
+                                                           std::forward_as_tuple(std::forward<K>(key)),
+                                                           std::forward_as_tuple(std::forward<Args>(args)...));
+        this->hashes[index] = tag_of(hash);
+        ++this->size_;
+        return std::make_pair(iterator(this, index), true);
+    }
+
+    template<typename K, typename V>
+    std::pair<iterator, bool> emplace(K&& key, V&& value)
+    {
+        return this->try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    template<typename P>
+    std::pair<iterator, bool> emplace(P&& pair)
+    {
+        return this->try_emplace(std::forward<P>(pair).first, std::forward<P>(pair).second);
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return this->try_emplace(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return this->try_emplace(value.first, std::move(value.second));
+    }
+
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for(; first != last; ++first)
+            this->emplace(*first);
+    }
+
+    /// Erases the entry at `pos`, giving back the iterator to the next entry.
+    ///
+    /// Note: Since the following entries are shifted back, erasing while iterating may visit an entry twice.
+    iterator erase(iterator pos)
+    {
+        return this->erase(const_iterator(pos));
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        size_t index = pos.index;
+        this->erase_index(index);
+        // the entry that was shifted into `index` (if any) was not visited yet.
+        return iterator(this, this->hashes[index]? index : this->next_used(index));
+    }
+
+    template<typename K>
+    size_type erase(const K& key)
+    {
+        size_t index = this->find_index(key);
+        if(index == this->capacity_)
+            return 0;
+        this->erase_index(index);
+        return 1;
+    }
+
+private:
+    static constexpr size_t min_capacity = 8;
+
+    struct Slot
+    {
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;
+    };
+
+    value_type& slot(size_t index)
+    {
+        return *reinterpret_cast<value_type*>(&this->slots[index].storage);
+    }
+
+    const value_type& slot(size_t index) const
+    {
+        return *reinterpret_cast<const value_type*>(&this->slots[index].storage);
+    }
+
+    template<typename K>
+    size_t hash_of(const K& key) const
+    {
+        return static_cast<size_t>(this->hash_function_(key));
+    }
+
+    /// Nonzero tag stored for an used slot.
+    static uint32_t tag_of(size_t hash)
+    {
+        return static_cast<uint32_t>(hash) | 1;
+    }
+
+    /// Initial probing position of `hash`. The hash is mixed since hashers such as `std::hash<int>` are identities.
+    size_t home_of(size_t hash) const
+    {
+        return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> 32) & (this->capacity_ - 1);
+    }
+
+    size_t next_used(size_t index) const
+    {
+        while(index < this->capacity_ && !this->hashes[index])
+            ++index;
+        return index;
+    }
+
+    template<typename K>
+    size_t find_index(const K& key) const
+    {
+        return this->find_index(key, this->hash_of(key));
+    }
+
+    template<typename K>
+    size_t find_index(const K& key, size_t hash) const
+    {
+        if(this->size_ == 0)
+            return this->capacity_;
+
+        const uint32_t tag = tag_of(hash);
+        const size_t mask = this->capacity_ - 1;
+        for(size_t i = this->home_of(hash); this->hashes[i]; i = (i + 1) & mask)
+        {
+            if(this->hashes[i] == tag && this->key_eq_(this->slot(i).first, key))
+                return i;
+        }
+        return this->capacity_;
+    }
+
+    size_t free_index(size_t hash) const
+    {
+        const size_t mask = this->capacity_ - 1;
+        size_t i = this->home_of(hash);
+        while(this->hashes[i])
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    void erase_index(size_t index)
+    {
+        const size_t mask = this->capacity_ - 1;
+
+        this->slot(index).~value_type();
+        this->hashes[index] = 0;
+        --this->size_;
+
+        // Shifts back the entries that would not be found anymore because of the hole at `index`.
+        for(size_t hole = index, i = (index + 1) & mask; this->hashes[i]; i = (i + 1) & mask)
+        {
+            size_t home = this->home_of(this->hash_of(this->slot(i).first));
+            bool can_move = (hole <= i)? (home <= hole || home > i) : (home <= hole && home > i);
+            if(can_move)
+            {
+                new (std::addressof(this->slot(hole))) value_type(std::move(this->slot(i)));
+                this->hashes[hole] = this->hashes[i];
+                this->slot(i).~value_type();
+                this->hashes[i] = 0;
+                hole = i;
+            }
+        }
+    }
+
+    void rehash(size_t new_capacity)
+    {
+        auto old_slots = std::move(this->slots);
+        auto old_hashes = std::move(this->hashes);
+        size_t old_capacity = this->capacity_;
+
+        this->slots.reset(new Slot[new_capacity]);
+        this->hashes.reset(new uint32_t[new_capacity]());
+        this->capacity_ = new_capacity;
+
+        for(size_t i = 0; i < old_capacity; ++i)
+        {
+            if(old_hashes[i])
+            {
+                auto& value = *reinterpret_cast<value_type*>(&old_slots[i].storage);
+                size_t index = this->free_index(this->hash_of(value.first));
+                new (std::addressof(this->slot(index))) value_type(std::move(value));
+                this->hashes[index] = old_hashes[i];
+                value.~value_type();
+            }
+        }
+    }
+
+    void destroy_all()
+    {
+        if(this->hashes)
+        {
+            this->clear();
+        }
+    }
+
+private:
+    std::unique_ptr<Slot[]>     slots;
+    std::unique_ptr<uint32_t[]> hashes;     //< Zero for empty slots, `tag_of(hash)` otherwise.
+    size_t                      capacity_ = 0;
+    size_t                      size_ = 0;
+    Hash                        hash_function_;
+    KeyEqual                    key_eq_;
+};
@@ -44,3 +44,27 @@ struct iequal_to
         return strncasecmp(left.data(), right.data(), left.size()) == 0;
     }
 };
+
+/// std::hash<string_view> but case insensitive
+///
+/// This is the 32-bit FNV-1a hash of the upper-cased (ASCII only) characters of the string.
+struct ihash
+{
+    using is_transparent = int;
+
+    size_t operator()(const string_view& value) const
+    {
+        return ihash::hash(value);
+    }
+
+    static uint32_t hash(const string_view& value)
+    {
+        uint32_t h = 2166136261u;
+        for(char c : value)
+        {
+            h ^= static_cast<uint8_t>((c >= 'a' && c <= 'z')? c - 'a' + 'A' : c);
+            h *= 16777619u;
+        }
+        return h;
+    }
+};
@@ -0,0 +1,285 @@
+///
+/// Thread Pool - A work-stealing scheduler used to run batches of independent tasks.
+///
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Runs batches of independent tasks on a fixed set of worker threads.
+///
+/// Each thread owns a queue of index ranges. A thread running a range splits it in halves, keeping the lower half
+/// to itself and pushing the upper half into its own queue. Threads pop work from the back of their own queue and,
+/// when it runs dry, steal from the front of the others' queues, which is where the largest ranges are.
+///
+/// The thread submitting a batch also works on it, thus a pool with a concurrency of one has no worker threads
+/// at all and behaves exactly like a sequential loop. This also means batches may be nested without deadlocking.
+class ThreadPool
+{
+public:
+    /// Creates a pool able to run `concurrency` tasks at the same time (the submitting thread included).
+    explicit ThreadPool(size_t concurrency) :
+        queues(std::max(size_t(1), concurrency))
+    {
+        this->workers.reserve(this->queues.size() - 1);
+        for(size_t i = 1; i < this->queues.size(); ++i)
+            this->workers.emplace_back([this, i] { this->worker_main(i); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->sleep_mutex);
+            this->stopping = true;
+        }
+        this->cv_sleep.notify_all();
+        for(auto& thread : this->workers)
+            thread.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Number of tasks this pool may run at the same time.
+    size_t concurrency() const
+    {
+        return this->workers.size() + 1;
+    }
+
+    /// Calls `functor(i)` for each `i` in the range [begin, end) and waits for all the calls to finish.
+    ///
+    /// The calls happen in no particular order, possibly at the same time.
+    /// If any call throws, the exception of the lowest such `i` is rethrown after all the calls finished.
+    template<typename IndexType, typename Functor>
+    void parallel_for(IndexType begin, IndexType end, Functor&& functor)
+    {
+        if(begin == end)
+            return;
+
+        const size_t count = static_cast<size_t>(end - begin);
+
+        if(this->workers.empty() || count == 1)
+        {
+            for(auto i = begin; i != end; ++i)
+                functor(i);
+            return;
+        }
+
+        Batch batch(count, [&](size_t i) { functor(static_cast<IndexType>(begin + i)); });
+
+        const size_t self = this->current_queue();
+        this->push(self, Task { &batch, 0, count });
+
+        while(!batch.finished())
+        {
+            if(!this->run_one(self))
+                this->sleep([&] { return batch.finished(); });
+        }
+
+        for(auto& e : batch.exceptions)
+        {
+            if(e) std::rethrow_exception(e);
+        }
+    }
+
+    /// Gets the pool shared by the whole program.
+    static ThreadPool& global()
+    {
+        return *global_ptr();
+    }
+
+    /// Recreates the global pool with the specified concurrency. Zero means the hardware concurrency.
+    ///
+    /// \warning this method is not thread-safe, call it before the global pool is first used.
+    static void set_global_concurrency(size_t concurrency)
+    {
+        if(concurrency == 0)
+            concurrency = std::max(1u, std::thread::hardware_concurrency());
+        global_ptr().reset(new ThreadPool(concurrency));
+    }
+
+private:
+    /// Indices of a `parallel_for` call, all sharing a single functor.
+    struct Batch
+    {
+        const size_t                        count;
+        const std::function<void(size_t)>   functor;
+        std::vector<std::exception_ptr>     exceptions;
+        std::atomic<size_t>                 done {0};
+
+        explicit Batch(size_t count, std::function<void(size_t)> functor) :
+            count(count), functor(std::move(functor)), exceptions(count)
+        {}
+
+        bool finished() const
+        {
+            return this->done.load() == this->count;
+        }
+    };
+
+    /// The range [begin, end) of indices of a batch.
+    struct Task
+    {
+        Batch*  batch;
+        size_t  begin;
+        size_t  end;
+    };
+
+    /// Queue of tasks owned by a thread. Other threads may steal from it.
+    struct TaskQueue
+    {
+        std::mutex          mutex;
+        std::deque<Task>    tasks;
+    };
+
+    void worker_main(size_t self)
+    {
+        current_owner() = this;
+        current_index() = self;
+
+        while(true)
+        {
+            if(!this->run_one(self))
+            {
+                if(!this->sleep([] { return false; }))
+                    return;
+            }
+        }
+    }
+
+    /// Runs a task from the queue `self` or, if there is none, steals one from the other queues.
+    bool run_one(size_t self)
+    {
+        Task task;
+        if(!this->pop(self, task) && !this->steal(self, task))
+            return false;
+
+        while(task.end - task.begin > 1)
+        {
+            size_t middle = task.begin + (task.end - task.begin) / 2;
+            this->push(self, Task { task.batch, middle, task.end });
+            task.end = middle;
+        }
+
+        auto& batch = *task.batch;
+        const size_t count = batch.count;
+
+        try
+        {
+            batch.functor(task.begin);
+        }
+        catch(...)
+        {
+            batch.exceptions[task.begin] = std::current_exception();
+        }
+
+        // the batch may be gone as soon as the last index is done, so do not touch it afterwards.
+        if(batch.done.fetch_add(1) + 1 == count)
+            this->wake_all();
+
+        return true;
+    }
+
+    void push(size_t self, Task task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->queues[self].mutex);
+            this->queues[self].tasks.emplace_back(task);
+            ++this->num_queued;
+        }
+        this->wake_all();
+    }
+
+    bool pop(size_t self, Task& task)
+    {
+        auto& queue = this->queues[self];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.tasks.empty())
+            return false;
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        --this->num_queued;
+        return true;
+    }
+
+    bool steal(size_t self, Task& task)
+    {
+        if(this->num_queued.load() == 0)
+            return false;
+
+        for(size_t k = 1; k < this->queues.size(); ++k)
+        {
+            auto& queue = this->queues[(self + k) % this->queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(!queue.tasks.empty())
+            {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+                --this->num_queued;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Blocks until there is work to be stolen or `wake_up` is true.
+    /// \returns false if the pool is being destroyed.
+    template<typename Predicate>
+    bool sleep(Predicate wake_up)
+    {
+        std::unique_lock<std::mutex> lock(this->sleep_mutex);
+        this->cv_sleep.wait(lock, [&] {
+            return this->stopping || this->num_queued.load() != 0 || wake_up();
+        });
+        return !this->stopping;
+    }
+
+    void wake_all()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->sleep_mutex);
+        }
+        this->cv_sleep.notify_all();
+    }
+
+    /// Index of the queue owned by the calling thread. Threads foreign to this pool share the first queue.
+    size_t current_queue() const
+    {
+        return current_owner() == this? current_index() : 0;
+    }
+
+    static const ThreadPool*& current_owner()
+    {
+        thread_local const ThreadPool* owner = nullptr;
+        return owner;
+    }
+
+    static size_t& current_index()
+    {
+        thread_local size_t index = 0;
+        return index;
+    }
+
+    /// The global pool, which runs everything on the calling thread until `set_global_concurrency` is called.
+    static std::unique_ptr<ThreadPool>& global_ptr()
+    {
+        // initialized once even if first reached by several threads at the same time.
+        static std::unique_ptr<ThreadPool> pool(new ThreadPool(1));
+        return pool;
+    }
+
+private:
+    std::vector<TaskQueue>          queues;     //< queues[0] is for threads not in `workers`.
+    std::vector<std::thread>        workers;
+    std::atomic<size_t>             num_queued {0};
+    std::mutex                      sleep_mutex;
+    std::condition_variable         cv_sleep;
+    bool                            stopping = false;
+};
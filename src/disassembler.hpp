@@ -8,7 +8,7 @@
 #include <stdinc.h>
 #include "binary_fetcher.hpp"
 
-// contrasts to CompiledVar
+// contrasts to CompiledArg::Type::Var
 struct DecompiledVar
 {
     bool     global;
@@ -21,7 +21,7 @@ struct DecompiledVar
     }
 };
 
-// constrats to CompiledVar
+// constrats to CompiledArg::Type::VarArrayVar
 struct DecompiledVarArray
 {
     enum class ElemType : uint8_t
@@ -35,7 +35,7 @@ struct DecompiledVarArray
     ElemType      elem_type;
 };
 
-// contrasts to CompiledString
+// contrasts to the string types of CompiledArg
 struct DecompiledString
 {
     enum class Type : uint8_t
@@ -50,10 +50,10 @@ struct DecompiledString
     std::string storage;
 };
 
-// contrasts to ArgVariant
+// contrasts to CompiledArg
 using ArgVariant2 = variant<EOAL, int8_t, int16_t, int32_t, float, DecompiledVar, DecompiledVarArray, DecompiledString>;
 
-// contrasts to CompiledCommand
+// contrasts to CompiledIR::Op::Command
 struct DecompiledCommand
 {
     bool                     not_flag;
@@ -61,13 +61,13 @@ struct DecompiledCommand
     std::vector<ArgVariant2> args;
 };
 
-// contrasts to CompiledLabelDef
+// contrasts to CompiledIR::Op::LabelDef
 struct DecompiledLabelDef
 {
     size_t offset;      //< Local offset (relative to self-mission-base or main-base)
 };
 
-// contrasts to CompiledHex
+// contrasts to CompiledIR::Op::Hex
 struct DecompiledHex
 {
     std::vector<uint8_t> data;
@@ -100,7 +100,7 @@ struct DecompiledScmHeader
     static optional<DecompiledScmHeader> from_bytecode(const void* bytecode, size_t bytecode_size, Version version);
 };
 
-// contrasts to CompiledData
+// contrasts to CompiledIR::Instr
 struct DecompiledData
 {
     size_t                                                        offset;   //< Local offset of this piece of data
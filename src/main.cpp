@@ -1,14 +1,24 @@
 #include <stdinc.h>
 #include "program.hpp"
 #include "system.hpp"
+#include "builtin_config.hpp"
 #include "cpp/argv.hpp"
 
 const char* GTA3SC_HELP_MESSAGE =
 R"(Usage: gta3sc [compile|decompile] --config=<name> file [options]
+       gta3sc link --config=<name> object [options]
+       gta3sc config-compile --config=<name> [options]
+       gta3sc serve --socket=<path> [-j <n>]
 Options:
   --help                   Display this information.
   --version                Displays version information.
   -o <file>                Place the output into <file>.
+  --watch                  Keeps compiling the input every time it, a script in
+                           its subdirectory or a definition file changes.
+  --batch=<manifest>       Compiles every entry of <manifest>, each line being
+                           the input file, output and options of one script.
+                           The options in the command line apply to every
+                           entry. Entries are compiled in parallel (see -j).
   --cs                     Outputs a CLEO script. This also sets -fcleo.
   --cm                     Outputs a CLEO custom mission.
                            This also sets -fcleo and -fmission-script.
@@ -22,6 +32,11 @@ Options:
   --add-config=<path>      Adds an additional XML definition file.
                            If the path is not absolute or starts with './' or
                            '../', uses a path relative to 'config/<name>/'.
+  --no-config-cache        Always parses the XML definition files instead of
+                           loading their precompiled form from 'config/<name>/'.
+  --build-cache=<dir>      Keeps the parsed form of each script in <dir>, so
+                           unchanged scripts are not parsed again on the next
+                           compilation (e.g. '.gta3sc-cache').
   -pedantic                Warns when using extensions not in R* language.
   -pedantic-errors         Errors when using extensions not in R* language.
   --guesser                Allows the use of language features not completly
@@ -33,9 +48,18 @@ Options:
   -O                       Enables optimizations.
   -emit-ir2                Emits a explicit IR based on Sanny Builder syntax.
   -fsyntax-only            Only checks the syntax, i.e. doesn't generate code.
+  -c                       Compiles each script into a relocatable object (the
+                           main one into the output, the others next to it),
+                           which are turned into the final output by
+                           'gta3sc link' with the same code generation options.
   --recursive-traversal    Disassembler scans the code by the means of a
                            recursive traversal instead of linear-sweep.
   --expect-var=<info>
+  -j <n>                   Runs up to <n> jobs in parallel. Defaults to 1.
+                           Use 0 to run one job per processor.
+  --socket=<path>          Socket the compile server listens on. Setting the
+                           GTA3SC_SERVER environment variable to this path
+                           makes gta3sc forward its command line to the server.
 
 Language Options:
   -fswitch                 Enables the SWITCH statement.
@@ -106,6 +130,8 @@ enum class Action
     Decompile,
     QueryConfigPath,
     QueryModels,
+    Link,
+    ConfigCompile,
 };
 
 
@@ -119,9 +145,17 @@ struct ConfigInfo
 {
     std::string           config_name;
     std::vector<fs::path> add_config_files;
+    bool                  use_cache = true;
 };
 
-bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data, ConfigInfo& conf, Options& options)
+struct ModeInfo
+{
+    fs::path    batch;
+    bool        watch = false;
+};
+
+bool parse_args(char**& argv, fs::path& input, fs::path& output, ModeInfo& mode, DataInfo& data, ConfigInfo& conf,
+                Options& options, FILE* errstream)
 {
     try
     {
@@ -134,7 +168,7 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
             {
                 if(!input.empty())
                 {
-                    fprintf(stderr, "gta3sc: error: input file appears twice\n");
+                    fprintf(errstream, "gta3sc: error: input file appears twice\n");
                     return false;
                 }
 
@@ -155,6 +189,14 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
             {
                 output = o;
             }
+            else if(const char* manifest = optget(argv, nullptr, "--batch", 1))
+            {
+                mode.batch = manifest;
+            }
+            else if(optget(argv, nullptr, "--watch", 0))
+            {
+                mode.watch = true;
+            }
             else if(optget(argv, nullptr, "-pedantic-errors", 0))
             {
                 options.pedantic = true;
@@ -168,11 +210,23 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
             {
                 options.guesser = true;
             }
+            else if(const char* jobs = optget(argv, "-j", nullptr, 1))
+            {
+                try
+                {
+                    options.jobs = std::stoul(jobs);
+                }
+                catch(const std::logic_error&)
+                {
+                    fprintf(errstream, "gta3sc: error: argument '-j' expects an integer, got '%s'\n", jobs);
+                    return false;
+                }
+            }
             else if(const char* info = optget(argv, nullptr, "--expect-var", 1))
             {
                 if(!options.push_expect_var(info))
                 {
-                    fprintf(stderr, "gta3sc: error: failed to parse --expect-var entry\n");
+                    fprintf(errstream, "gta3sc: error: failed to parse --expect-var entry\n");
                     return false;
                 }
             }
@@ -205,12 +259,12 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
                     args.emplace_back(nullptr);
 
                     char** argv2 = args.data();
-                    if(!parse_args(argv2, input, output, data, conf, options))
+                    if(!parse_args(argv2, input, output, mode, data, conf, options, errstream))
                         return false;
                 }
                 else
                 {
-                    fprintf(stderr, "gta3sc: error: config path is missing commandline.txt file\n");
+                    fprintf(errstream, "gta3sc: error: config path is missing commandline.txt file\n");
                     return false;
                 }
             }
@@ -218,6 +272,14 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
             {
                 conf.add_config_files.emplace_back(path);
             }
+            else if(optget(argv, nullptr, "--no-config-cache", 0))
+            {
+                conf.use_cache = false;
+            }
+            else if(const char* path = optget(argv, nullptr, "--build-cache", 1))
+            {
+                options.build_cache = path;
+            }
             else if(const char* path = optget(argv, nullptr, "--datadir", 1))
             {
                 data.datadir = path;
@@ -234,7 +296,7 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
                     options.error_format = Options::ErrorFormat::JSON;
                 else
                 {
-                    fprintf(stderr, "gta3sc: error: invalid error-format\n");
+                    fprintf(errstream, "gta3sc: error: invalid error-format\n");
                     return false;
                 }
             }
@@ -248,7 +310,7 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
                     options.header = Options::HeaderVersion::GTASA;
                 else
                 {
-                    fprintf(stderr, "gta3sc: error: invalid header version, must be 'gta3', 'gtavc' or 'gtasa'\n");
+                    fprintf(errstream, "gta3sc: error: invalid header version, must be 'gta3', 'gtavc' or 'gtasa'\n");
                     return false;
                 }
             }
@@ -355,6 +417,10 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
             {
                 options.fsyntax_only = true;
             }
+            else if(optget(argv, nullptr, "-c", 0))
+            {
+                options.emit_object = true;
+            }
             else if(optflag(argv, "-emit-ir2", nullptr))
             {
                 options.emit_ir2 = true;
@@ -409,7 +475,7 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
             }
             else
             {
-                fprintf(stderr, "gta3sc: error: unregonized argument '%s'\n", *argv);
+                fprintf(errstream, "gta3sc: error: unregonized argument '%s'\n", *argv);
                 return false;
             }
         }
@@ -418,26 +484,248 @@ bool parse_args(char**& argv, fs::path& input, fs::path& output, DataInfo& data,
     }
     catch(const invalid_opt& e)
     {
-        fprintf(stderr, "gta3sc: error: %s\n", e.what());
+        fprintf(errstream, "gta3sc: error: %s\n", e.what());
         return false;
     }
 }
 
+/// Loads the commands from the precompiled config of `config_files`, or from the XML files themselves
+/// if there's no such precompiled config (or it is outdated), in which case it gets (re)built.
+static Commands load_commands(const ConfigInfo& conf, const std::vector<fs::path>& config_files)
+{
+    if(!conf.use_cache)
+        return Commands::from_xml(conf.config_name, config_files);
+
+    auto cache_file = Commands::cache_file_path(conf.config_name, config_files);
+    if(auto opt_commands = Commands::from_cache(cache_file, conf.config_name, config_files))
+        return std::move(*opt_commands);
+
+    Commands commands = Commands::from_xml(conf.config_name, config_files);
+    commands.write_cache(cache_file, conf.config_name, config_files); // failing to write is fine, e.g. read-only cache path.
+    return commands;
+}
+
+/// Makes the relative paths given in the command line relative to `cwd` instead of to the working directory.
+static void resolve_paths(const fs::path& cwd, fs::path& input, fs::path& output,
+                          DataInfo& data, ConfigInfo& conf, Options& options)
+{
+    auto resolve = [&](fs::path& path) {
+        if(!path.empty() && path.is_relative() && path != "-")
+            path = cwd / path;
+    };
+
+    resolve(input);
+    resolve(output);
+    resolve(data.datadir);
+    resolve(options.build_cache);
+
+    // only './' and '../' configuration files are relative to the working directory (see `Commands::config_file_path`).
+    for(auto& path : conf.add_config_files)
+    {
+        auto begin = path.begin();
+        if(begin != path.end() && (*begin == "." || *begin == ".."))
+            resolve(path);
+    }
+}
+
+bool Setup::inputs_changed() const
+{
+    return std::any_of(this->inputs.begin(), this->inputs.end(), [](const FileStamp& input) {
+        return !(FileStamp::of(input.path) == input);
+    });
+}
+
+/// Loads the game configuration and data files a compilation needs.
+///
+/// \throws ConfigError on failure.
+static auto load_setup(const DataInfo& data, const ConfigInfo& conf, const std::vector<fs::path>& config_files) -> Setup
+{
+    insensitive_map<std::string, uint32_t> default_models, level_models;
+    std::vector<FileStamp> inputs;
+
+    // the stamps are taken before reading the files, thus a change made while loading is noticed next time.
+    for(auto& path : config_files)
+        inputs.emplace_back(FileStamp::of(Commands::config_file_path(conf.config_name, path)));
+
+    if(!data.datadir.empty())
+    {
+        inputs.emplace_back(FileStamp::of(data.datadir / "default.dat"));
+        default_models = load_dat(data.datadir / "default.dat", true, &inputs);
+        inputs.emplace_back(FileStamp::of(data.datadir / data.levelfile));
+        level_models   = load_dat(data.datadir / data.levelfile, false, &inputs);
+    }
+
+    auto commands = load_commands(conf, config_files);
+    commands.add_default_models(default_models);
+
+    return Setup { std::move(commands), std::move(default_models), std::move(level_models), std::move(inputs) };
+}
+
+/// Reads everything written into the temporary file `stream`.
+static std::string read_temp_stream(FILE* stream)
+{
+    std::string data;
+    char buffer[4096];
+
+    fflush(stream);
+    rewind(stream);
+    while(size_t count = fread(buffer, 1, sizeof(buffer), stream))
+        data.append(buffer, count);
+
+    return data;
+}
+
+/// Compiles every entry of the `manifest` file in parallel, each with its own `ProgramContext`.
+///
+/// Each non-empty line of the manifest (except those starting with '#') is a command line to compile, which is
+/// appended to the `args` of the batch. The diagnostics of each entry are written in manifest order.
+static int run_batch(const fs::path& manifest, const std::vector<std::string>& args, const fs::path& cwd,
+                     FILE* outstream, FILE* errstream, SetupCache* setups, bool long_lived)
+{
+    auto opt_data = read_file_utf8(manifest);
+    if(!opt_data)
+    {
+        fprintf(errstream, "gta3sc: error: failed to read batch manifest '%s'\n", manifest.generic_u8string().c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> shared;
+    for(auto it = args.begin(); it != args.end(); ++it)
+    {
+        if(*it == "--batch")
+        {
+            if(std::next(it) != args.end()) ++it;
+            continue;
+        }
+        if(!it->compare(0, 8, "--batch="))
+            continue;
+        shared.emplace_back(*it);
+    }
+
+    std::vector<std::vector<std::string>> entries;
+    std::vector<size_t> entry_lines;    //< The manifest line of each entry.
+
+    auto& manifest_data = *opt_data;
+    size_t lineno = 0;
+    for(auto it = manifest_data.begin(), end = manifest_data.end(); it != end; )
+    {
+        ++lineno;
+        auto line_end = std::find(it, end, '\n');
+
+        std::vector<std::string> entry;
+        for(auto arg = std::find_if_not(it, line_end, ::isspace); arg != line_end && *arg != '#';
+            arg = std::find_if_not(arg, line_end, ::isspace))
+        {
+            auto arg_end = std::find_if(arg, line_end, ::isspace);
+            entry.emplace_back(arg, arg_end);
+            arg = arg_end;
+        }
+
+        if(!entry.empty())
+        {
+            entries.emplace_back(std::move(entry));
+            entry_lines.emplace_back(lineno);
+        }
+
+        it = (line_end != end? std::next(line_end) : end);
+    }
+
+    // every entry sharing a config shares its commands and models.
+    SetupCache batch_setups;
+    if(setups == nullptr)
+        setups = &batch_setups;
+
+    struct EntryResult
+    {
+        int         status = EXIT_FAILURE;
+        std::string output;
+        std::string diagnostics;
+    };
+
+    std::vector<EntryResult> results(entries.size());
+
+    ThreadPool::global().parallel_for(size_t(0), entries.size(), [&](size_t i)
+    {
+        // an entry must finish for the batch to finish.
+        if(std::find(entries[i].begin(), entries[i].end(), "--watch") != entries[i].end())
+        {
+            results[i].diagnostics = fmt::format("{}:{}: error: --watch cannot be used in a batch entry\n",
+                                                 manifest.generic_u8string(), entry_lines[i]);
+            return;
+        }
+
+        std::vector<char*> argv;
+        argv.reserve(2 + shared.size() + entries[i].size());
+        argv.emplace_back(const_cast<char*>("compile"));
+        for(auto& arg : shared) argv.emplace_back(&arg[0]);
+        for(auto& arg : entries[i]) argv.emplace_back(&arg[0]);
+        argv.emplace_back(nullptr);
+
+        FILE* entry_out = std::tmpfile();
+        FILE* entry_err = std::tmpfile();
+
+        if(entry_out && entry_err)
+        {
+            results[i].status = run_driver(argv.data(), cwd, entry_out, entry_err, setups, long_lived);
+            results[i].output = read_temp_stream(entry_out);
+            results[i].diagnostics = read_temp_stream(entry_err);
+        }
+        else
+        {
+            results[i].diagnostics = "gta3sc: error: failed to create temporary file\n";
+        }
+
+        if(entry_out) fclose(entry_out);
+        if(entry_err) fclose(entry_err);
+    });
+
+    size_t num_failed = 0;
+    for(auto& result : results)
+    {
+        fwrite(result.output.data(), 1, result.output.size(), outstream);
+        fwrite(result.diagnostics.data(), 1, result.diagnostics.size(), errstream);
+        if(result.status != EXIT_SUCCESS)
+            ++num_failed;
+    }
+
+    if(num_failed != 0)
+    {
+        fprintf(errstream, "gta3sc: error: %zu of %zu batch entries failed\n", num_failed, results.size());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char** argv)
 {
-    // Due to main() not having a ProgramContext yet, error reporting must be done using fprintf(stderr, ...).
+    ++argv;
+
+    if(*argv && !strcmp(*argv, "serve"))
+        return serve(argv + 1);
+
+    if(const char* socket_path = getenv("GTA3SC_SERVER"))
+    {
+        if(auto status = run_on_server(socket_path, argv))
+            return *status;
+    }
+
+    return run_driver(argv, fs::path(), stdout, stderr, nullptr, false);
+}
+
+int run_driver(char** argv, const fs::path& cwd, FILE* outstream, FILE* errstream, SetupCache* setups, bool long_lived)
+{
+    // Due to run_driver() not having a ProgramContext yet, error reporting must be done using fprintf(errstream, ...).
 
     Action action = Action::None;
     Options options;
     fs::path input, output;
+    ModeInfo mode;
     ConfigInfo conf;
     DataInfo data;
 
+    shared_ptr<const Setup> setup;
     optional<ProgramContext> program; // delay construction of ProgramContext
-    std::map<std::string, uint32_t, iless> default_models;
-    std::map<std::string, uint32_t, iless> level_models;
-
-    ++argv;
 
     if(*argv && **argv != '-')
     {
@@ -455,22 +743,44 @@ int main(int argc, char** argv)
         {
             ++argv;
             action = Action::QueryConfigPath;
-            fprintf(stdout, "%s", config_path().generic_u8string().c_str());
+            fprintf(outstream, "%s", config_path().generic_u8string().c_str());
             return EXIT_SUCCESS;
         }
+        else if(!strcmp(*argv, "link"))
+        {
+            ++argv;
+            action = Action::Link;
+        }
         else if(!strcmp(*argv, "query-models"))
         {
             ++argv;
             action = Action::QueryModels;
         }
+        else if(!strcmp(*argv, "config-compile"))
+        {
+            ++argv;
+            action = Action::ConfigCompile;
+        }
     }
 
-    if(!parse_args(argv, input, output, data, conf, options))
+    // parse_args(...) modifies the arguments, thus keep a copy of them for the entries of a batch or watch.
+    std::vector<std::string> args;
+    for(char** arg = argv; *arg; ++arg)
+        args.emplace_back(*arg);
+
+    if(!parse_args(argv, input, output, mode, data, conf, options, errstream))
         return EXIT_FAILURE;
 
+    if(!cwd.empty())
+        resolve_paths(cwd, input, output, data, conf, options);
+
+    // A long-lived process (watch or server) must not die because a source file got truncated while mapped.
+    if(long_lived)
+        options.map_sources = false;
+
     if(options.help)
     {
-        fprintf(stdout, "%s", GTA3SC_HELP_MESSAGE);
+        fprintf(outstream, "%s", GTA3SC_HELP_MESSAGE);
         return EXIT_SUCCESS;
     }
 
@@ -478,19 +788,56 @@ int main(int argc, char** argv)
     {
         auto version = GTA3SC_GIT_DESCRIBE_TAG[0] != '\0'? std::string(GTA3SC_GIT_DESCRIBE_TAG) :
                        GTA3SC_GIT_SHA1[0] != '\0'? std::string(GTA3SC_GIT_BRANCH) + '-' + GTA3SC_GIT_SHA1 : "unknown-version";
-        fprintf(stdout, "%s %s", "gta3sc", version.c_str());
+        fprintf(outstream, "%s %s", "gta3sc", version.c_str());
         return EXIT_SUCCESS;
     }
 
-    if(input.empty())
+    // Compiles sharing setups (i.e. server requests and batch entries) must eventually finish.
+    if(setups && mode.watch)
     {
-        fprintf(stderr, "gta3sc: error: no input file\n");
+        fprintf(errstream, "gta3sc: error: --watch is only available to a compilation of its own\n");
+        return EXIT_FAILURE;
+    }
+
+    // The compile server runs every request on its own global pool (see `serve`).
+    if(!setups)
+        ThreadPool::set_global_concurrency(options.jobs);
+
+    if(!mode.batch.empty())
+    {
+        if(action != Action::None && action != Action::Compile)
+        {
+            fprintf(errstream, "gta3sc: error: --batch is only available when compiling\n");
+            return EXIT_FAILURE;
+        }
+
+        if(!input.empty())
+        {
+            fprintf(errstream, "gta3sc: error: input file given together with --batch\n");
+            return EXIT_FAILURE;
+        }
+
+        if(mode.watch)
+        {
+            fprintf(errstream, "gta3sc: error: --watch cannot be used together with --batch\n");
+            return EXIT_FAILURE;
+        }
+
+        if(!cwd.empty() && mode.batch.is_relative())
+            mode.batch = cwd / mode.batch;
+
+        return run_batch(mode.batch, args, cwd, outstream, errstream, setups, long_lived);
+    }
+
+    if(input.empty() && action != Action::ConfigCompile)
+    {
+        fprintf(errstream, "gta3sc: error: no input file\n");
         return EXIT_FAILURE;
     }
 
     if(conf.config_name.empty())
     {
-        fprintf(stderr, "gta3sc: error: no game config specified [--config=<name>]\n");
+        fprintf(errstream, "gta3sc: error: no game config specified [--config=<name>]\n");
         return EXIT_FAILURE;
     }
 
@@ -507,42 +854,50 @@ int main(int argc, char** argv)
             action = Action::Decompile;
         else if(iequal_to()(extension, ".cm"))
             action = Action::Decompile;
+        else if(iequal_to()(extension, ".o"))
+            action = Action::Link;
         else
         {
-            fprintf(stderr, "gta3sc: error: could not infer action from input extension (compile/decompile)\n");
+            fprintf(errstream, "gta3sc: error: could not infer action from input extension (compile/decompile/link)\n");
             return EXIT_FAILURE;
         }
     }
 
-    if(action != Action::QueryModels)
+    if(action != Action::QueryModels && action != Action::ConfigCompile)
     {
+        if(options.emit_object && (options.emit_ir2 || options.oatc))
+        {
+            fprintf(errstream, "gta3sc: error: -c cannot be used together with -emit-ir2 or -moatc\n");
+            return EXIT_FAILURE;
+        }
+
         if(!options.guesser && options.fswitch)
         {
-            fprintf(stderr, "gta3sc: error: use of -fswitch only available in guesser mode [--guesser]\n");
+            fprintf(errstream, "gta3sc: error: use of -fswitch only available in guesser mode [--guesser]\n");
             return EXIT_FAILURE;
         }
 
         if(!options.guesser && options.farrays)
         {
-            fprintf(stderr, "gta3sc: error: use of -farrays only available in guesser mode [--guesser]\n");
+            fprintf(errstream, "gta3sc: error: use of -farrays only available in guesser mode [--guesser]\n");
             return EXIT_FAILURE;
         }
 
         if(!options.guesser && options.fconst)
         {
-            fprintf(stderr, "gta3sc: error: use of -fconst only available in guesser mode [--guesser]\n");
+            fprintf(errstream, "gta3sc: error: use of -fconst only available in guesser mode [--guesser]\n");
             return EXIT_FAILURE;
         }
 
         if(!options.guesser && options.streamed_scripts)
         {
-            fprintf(stderr, "gta3sc: error: use of -fstreamed_scripts only available in guesser mode [--guesser]\n");
+            fprintf(errstream, "gta3sc: error: use of -fstreamed_scripts only available in guesser mode [--guesser]\n");
             return EXIT_FAILURE;
         }
 
         if(!options.guesser && options.skip_cutscene)
         {
-            fprintf(stderr, "gta3sc: error: use of -fskip-cutscene only available in guesser mode [--guesser]\n");
+            fprintf(errstream, "gta3sc: error: use of -fskip-cutscene only available in guesser mode [--guesser]\n");
             return EXIT_FAILURE;
         }
     }
@@ -559,22 +914,11 @@ int main(int argc, char** argv)
                 data.levelfile = "gta_vc.dat";
             else
             {
-                fprintf(stderr, "gta3sc: error: could not find level file (gta*.dat) in datadir '%s'\n",
+                fprintf(errstream, "gta3sc: error: could not find level file (gta*.dat) in datadir '%s'\n",
                             data.datadir.generic_u8string().c_str());
                 return EXIT_FAILURE;
             }
         }
-
-        try
-        {
-            default_models = load_dat(data.datadir / "default.dat", true);
-            level_models   = load_dat(data.datadir / data.levelfile, false);
-        }
-        catch(const ConfigError& e)
-        {
-            fprintf(stderr, "gta3sc: error: %s\n", e.what());
-            return EXIT_FAILURE;
-        }
     }
 
     try
@@ -590,20 +934,84 @@ int main(int argc, char** argv)
         if(options.cleo) config_files.emplace_back("cleo.xml");
         std::move(conf.add_config_files.begin(), conf.add_config_files.end(), std::back_inserter(config_files));
 
-        Commands commands = Commands::from_xml(conf.config_name, config_files);
-        commands.add_default_models(default_models);
+        if(mode.watch)
+        {
+            if(action != Action::Compile)
+            {
+                fprintf(errstream, "gta3sc: error: --watch is only available when compiling\n");
+                return EXIT_FAILURE;
+            }
+
+            // the objects would have to be linked again anyway, which watching does not do.
+            if(options.emit_object)
+            {
+                fprintf(errstream, "gta3sc: error: --watch cannot be used together with -c\n");
+                return EXIT_FAILURE;
+            }
+
+            // the build cache is what spares unchanged scripts from being parsed again on every change.
+            // it is kept in the cache directory of the user, since a shared one (e.g. /tmp) could be
+            // planted with trees by someone else. without such directory, every change parses everything.
+            if(options.build_cache.empty() && !user_cache_path().empty())
+            {
+                std::error_code ec;
+                auto key = fs::absolute(input, ec).generic_u8string();
+                auto cache_dir = user_cache_path() / "watch" / fmt::format("{:016x}", fnv1a64(key.data(), key.size()));
+                args.emplace_back("--build-cache=" + cache_dir.u8string());
+            }
+
+            std::vector<fs::path> config_paths;
+            config_paths.reserve(config_files.size());
+            for(auto& path : config_files)
+                config_paths.emplace_back(Commands::config_file_path(conf.config_name, path));
+
+            return watch(args, input, config_paths, cwd, outstream, errstream);
+        }
+
+        if(action == Action::ConfigCompile)
+        {
+            auto cache_file = Commands::cache_file_path(conf.config_name, config_files);
+            Commands commands = Commands::from_xml(conf.config_name, config_files);
+            if(!commands.write_cache(cache_file, conf.config_name, config_files))
+            {
+                fprintf(errstream, "gta3sc: error: failed to write precompiled config %s\n", cache_file.generic_u8string().c_str());
+                return EXIT_FAILURE;
+            }
+            fprintf(outstream, "%s\n", cache_file.generic_u8string().c_str());
+            return EXIT_SUCCESS;
+        }
+
+        if(setups)
+        {
+            std::string key = conf.config_name;
+            key += '\n';
+            key += conf.use_cache? "cache" : "no-cache";
+            key += '\n';
+            key += (data.datadir / data.levelfile).generic_u8string();
+            for(auto& path : config_files)
+            {
+                key += '\n';
+                key += path.generic_u8string();
+            }
+
+            setup = setups->get(key, [&] { return load_setup(data, conf, config_files); });
+        }
+        else
+        {
+            setup = std::make_shared<const Setup>(load_setup(data, conf, config_files));
+        }
 
-        program.emplace(std::move(options), std::move(commands));
-        program->setup_models(std::move(default_models), std::move(level_models));
+        program.emplace(std::move(options), setup->commands, errstream, outstream);
+        program->setup_models(setup->default_models, setup->level_models);
     }
     catch(const ConfigError& e)
     {
-        fprintf(stderr, "gta3sc: error: %s\n", e.what());
+        fprintf(errstream, "gta3sc: error: %s\n", e.what());
         return EXIT_FAILURE;
     }
 
     fs::path conf_path = config_path();
-    //fprintf(stderr, "gta3sc: using '%s' as configuration path\n", conf_path.generic_u8string().c_str());
+    //fprintf(errstream, "gta3sc: using '%s' as configuration path\n", conf_path.generic_u8string().c_str());
 
     switch(action)
     {
@@ -611,22 +1019,25 @@ int main(int argc, char** argv)
             return compile(input, output, *program);
         case Action::Decompile:
             return decompile(input, output, *program);
+        case Action::Link:
+            return link_object(input, output, *program);
         case Action::QueryModels:
         {
             if(input == "default" || input == "all")
             {
-                fprintf(stdout, "=DEFAULT\n");
-                for(auto& pair : program->commands.get_defaultmodel_enum()->values)
+                fprintf(outstream, "=DEFAULT\n");
+                auto& defaultmodels = *program->commands.get_defaultmodel_enum();
+                for(auto pair : sorted_by_name(defaultmodels.values))
                 {
-                    fprintf(stdout, "%s %u\n", pair.first.c_str(), pair.second);
+                    fprintf(outstream, "%s %u\n", defaultmodels.name_of(pair->first).c_str(), pair->second);
                 }
             }
             if(input == "level" || input == "all")
             {
-                fprintf(stdout, "=LEVEL\n");
+                fprintf(outstream, "=LEVEL\n");
                 for(auto& pair : program->level_models)
                 {
-                    fprintf(stdout, "%s %u\n", pair.first.c_str(), pair.second);
+                    fprintf(outstream, "%s %u\n", pair.first.c_str(), pair.second);
                 }
             }
             return EXIT_SUCCESS;
@@ -4,6 +4,7 @@
 #include "symtable.hpp"
 #include "codegen.hpp"
 #include "cdimage.hpp"
+#include "object_file.hpp"
 
 using RequiredFrom = std::vector<weak_ptr<const Script>>;
 using IncluderPair = std::pair<shared_ptr<Script>, IncluderTable>;
@@ -30,22 +31,49 @@ namespace
 
     auto scan_symbols(IncluderTable&&, std::vector<shared_ptr<Script>>& scripts, ProgramContext& program) -> SymTable;
 
-    auto generate_ir(const SymTable&, std::vector<shared_ptr<Script>>& scripts, ProgramContext& program) -> std::vector<CodeGenerator>;
+    auto generate_ir(SymTable&, std::vector<shared_ptr<Script>>& scripts, ProgramContext& program) -> std::vector<CodeGenerator>;
 
-    void generate_scm(std::vector<CodeGenerator>&);
+    void generate_scm(std::vector<CodeGenerator>&, std::vector<shared_ptr<Script>>& scripts, ProgramContext& program);
 
-    auto build_headers(std::vector<CodeGenerator>& gens, const SymTable& symbols, const std::vector<std::string>& models,
-                       const shared_ptr<const Script> main, std::vector<shared_ptr<Script>>& scripts,
-                       ProgramContext& program) -> MultiFileHeaderList;
+    auto build_headers(std::vector<CodeGenerator>& gens, size_t size_global_vars, uint32_t maximum_mission_local,
+                       const std::vector<std::string>& models, const shared_ptr<const Script> main,
+                       std::vector<shared_ptr<Script>>& scripts, ProgramContext& program) -> MultiFileHeaderList;
 
-    void compute_offsets(std::vector<CodeGenerator>& gens, const MultiFileHeaderList& multi_headers,
-                         std::vector<shared_ptr<Script>>& scripts, ProgramContext& program);
+    auto find_maximum_mission_local(const std::vector<shared_ptr<Script>>& scripts) -> uint32_t;
 
-    template<typename Writeable1, typename Writeable2> static
-    void generate_output(const std::vector<CodeGenerator>& gens,
-                         const MultiFileHeaderList& multi_headers,
-                         Writeable1& main_scm, Writeable2& script_img, bool has_script_img,
-                         ProgramContext& program);
+    /// Where each script goes in the output files.
+    struct OutputLayout
+    {
+        struct Placement
+        {
+            bool    in_script_img = false;
+            size_t  headers_offset = 0;     //< Offset of the script headers (if any) in its output file.
+            size_t  code_offset = 0;        //< Offset of the script code in its output file.
+        };
+
+        bool                    has_script_img = false;
+        size_t                  main_size = 0;
+        size_t                  img_size = 0;
+        std::vector<Placement>  placements;     //< In the same order as the code generators.
+        CdHeader                cd_header;
+        std::vector<CdEntry>    directory;      //< Directory of the script.img (if any).
+    };
+
+    /// Places the code of the `i`-th code generator into `output`, which has room for exactly its code size.
+    using EmitCode = std::function<void(size_t i, void* output)>;
+
+    /// Checks whether the output file at `path` is a regular file or does not exist yet (unlike e.g. a pipe).
+    bool is_regular_output(const fs::path& path);
+
+    /// Writes the output files of the code generators, removing any partially written one on failure.
+    void write_output(const std::vector<CodeGenerator>& gens, const MultiFileHeaderList& multi_headers,
+                      const fs::path& output, bool use_script_img, const EmitCode& emit_code, ProgramContext& program);
+
+    auto compute_output_layout(const std::vector<CodeGenerator>& gens, bool has_script_img) -> OutputLayout;
+
+    void generate_output(const std::vector<CodeGenerator>& gens, const MultiFileHeaderList& multi_headers,
+                         const OutputLayout& layout, uint8_t* main_scm, uint8_t* script_img,
+                         const EmitCode& emit_code, ProgramContext& program);
 
     void check_expect_vars(const Script& main, const SymTable&, ProgramContext&);
 }
@@ -55,7 +83,9 @@ int compile(fs::path input, fs::path output, ProgramContext& program)
     if(output.empty())
     {
         output = fs::path(input).replace_extension([&] {
-            if(program.opt.emit_ir2)
+            if(program.opt.emit_object)
+                return ".o";
+            else if(program.opt.emit_ir2)
                 return ".ir2";
             else if(program.opt.output_cleo)
                 return program.opt.mission_script? ".cm" : ".cs";
@@ -100,16 +130,17 @@ int compile(fs::path input, fs::path output, ProgramContext& program)
         if(program.has_error())
             throw ProgramFailure();
 
-        std::for_each(scripts.begin(), scripts.end(), [&](const auto& script) {
-            script->annotate_tree(symbols, program);
+        // Each script only reads the symbol table and annotates its own tree, so this can be done concurrently.
+        program.parallel_for(0, scripts.size(), [&](size_t i) {
+            scripts[i]->annotate_tree(symbols, program);
         });
 
         if(program.has_error())
             throw ProgramFailure();
 
-        std::for_each(scripts.begin(), scripts.end(), [&](const auto& script) {
-            script->compute_scope_outputs(symbols, program);
-            script->fix_call_scope_variables(program);
+        program.parallel_for(0, scripts.size(), [&](size_t i) {
+            scripts[i]->compute_scope_outputs(symbols, program);
+            scripts[i]->fix_call_scope_variables(program);
         });
 
         if(program.has_error())
@@ -137,74 +168,126 @@ int compile(fs::path input, fs::path output, ProgramContext& program)
         if(program.opt.fsyntax_only)
             return EXIT_SUCCESS;
 
-        auto multi_headers = build_headers(gens, symbols, models, main, scripts, program);
+        // Each script goes into an object of its own, with its labels, global variables and models left for the link
+        // step, thus the scripts aren't placed yet.
+        if(program.opt.emit_object)
+        {
+            generate_scm(gens, scripts, program);
 
-        compute_offsets(gens, multi_headers, scripts, program);
-        
-        generate_scm(gens);
+            if(program.has_error())
+                throw ProgramFailure();
+
+            auto objects = ObjectFile::from_program(gens, symbols, output, program);
+
+            if(program.has_error())
+                throw ProgramFailure();
+
+            for(size_t i = 0; i < objects.size(); ++i)
+            {
+                auto object_path = (i == 0? output : output.parent_path() / objects[0].objects[i - 1]);
+                if(!objects[i].write(object_path))
+                {
+                    // the objects are only linked together, thus do not leave some of them behind.
+                    std::error_code ec;
+                    for(size_t k = 0; k < i; ++k)
+                        fs::remove(k == 0? output : output.parent_path() / objects[0].objects[k - 1], ec);
+
+                    program.fatal_error(nocontext, "failed to write object file '{}'", object_path.generic_u8string());
+                }
+            }
+
+            return EXIT_SUCCESS;
+        }
+
+        auto multi_headers = build_headers(gens, symbols.size_global_vars(), find_maximum_mission_local(scripts),
+                                           models, main, scripts, program);
+
+        generate_scm(gens, scripts, program);
 
         if(program.has_error())
             throw ProgramFailure();
 
-        if(program.opt.emit_ir2)
-        {
-            FILE *outstream = 0;
-            std::vector<uint8_t> main_scm;
-            std::vector<uint8_t> script_img;
+        Script::compute_script_offsets(scripts, multi_headers);
+        symbols.compute_label_offsets();
 
-            auto guard = make_scope_guard([&] {
-                if(outstream && outstream != stdout) fclose(outstream);
-            });
+        write_output(gens, multi_headers, output, use_script_img, [&](size_t i, void* output) {
+            gens[i].relocate_into(output);
+        }, program);
+        
+        if(program.has_error())
+            throw ProgramFailure();
 
-            outstream = (output != "-"? u8fopen(output, "wb") : stdout);
-            if(outstream == nullptr)
-                program.fatal_error(nocontext, "failed to open output for writing");
+        return EXIT_SUCCESS;
+    }
+    catch(const ProgramFailure&)
+    {
+        if(auto logstream = program.log_stream())
+            fprintf(logstream, "gta3sc: compilation failed\n");
+        return EXIT_FAILURE;
+    }
+}
 
-            bool is_first_line = true;
-            auto print_ir2_line = [&](const std::string& line)
-            {
-                if(is_first_line)
-                {
-                    is_first_line = false;
-                    fprintf(outstream, "%s", line.c_str());
-                }
-                else
-                {
-                    fprintf(outstream, "\n%s", line.c_str());
-                }
-            };
+int link_object(fs::path input, fs::path output, ProgramContext& program)
+{
+    if(output.empty())
+    {
+        output = fs::path(input).replace_extension([&] {
+            if(program.opt.emit_ir2)
+                return ".ir2";
+            else if(program.opt.output_cleo)
+                return program.opt.mission_script? ".cm" : ".cs";
+            else
+                return ".scm";
+        }());
+    }
 
-            generate_output(gens, multi_headers, main_scm, script_img, use_script_img, program);
+    try
+    {
+        auto linked = LinkedProgram::link(input, program);
+        if(!linked)
+            throw ProgramFailure();
 
-            auto status = decompile(main_scm.data(), main_scm.size(),
-                                    script_img.data(), script_img.size(), program,
-                                    Options::Lang::IR2, print_ir2_line);
-            if(!status)
-                throw ProgramFailure();
-        }
-        else
-        {
-            FILE *main_scm = 0, *script_img = 0;
+        const auto use_script_img = (program.opt.streamed_scripts && !program.opt.headerless);
 
-            auto guard = make_scope_guard([&] {
-                if(main_scm) fclose(main_scm);
-                if(script_img) fclose(script_img);
-            });
+        std::vector<shared_ptr<Script>> scripts;
+        scripts.reserve(linked->objects.size());
 
-            main_scm = u8fopen(output, "wb");
-            if(main_scm == nullptr)
-                program.fatal_error(nocontext, "failed to open output for writing");
+        for(auto& object : linked->objects)
+        {
+            scripts.emplace_back(Script::from_object(object.path, object.type, program));
+            scripts.back()->mission_id = object.mission_id;
+            scripts.back()->streamed_id = object.streamed_id;
+            scripts.back()->code_size = static_cast<uint32_t>(object.code.size());
+        }
 
-            if(use_script_img)
+        for(size_t i = 0; i < scripts.size(); ++i)
+        {
+            for(auto& child : linked->objects[i].children)
             {
-                script_img = u8fopen(fs::path(output).replace_filename("script.img"), "wb");
-                if(!script_img)
-                    program.fatal_error(nocontext, "failed to open script.img for writing");
+                auto it = std::find_if(linked->objects.begin(), linked->objects.end(), [&](const ObjectFile& object) {
+                    return iequal_to()(object.name, child);
+                });
+                scripts[i]->add_children(scripts[std::distance(linked->objects.begin(), it)]);
             }
-
-            generate_output(gens, multi_headers, main_scm, script_img, use_script_img, program);
         }
-        
+
+        // the code comes from the object, thus there are no symbols to generate it from.
+        SymTable symbols;
+
+        std::vector<CodeGenerator> gens;
+        gens.reserve(scripts.size());
+        for(auto& script : scripts)
+            gens.emplace_back(script, CompiledIR(), symbols, program);
+
+        auto multi_headers = build_headers(gens, linked->size_global_vars, linked->maximum_mission_local,
+                                           linked->models, scripts[0], scripts, program);
+
+        Script::compute_script_offsets(scripts, multi_headers);
+
+        write_output(gens, multi_headers, output, use_script_img, [&](size_t i, void* output) {
+            linked->relocate_into(i, output, scripts, program);
+        }, program);
+
         if(program.has_error())
             throw ProgramFailure();
 
@@ -212,7 +295,8 @@ int compile(fs::path input, fs::path output, ProgramContext& program)
     }
     catch(const ProgramFailure&)
     {
-        fprintf(stderr, "gta3sc: compilation failed\n");
+        if(auto logstream = program.log_stream())
+            fprintf(logstream, "gta3sc: linking failed\n");
         return EXIT_FAILURE;
     }
 }
@@ -236,11 +320,18 @@ auto read_scripts(const std::vector<std::string>& filenames, ScriptType type,
     std::vector<IncluderPair> output;
     output.reserve(filenames.size());
 
-    std::for_each(filenames.begin(), filenames.end(), [&](const auto& filename) {
-        if(auto ic_pair = read_script(filename, type, main, subdir, program))
-            output.emplace_back(std::move(*ic_pair));
+    std::vector<optional<IncluderPair>> results(filenames.size());
+
+    program.parallel_for(0, filenames.size(), [&](size_t i) {
+        results[i] = read_script(filenames[i], type, main, subdir, program);
     });
 
+    for(auto& ic_pair : results)
+    {
+        if(ic_pair)
+            output.emplace_back(std::move(*ic_pair));
+    }
+
     return output;
 }
 
@@ -251,20 +342,33 @@ auto read_extension_scripts(const Script& main, const Script::SubDir& subdir,
 
     insensitive_set<std::string> readen;
 
-    std::deque<std::string> to_read;
-    std::copy(ictable.extfiles.begin(), ictable.extfiles.end(), std::back_inserter(to_read));
+    // Scripts are read in waves, all the scripts in a wave being read in parallel. The next wave is made of the
+    // GOSUB_FILEs found in the current one, which keeps the same (breadth-first) order of a sequential read.
+    std::vector<std::string> to_read = ictable.extfiles;
 
     while(!to_read.empty())
     {
-        auto topname = std::move(to_read.front());
-        to_read.pop_front();
+        std::vector<std::string> wave;
+        for(auto& name : to_read)
+        {
+            if(!readen.count(name) && std::none_of(wave.begin(), wave.end(), [&](const auto& a) { return iequal_to()(a, name); }))
+                wave.emplace_back(std::move(name));
+        }
+
+        std::vector<optional<IncluderPair>> results(wave.size());
+
+        program.parallel_for(0, wave.size(), [&](size_t i) {
+            results[i] = read_script(wave[i], ScriptType::MainExtension, main, subdir, program);
+        });
 
-        if(!readen.count(topname))
+        to_read.clear();
+
+        for(size_t i = 0; i < wave.size(); ++i)
         {
-            if(auto ic_pair = read_script(topname, ScriptType::MainExtension, main, subdir, program))
+            if(auto& ic_pair = results[i])
             {
                 output.emplace_back(std::move(*ic_pair));
-                readen.emplace(std::move(topname));
+                readen.emplace(std::move(wave[i]));
 
                 auto& script_ictable = output.back().second;
                 std::copy(script_ictable.extfiles.begin(), script_ictable.extfiles.end(), std::back_inserter(to_read));
@@ -349,12 +453,19 @@ void resolve_requires(const std::vector<RequiredPair>& require_info,
                       const Script& main, const Script::SubDir& subdir, ProgramContext& program)
 {
     auto req_scripts = insensitive_map<std::string, IncluderPair>();
-    std::for_each(require_info.begin(), require_info.end(), [&](const auto& vpair) {
-        if(auto opt = read_script(vpair.first, ScriptType::Required, main, subdir, program))
+    {
+        std::vector<optional<IncluderPair>> results(require_info.size());
+
+        program.parallel_for(0, require_info.size(), [&](size_t i) {
+            results[i] = read_script(require_info[i].first, ScriptType::Required, main, subdir, program);
+        });
+
+        for(size_t i = 0; i < require_info.size(); ++i)
         {
-            req_scripts.emplace(vpair.first, std::move(*opt));
+            if(results[i])
+                req_scripts.emplace(require_info[i].first, std::move(*results[i]));
         }
-    });
+    }
 
     // insert the required scripts into the `scripts` list.
     for(auto it = require_info.rbegin(); it != require_info.rend(); ++it)
@@ -394,24 +505,22 @@ auto scan_symbols(IncluderTable&& ictable, std::vector<shared_ptr<Script>>& scri
     SymTable symbols { std::move(ictable) };
     symbols.apply_offset_to_vars(2);
 
-    std::vector<SymTable> vec_symbols;
-    vec_symbols.reserve(scripts.size());
+    std::vector<SymTable> vec_symbols(scripts.size());
 
-    std::transform(scripts.begin(), scripts.end(), std::back_inserter(vec_symbols), [&](const auto& script) {
-        return SymTable::from_script(*script, program);
+    program.parallel_for(0, scripts.size(), [&](size_t i) {
+        vec_symbols[i] = SymTable::from_script(*scripts[i], program);
+        scripts[i]->size_global_vars = static_cast<uint32_t>(vec_symbols[i].size_global_vars() / 4);
     });
 
-    for(auto& other_table : vec_symbols)
-    {
-        symbols.merge(std::move(other_table), program);
-    }
+    symbols.merge(std::move(vec_symbols), program);
 
     symbols.build_script_table(scripts);
     return symbols;
 }
 
-auto build_headers(std::vector<CodeGenerator>& gens, const SymTable& symbols, const std::vector<std::string>& models,
-                   const shared_ptr<const Script> main, std::vector<shared_ptr<Script>>& scripts, ProgramContext& program) -> MultiFileHeaderList
+auto build_headers(std::vector<CodeGenerator>& gens, size_t size_global_vars, uint32_t maximum_mission_local,
+                   const std::vector<std::string>& models, const shared_ptr<const Script> main,
+                   std::vector<shared_ptr<Script>>& scripts, ProgramContext& program) -> MultiFileHeaderList
 {
     MultiFileHeaderList multi_headers;
 
@@ -450,7 +559,8 @@ auto build_headers(std::vector<CodeGenerator>& gens, const SymTable& symbols, co
 
     if(!program.opt.headerless)
     {
-        CompiledScmHeader hscm(program.opt.get_header<CompiledScmHeader::Version>(), symbols.size_global_vars(), models, scripts);
+        CompiledScmHeader hscm(program.opt.get_header<CompiledScmHeader::Version>(), size_global_vars, models, scripts,
+                               maximum_mission_local);
         multi_headers.add_header(main, std::move(hscm));
     }
 
@@ -475,85 +585,221 @@ auto build_headers(std::vector<CodeGenerator>& gens, const SymTable& symbols, co
     return multi_headers;
 }
 
-void compute_offsets(std::vector<CodeGenerator>& gens, const MultiFileHeaderList& multi_headers,
-                     std::vector<shared_ptr<Script>>& scripts, ProgramContext& program)
+auto find_maximum_mission_local(const std::vector<shared_ptr<Script>>& scripts) -> uint32_t
 {
-    assert(gens.size() == scripts.size());
-
-    for_loop(size_t(0), gens.size(), [&](size_t i) {
-        scripts[i]->code_size = gens[i].compute_labels();
-    });
-
-    Script::compute_script_offsets(scripts, multi_headers);
+    uint32_t maximum_mission_local = 0;
+    for(auto& sc : scripts)
+    {
+        if(sc->type == ScriptType::Mission)
+        {
+            auto pair = sc->find_maximum_locals();
+            maximum_mission_local = std::max({maximum_mission_local, pair.first, pair.second});
+        }
+    }
+    return maximum_mission_local;
 }
 
-auto generate_ir(const SymTable& symbols, std::vector<shared_ptr<Script>>& scripts, ProgramContext& program) -> std::vector<CodeGenerator>
+auto generate_ir(SymTable& symbols, std::vector<shared_ptr<Script>>& scripts, ProgramContext& program) -> std::vector<CodeGenerator>
 {
+    // Each compiler context reads only the symbol table and its own script (internal labels are local to the
+    // IR of the context), so the scripts can be lowered concurrently.
+    std::vector<CompiledIR> compiled(scripts.size());
+
+    program.parallel_for(0, scripts.size(), [&](size_t i) {
+        compiled[i] = CompilerContext::compile(scripts[i], symbols, program).get_data();
+    });
+
     std::vector<CodeGenerator> gens;
     gens.reserve(scripts.size());
 
-    std::transform(scripts.begin(), scripts.end(), std::back_inserter(gens), [&](const auto& script) {
-        return CodeGenerator { CompilerContext::compile(script, symbols, program), program };
-    });
+    for(size_t i = 0; i < scripts.size(); ++i)
+        gens.emplace_back(scripts[i], std::move(compiled[i]), symbols, program);
 
     return gens;
 }
 
-void generate_scm(std::vector<CodeGenerator>& gens)
+void generate_scm(std::vector<CodeGenerator>& gens, std::vector<shared_ptr<Script>>& scripts, ProgramContext& program)
 {
-    std::for_each(gens.begin(), gens.end(), [&](auto& gen) {
-        gen.generate();
+    assert(gens.size() == scripts.size());
+
+    program.parallel_for(0, gens.size(), [&](size_t i) {
+        scripts[i]->code_size = gens[i].generate();
     });
 }
 
-template<typename Writeable1, typename Writeable2>
-void generate_output(const std::vector<CodeGenerator>& gens,
-                     const MultiFileHeaderList& multi_headers,
-                     Writeable1& main_scm, Writeable2& script_img, bool has_script_img,
-                     ProgramContext& program)
+bool is_regular_output(const fs::path& path)
+{
+    std::error_code ec;
+    auto type = fs::status(path, ec).type();
+    return type == fs::file_type::not_found || type == fs::file_type::regular;
+}
+
+void write_output(const std::vector<CodeGenerator>& gens, const MultiFileHeaderList& multi_headers,
+                  const fs::path& output, bool use_script_img, const EmitCode& emit_code, ProgramContext& program)
 {
-    auto write_headers = [&](auto& output_file, size_t offset, const shared_ptr<const Script>& script) -> size_t
+    auto layout = compute_output_layout(gens, use_script_img);
+
+    // The output files opened so far are removed if this fails midway, so that no partial output is left behind.
+    // Only regular files are, as the output may as well be a pipe or a device (e.g. /dev/stdout).
+    auto img_path = fs::path(output).replace_filename("script.img");
+    bool remove_main = false, remove_img = false;
+
+    auto remove_guard = make_scope_guard([&] {
+        std::error_code ec;
+        if(remove_main) fs::remove(output, ec);
+        if(remove_img) fs::remove(img_path, ec);
+    });
+
+    if(program.opt.emit_ir2)
     {
-        size_t total_size = 0;
-        if(auto opt = multi_headers.script_headers(script))
+        FILE *outstream = 0;
+        std::vector<uint8_t> main_scm(layout.main_size);
+        std::vector<uint8_t> script_img(layout.img_size);
+
+        auto guard = make_scope_guard([&] {
+            if(outstream && outstream != program.output_stream()) fclose(outstream);
+        });
+
+        generate_output(gens, multi_headers, layout, main_scm.data(), script_img.data(), emit_code, program);
+
+        if(program.has_error())
+            throw ProgramFailure();
+
+        if(output != "-")
         {
-            for(auto& header : *opt)
+            auto is_regular = is_regular_output(output);
+            outstream = u8fopen(output, "wb");
+            remove_main = (outstream && is_regular);
+        }
+        else
+        {
+            outstream = program.output_stream();
+        }
+
+        if(outstream == nullptr)
+            program.fatal_error(nocontext, "failed to open output for writing");
+
+        bool is_first_line = true;
+        auto print_ir2_line = [&](const std::string& line)
+        {
+            if(is_first_line)
             {
-                CodeGeneratorData hgen(script, total_size, header, program);
-                hgen.generate();
-                write_file(output_file, offset, hgen.buffer(), hgen.buffer_size());
-                total_size += hgen.buffer_size();
-                offset += hgen.buffer_size();
+                is_first_line = false;
+                fprintf(outstream, "%s", line.c_str());
+            }
+            else
+            {
+                fprintf(outstream, "\n%s", line.c_str());
+            }
+        };
+
+        auto status = decompile(main_scm.data(), main_scm.size(),
+                                script_img.data(), script_img.size(), program,
+                                Options::Lang::IR2, print_ir2_line);
+        if(!status)
+            throw ProgramFailure();
+    }
+    else
+    {
+        // The code is generated straight into the mapped output files, thus no intermediate copy of it is made.
+        // Outputs which cannot be mapped (e.g. pipes) are generated into memory and written afterwards instead.
+        void *main_scm = nullptr, *script_img = nullptr;
+        std::vector<uint8_t> main_buffer, img_buffer;
+        bool mapped = is_regular_output(output) && (!use_script_img || is_regular_output(img_path));
+
+        auto guard = make_scope_guard([&] {
+            if(mapped && main_scm) unmap_file(main_scm, layout.main_size);
+            if(mapped && script_img) unmap_file(script_img, layout.img_size);
+        });
+
+        if(mapped)
+        {
+            mapped = map_file_writable(output, layout.main_size, main_scm);
+            remove_main = mapped;
+
+            if(mapped && use_script_img)
+            {
+                mapped = map_file_writable(img_path, layout.img_size, script_img);
+                remove_img = mapped;
+            }
+
+            if(!mapped)
+            {
+                if(main_scm) unmap_file(main_scm, layout.main_size);
+                if(script_img) unmap_file(script_img, layout.img_size);
+                main_scm = script_img = nullptr;
             }
         }
-        return total_size;
-    };
 
-    std::vector<std::pair<std::string, const CodeGenerator*>> into_script_img;
+        if(!mapped)
+        {
+            main_buffer.resize(layout.main_size);
+            img_buffer.resize(layout.img_size);
+            main_scm = main_buffer.data();
+            script_img = img_buffer.data();
+        }
+
+        generate_output(gens, multi_headers, layout, static_cast<uint8_t*>(main_scm), static_cast<uint8_t*>(script_img),
+                        emit_code, program);
+
+        if(program.has_error())
+            throw ProgramFailure();
+
+        if(!mapped)
+        {
+            auto write_buffer = [&](const fs::path& path, const std::vector<uint8_t>& buffer, bool& remove_file)
+            {
+                auto is_regular = is_regular_output(path);
+                FILE* f = u8fopen(path, "wb");
+                remove_file = (f && is_regular);
+
+                if(f == nullptr)
+                    return false;
+
+                bool result = write_file(f, buffer.data(), buffer.size());
+                return (fclose(f) == 0) && result;
+            };
+
+            if(!write_buffer(output, main_buffer, remove_main))
+                program.fatal_error(nocontext, "failed to write output");
+
+            if(use_script_img && !write_buffer(img_path, img_buffer, remove_img))
+                program.fatal_error(nocontext, "failed to write script.img");
+        }
+    }
+
+    remove_main = remove_img = false;
+}
+
+auto compute_output_layout(const std::vector<CodeGenerator>& gens, bool has_script_img) -> OutputLayout
+{
+    OutputLayout layout;
+    layout.has_script_img = has_script_img;
+    layout.placements.resize(gens.size());
+
+    std::vector<std::pair<std::string, size_t>> into_script_img;
 
     assert(gens[0].script->is_main_script());
-    auto scmheader = multi_headers.find_header<CompiledScmHeader>(gens[0].script);
 
-    size_t multifile_size = std::accumulate(gens.begin(), gens.end(), size_t(0), [&](size_t size, const auto& gen) {
+    layout.main_size = std::accumulate(gens.begin(), gens.end(), size_t(0), [&](size_t size, const auto& gen) {
         if(gen.script->is_root_script() && gen.script->type != ScriptType::StreamedScript)
             return size + gen.script->full_size();
         return size;
     });
 
-    if(!allocate_file_space(main_scm, multifile_size))
-        program.fatal_error(nocontext, "failed to allocate disk space for the main file");
-
-    for(const auto& gen : gens)
+    for(size_t i = 0; i < gens.size(); ++i)
     {
-        if(!gen.script->is_child_of(ScriptType::StreamedScript))
+        auto& script = gens[i].script;
+        if(!script->is_child_of(ScriptType::StreamedScript))
         {
-            write_headers(main_scm, gen.script->base.value(), gen.script);
-            write_file(main_scm, gen.script->code_offset.value(), gen.buffer(), gen.buffer_size());
+            layout.placements[i].headers_offset = script->base.value();
+            layout.placements[i].code_offset = script->code_offset.value();
         }
         else
         {
-            if(gen.script->type != ScriptType::Required)
-                into_script_img.emplace_back(gen.script->path.stem().u8string(), &gen);
+            layout.placements[i].in_script_img = true;
+            if(script->type != ScriptType::Required)
+                into_script_img.emplace_back(script->path.stem().u8string(), i);
         }
     }
 
@@ -563,93 +809,131 @@ void generate_output(const std::vector<CodeGenerator>& gens,
 
     if(has_script_img)
     {
-        struct alignas(4) AAAScript
-        {
-            uint32_t size_global_space;
-            uint8_t unknown0 = 62;
-            uint8_t unknown1  = 2;
-            uint16_t unknown2 = 0;
-        };
-
         auto round_2kb = [](size_t size) -> size_t
         {
             return (size + 2048 - 1) & ~(2048 - 1);
         };
 
-        AAAScript aaa_scm;
-        aaa_scm.size_global_space = scmheader->size_global_vars_space - 8;
-
-        CdHeader cd_header { {'V','E','R','2'}, static_cast<uint32_t>(1 + into_script_img.size()) };
-        std::vector<CdEntry> directory;
-        directory.reserve(1 + into_script_img.size());
+        layout.cd_header = CdHeader { {'V','E','R','2'}, static_cast<uint32_t>(1 + into_script_img.size()) };
+        layout.directory.reserve(1 + into_script_img.size());
 
         std::string temp_filename;
         size_t files_offset = round_2kb(sizeof(CdHeader) + ((1 + into_script_img.size()) * sizeof(CdEntry)));
-        size_t end_offset = 0;
 
         auto add_entry = [&](const char* filename, size_t size)
         {
             CdEntry next_entry;
 
-            if(directory.empty())
+            if(layout.directory.empty())
                 next_entry.offset = round_2kb(files_offset) / 2048;
             else
-                next_entry.offset = directory.back().offset + directory.back().streaming_size;
+                next_entry.offset = layout.directory.back().offset + layout.directory.back().streaming_size;
 
             next_entry.streaming_size = static_cast<uint16_t>(round_2kb(size) / 2048);
 
             strncpy(next_entry.filename, filename, 23);
             next_entry.filename[23] = 0;
 
-            directory.emplace_back(next_entry);
+            layout.directory.emplace_back(next_entry);
         };
 
         add_entry("aaa.scm", 8);
         for(auto& into : into_script_img)
         {
-            auto& script = into.second->script;
+            auto& script = gens[into.second].script;
             temp_filename = script->path.stem().u8string();
             temp_filename += ".scm";
             add_entry(temp_filename.c_str(), script->full_size());
         }
 
-        if(directory.empty())
-            end_offset = files_offset;
+        if(layout.directory.empty())
+            layout.img_size = files_offset;
         else
-            end_offset = (directory.back().offset + directory.back().streaming_size) * 2048;
-
-        if(!allocate_file_space(script_img, end_offset))
-            program.fatal_error(nocontext, "failed to allocate disk space for script.img");
-
-        write_file(script_img, 0, &cd_header, sizeof(cd_header));
-        write_file(script_img, sizeof(cd_header), directory.data(), sizeof(CdEntry) * directory.size());
-
-        // aaa.scm
-        write_file(script_img, directory[0].offset * 2048, &aaa_scm, sizeof(aaa_scm));
+            layout.img_size = (layout.directory.back().offset + layout.directory.back().streaming_size) * 2048;
 
         for(size_t i = 0; i < into_script_img.size(); ++i)
         {
-            const CodeGenerator& gen = *into_script_img[i].second;
-
-            size_t offset = directory[1+i].offset * 2048;
-            offset += write_headers(script_img, offset, gen.script);
+            auto& script = gens[into_script_img[i].second].script;
+            auto& placement = layout.placements[into_script_img[i].second];
 
-            write_file(script_img, offset, gen.buffer(), gen.buffer_size());
-            offset += gen.buffer_size();
+            placement.headers_offset = layout.directory[1+i].offset * 2048;
+            placement.code_offset = placement.headers_offset + script->header_size();
 
-            for(auto& weakp : gen.script->children_scripts)
+            size_t offset = placement.code_offset + script->code_size.value();
+            for(auto& weakp : script->children_scripts)
             {
                 auto required_script = weakp.lock();
-                auto& required_gen = *std::find_if(gens.begin(), gens.end(), [&](const auto& g) { return g.script == required_script; });
-                write_file(script_img, offset, required_gen.buffer(), required_gen.buffer_size());
-                offset += required_gen.buffer_size();
+                auto it = std::find_if(gens.begin(), gens.end(), [&](const auto& g) { return g.script == required_script; });
+                layout.placements[it - gens.begin()].code_offset = offset;
+                offset += required_script->code_size.value();
             }
-        }
 
-        assert(file_tell(script_img) <= end_offset);
+            assert(offset <= layout.img_size);
+        }
     }
 
-    assert(file_tell(main_scm) == multifile_size);
+    return layout;
+}
+
+void generate_output(const std::vector<CodeGenerator>& gens, const MultiFileHeaderList& multi_headers,
+                     const OutputLayout& layout, uint8_t* main_scm, uint8_t* script_img,
+                     const EmitCode& emit_code, ProgramContext& program)
+{
+    auto write_headers = [&](uint8_t* output, const shared_ptr<const Script>& script)
+    {
+        size_t total_size = 0;
+        if(auto opt = multi_headers.script_headers(script))
+        {
+            for(auto& header : *opt)
+            {
+                CodeGeneratorData hgen(script, total_size, header, program);
+                hgen.generate(output + total_size);
+                total_size += hgen.buffer_size();
+            }
+        }
+    };
+
+    // Every script goes into its own region of the output, so they can be generated concurrently.
+    program.parallel_for(0, gens.size(), [&](size_t i) {
+        auto& placement = layout.placements[i];
+
+        // still generate the scripts that have nowhere to go, so that their diagnostics are given.
+        if(placement.in_script_img && !layout.has_script_img)
+        {
+            std::vector<uint8_t> discarded(gens[i].script->code_size.value());
+            emit_code(i, discarded.data());
+            return;
+        }
+
+        uint8_t* output = (placement.in_script_img? script_img : main_scm);
+
+        if(gens[i].script->type != ScriptType::Required)
+            write_headers(output + placement.headers_offset, gens[i].script);
+
+        emit_code(i, output + placement.code_offset);
+    });
+
+    if(layout.has_script_img)
+    {
+        struct alignas(4) AAAScript
+        {
+            uint32_t size_global_space;
+            uint8_t unknown0 = 62;
+            uint8_t unknown1  = 2;
+            uint16_t unknown2 = 0;
+        };
+
+        auto scmheader = multi_headers.find_header<CompiledScmHeader>(gens[0].script);
+
+        AAAScript aaa_scm;
+        aaa_scm.size_global_space = scmheader->size_global_vars_space - 8;
+
+        std::memcpy(script_img, &layout.cd_header, sizeof(layout.cd_header));
+        std::memcpy(script_img + sizeof(layout.cd_header), layout.directory.data(), sizeof(CdEntry) * layout.directory.size());
+
+        // aaa.scm
+        std::memcpy(script_img + layout.directory[0].offset * 2048, &aaa_scm, sizeof(aaa_scm));
+    }
 }
 
 void check_expect_vars(const Script& main, const SymTable& symbols, ProgramContext& program)
@@ -660,7 +944,7 @@ void check_expect_vars(const Script& main, const SymTable& symbols, ProgramConte
     for(auto& expect : program.opt.expect_vars)
     {
         string_view var_name;
-        shared_ptr<const Var> var;
+        const Var* var = nullptr;
 
         if(expect.first.size() == 0)
             continue;
@@ -20,13 +20,13 @@ int decompile(fs::path input, fs::path output, ProgramContext& program)
         auto lang = (program.opt.emit_ir2? Options::Lang::IR2 : Options::Lang::GTA3Script);
 
         auto guard = make_scope_guard([&] {
-            if(outstream != stdout) fclose(outstream);
+            if(outstream != program.output_stream()) fclose(outstream);
         });
 
         if(lang == Options::Lang::GTA3Script)
             program.fatal_error(nocontext, "GTA3script output is disabled, please use -emit-ir2 for IR2 output");
 
-        outstream = (output != "-"? u8fopen(output, "wb") : stdout);
+        outstream = (output != "-"? u8fopen(output, "wb") : program.output_stream());
         if(!outstream)
             program.fatal_error(nocontext, "could not open file '{}' for writing", output.generic_u8string());
 
@@ -52,7 +52,8 @@ int decompile(fs::path input, fs::path output, ProgramContext& program)
     }
     catch(const ProgramFailure&)
     {
-        fprintf(stderr, "gta3sc: decompilation failed\n");
+        if(auto logstream = program.log_stream())
+            fprintf(logstream, "gta3sc: decompilation failed\n");
         return EXIT_FAILURE;
     }
 }
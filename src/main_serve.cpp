@@ -0,0 +1,447 @@
+#include <stdinc.h>
+#include "program.hpp"
+#include "cpp/argv.hpp"
+
+//
+// Compile server.
+//
+// `gta3sc serve --socket=<path>` listens on a local (UNIX domain) socket for command lines to run. The configuration
+// and data files of each command line are loaded once and reused by every other request using the same ones, and
+// each request is handled in a thread of its own. When the `GTA3SC_SERVER` environment variable has the path to such
+// socket, the `gta3sc` executable forwards its command line to the server instead of running it by itself.
+//
+// A connection carries a single request. All integers are little-endian and all strings are a u32 length followed
+// by its characters.
+//
+//  request (client to server):
+//      u32             number of arguments
+//      string[]        arguments (without the program name)
+//      string          working directory
+//
+//  response (server to client), a sequence of frames:
+//      u8              channel (1 = standard output, 2 = standard error, 0 = exit status)
+//      u32             length
+//      u8[]            data (for the exit status, a i32)
+//
+// The exit status frame is always the last one.
+//
+// Requests to `serve` or to `--watch` are refused, since they would never finish.
+//
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <csignal>
+#include <shared_mutex>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+enum : uint8_t
+{
+    CHANNEL_EXIT    = 0,
+    CHANNEL_STDOUT  = 1,
+    CHANNEL_STDERR  = 2,
+};
+
+static bool send_all(int fd, const void* data, size_t size)
+{
+    auto bytes = static_cast<const char*>(data);
+    while(size > 0)
+    {
+        auto sent = ::write(fd, bytes, size);
+        if(sent <= 0)
+            return false;
+        bytes += sent;
+        size -= size_t(sent);
+    }
+    return true;
+}
+
+static bool recv_all(int fd, void* data, size_t size)
+{
+    auto bytes = static_cast<char*>(data);
+    while(size > 0)
+    {
+        auto received = ::read(fd, bytes, size);
+        if(received <= 0)
+            return false;
+        bytes += received;
+        size -= size_t(received);
+    }
+    return true;
+}
+
+static bool send_u32(int fd, uint32_t value)
+{
+    uint8_t bytes[4] = { uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24) };
+    return send_all(fd, bytes, sizeof(bytes));
+}
+
+static optional<uint32_t> recv_u32(int fd)
+{
+    uint8_t bytes[4];
+    if(!recv_all(fd, bytes, sizeof(bytes)))
+        return nullopt;
+    return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+static bool send_string(int fd, const string_view& value)
+{
+    return send_u32(fd, uint32_t(value.size())) && send_all(fd, value.data(), value.size());
+}
+
+static optional<std::string> recv_string(int fd, size_t max_size)
+{
+    auto size = recv_u32(fd);
+    if(!size || *size > max_size)
+        return nullopt;
+
+    std::string value(*size, '\0');
+    if(*size && !recv_all(fd, &value[0], *size))
+        return nullopt;
+    return value;
+}
+
+/// A response being sent through a connection.
+struct ResponseWriter
+{
+    int         fd;
+    std::mutex  mutex;
+
+    explicit ResponseWriter(int fd) :
+        fd(fd)
+    {}
+
+    bool send_frame(uint8_t channel, const void* data, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return send_all(fd, &channel, 1) && send_u32(fd, uint32_t(size)) && send_all(fd, data, size);
+    }
+};
+
+/// The cookie of a stream opened with `open_channel_stream`.
+struct ChannelCookie
+{
+    ResponseWriter* writer;
+    uint8_t         channel;
+};
+
+#if defined(__linux__)
+
+static ssize_t channel_write(void* cookie, const char* data, size_t size)
+{
+    auto& channel = *static_cast<ChannelCookie*>(cookie);
+    return channel.writer->send_frame(channel.channel, data, size)? ssize_t(size) : -1;
+}
+
+static int channel_close(void* cookie)
+{
+    delete static_cast<ChannelCookie*>(cookie);
+    return 0;
+}
+
+/// Opens a stream whose writes are sent as `channel` frames through `writer`.
+static FILE* open_channel_stream(ResponseWriter& writer, uint8_t channel)
+{
+    cookie_io_functions_t functions = { nullptr, channel_write, nullptr, channel_close };
+    auto cookie = new ChannelCookie { &writer, channel };
+    FILE* stream = fopencookie(cookie, "w", functions);
+    if(!stream) delete cookie;
+    return stream;
+}
+
+#else
+
+static int channel_write(void* cookie, const char* data, int size)
+{
+    auto& channel = *static_cast<ChannelCookie*>(cookie);
+    return channel.writer->send_frame(channel.channel, data, size_t(size))? size : -1;
+}
+
+static int channel_close(void* cookie)
+{
+    delete static_cast<ChannelCookie*>(cookie);
+    return 0;
+}
+
+/// Opens a stream whose writes are sent as `channel` frames through `writer`.
+static FILE* open_channel_stream(ResponseWriter& writer, uint8_t channel)
+{
+    auto cookie = new ChannelCookie { &writer, channel };
+    FILE* stream = funopen(cookie, nullptr, channel_write, nullptr, channel_close);
+    if(!stream) delete cookie;
+    return stream;
+}
+
+#endif
+
+static bool make_socket_address(const char* socket_path, sockaddr_un& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(std::strlen(socket_path) >= sizeof(address.sun_path))
+        return false;
+    std::strcpy(address.sun_path, socket_path);
+    return true;
+}
+
+/// Checks whether the command line `args` can be run by the server, i.e. whether it eventually finishes.
+static bool is_servable(const std::vector<std::string>& args)
+{
+    if(!args.empty() && args[0] == "serve")
+        return false;
+    return std::find(args.begin(), args.end(), "--watch") == args.end();
+}
+
+/// Held shared by the requests while compiling, and exclusively to forget the interned identifiers.
+static std::shared_mutex compiling;
+
+/// Handles the request of the client connected through `fd`, then closes the connection.
+static void serve_request(int fd, SetupCache& setups)
+{
+    auto guard = make_scope_guard([&] {
+        ::close(fd);
+    });
+
+    auto argc = recv_u32(fd);
+    if(!argc || *argc > 4096)
+        return;
+
+    std::vector<std::string> args;
+    args.reserve(*argc);
+    for(uint32_t i = 0; i < *argc; ++i)
+    {
+        auto arg = recv_string(fd, 1 << 16);
+        if(!arg) return;
+        args.emplace_back(std::move(*arg));
+    }
+
+    auto cwd = recv_string(fd, 1 << 16);
+    if(!cwd)
+        return;
+
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for(auto& arg : args)
+        argv.emplace_back(&arg[0]);
+    argv.emplace_back(nullptr);
+
+    ResponseWriter writer { fd };
+    FILE* outstream = open_channel_stream(writer, CHANNEL_STDOUT);
+    FILE* errstream = open_channel_stream(writer, CHANNEL_STDERR);
+
+    int32_t status = EXIT_FAILURE;
+    if(outstream && errstream && !is_servable(args))
+    {
+        fprintf(errstream, "gta3sc: error: the compile server cannot run 'serve' or '--watch'\n");
+    }
+    else if(outstream && errstream)
+    {
+        setvbuf(errstream, nullptr, _IOLBF, BUFSIZ);
+
+        try
+        {
+            std::shared_lock<std::shared_mutex> lock(compiling);
+            status = run_driver(argv.data(), fs::u8path(*cwd), outstream, errstream, &setups, true);
+        }
+        catch(const std::exception& e)
+        {
+            fprintf(errstream, "gta3sc: fatal error: %s\n", e.what());
+        }
+    }
+
+    if(outstream) fclose(outstream);
+    if(errstream) fclose(errstream);
+
+    uint8_t status_bytes[4] = { uint8_t(status), uint8_t(status >> 8), uint8_t(status >> 16), uint8_t(status >> 24) };
+    writer.send_frame(CHANNEL_EXIT, status_bytes, sizeof(status_bytes));
+
+    // The identifiers of every request go into the one atom table, thus forget them once there are too many and
+    // no request is compiling.
+    std::unique_lock<std::shared_mutex> lock(compiling, std::try_to_lock);
+    if(lock.owns_lock())
+        setups.trim_atoms();
+}
+
+int serve(char** argv)
+{
+    std::string socket_path;
+    uint32_t jobs = 1;
+
+    try
+    {
+        while(*argv)
+        {
+            if(const char* path = optget(argv, nullptr, "--socket", 1))
+            {
+                socket_path = path;
+            }
+            else if(const char* n = optget(argv, "-j", nullptr, 1))
+            {
+                try
+                {
+                    jobs = std::stoul(n);
+                }
+                catch(const std::logic_error&)
+                {
+                    fprintf(stderr, "gta3sc: error: argument '-j' expects an integer, got '%s'\n", n);
+                    return EXIT_FAILURE;
+                }
+            }
+            else
+            {
+                fprintf(stderr, "gta3sc: error: unregonized argument '%s'\n", *argv);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    catch(const invalid_opt& e)
+    {
+        fprintf(stderr, "gta3sc: error: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    if(socket_path.empty())
+    {
+        fprintf(stderr, "gta3sc: error: no socket specified [--socket=<path>]\n");
+        return EXIT_FAILURE;
+    }
+
+    sockaddr_un address;
+    if(!make_socket_address(socket_path.c_str(), address))
+    {
+        fprintf(stderr, "gta3sc: error: socket path '%s' is too long\n", socket_path.c_str());
+        return EXIT_FAILURE;
+    }
+
+    // only a stale socket may be replaced, anything else at the path is most likely a mistyped argument.
+    struct stat st;
+    if(::lstat(socket_path.c_str(), &st) == 0 && !S_ISSOCK(st.st_mode))
+    {
+        fprintf(stderr, "gta3sc: error: '%s' exists and is not a socket\n", socket_path.c_str());
+        return EXIT_FAILURE;
+    }
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listen_fd == -1)
+    {
+        fprintf(stderr, "gta3sc: error: failed to create socket\n");
+        return EXIT_FAILURE;
+    }
+
+    ::unlink(socket_path.c_str());
+    if(::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1
+        || ::listen(listen_fd, SOMAXCONN) == -1)
+    {
+        fprintf(stderr, "gta3sc: error: failed to listen on socket '%s'\n", socket_path.c_str());
+        ::close(listen_fd);
+        return EXIT_FAILURE;
+    }
+
+    // a client going away in the middle of a response must not bring the server down.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    ThreadPool::set_global_concurrency(jobs);
+
+    // requests still running when the server gives up must not be left with a dangling cache.
+    auto setups = std::make_shared<SetupCache>();
+
+    while(true)
+    {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if(fd == -1)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+            fprintf(stderr, "gta3sc: error: failed to accept connection\n");
+            ::close(listen_fd);
+            return EXIT_FAILURE;
+        }
+
+        std::thread([fd, setups] { serve_request(fd, *setups); }).detach();
+    }
+}
+
+optional<int> run_on_server(const char* socket_path, char** argv)
+{
+    std::vector<std::string> args;
+    for(char** arg = argv; *arg; ++arg)
+        args.emplace_back(*arg);
+
+    if(!is_servable(args))
+        return nullopt;
+
+    sockaddr_un address;
+    if(!make_socket_address(socket_path, address))
+        return nullopt;
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd == -1)
+        return nullopt;
+
+    auto guard = make_scope_guard([&] {
+        ::close(fd);
+    });
+
+    if(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
+        return nullopt;
+
+    std::error_code ec;
+    auto cwd = fs::current_path(ec);
+    if(ec)
+        return nullopt;
+
+    size_t argc = 0;
+    while(argv[argc]) ++argc;
+
+    bool sent = send_u32(fd, uint32_t(argc));
+    for(size_t i = 0; sent && i < argc; ++i)
+        sent = send_string(fd, argv[i]);
+    if(!sent || !send_string(fd, cwd.u8string()))
+        return nullopt;
+
+    std::vector<char> data;
+    while(true)
+    {
+        uint8_t channel;
+        optional<uint32_t> size;
+        if(!recv_all(fd, &channel, 1) || !(size = recv_u32(fd)))
+            break;
+
+        data.resize(*size);
+        if(*size && !recv_all(fd, data.data(), *size))
+            break;
+
+        if(channel == CHANNEL_EXIT && *size == 4)
+        {
+            auto bytes = reinterpret_cast<const uint8_t*>(data.data());
+            return int32_t(uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24);
+        }
+        else if(channel == CHANNEL_STDOUT || channel == CHANNEL_STDERR)
+        {
+            FILE* stream = (channel == CHANNEL_STDOUT? stdout : stderr);
+            fwrite(data.data(), 1, data.size(), stream);
+            fflush(stream);
+        }
+    }
+
+    fprintf(stderr, "gta3sc: error: lost connection to the compile server\n");
+    return EXIT_FAILURE;
+}
+
+#else
+
+int serve(char** argv)
+{
+    fprintf(stderr, "gta3sc: error: the compile server is not supported on this platform\n");
+    return EXIT_FAILURE;
+}
+
+optional<int> run_on_server(const char* socket_path, char** argv)
+{
+    return nullopt;
+}
+
+#endif
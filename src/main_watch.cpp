@@ -0,0 +1,221 @@
+#include <stdinc.h>
+#include "program.hpp"
+
+//
+// Watch mode.
+//
+// `gta3sc compile --watch` compiles the input, then waits for the main script, any file in its subdirectory (which
+// is where every other script of the program comes from, see `Script::scan_subdir`) or any definition file to change,
+// and compiles it again. The process is kept alive in between, so the commands are only loaded again when a
+// definition file changes, and scripts left untouched are loaded from the build cache instead of being parsed again.
+//
+
+#if defined(__linux__)
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/// Events of a directory that may change the compilation output.
+static constexpr uint32_t watch_mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+/// Time to wait for further changes after a change is noticed, since editors usually touch files more than once
+/// when saving (e.g. write into a temporary, then rename it over the original).
+static constexpr int settle_time_ms = 50;
+
+/// Whether `path` is `dir` or somewhere inside it.
+static bool is_within(const fs::path& path, const fs::path& dir)
+{
+    auto pit = path.begin();
+    for(auto dit = dir.begin(); dit != dir.end(); ++dit, ++pit)
+    {
+        if(pit == path.end() || *pit != *dit)
+            return false;
+    }
+    return true;
+}
+
+/// Watches the files a compilation of the input script depends on.
+class FileWatcher
+{
+public:
+    explicit FileWatcher(const fs::path& input, const std::vector<fs::path>& config_files) :
+        input(input), subdir(input.parent_path() / input.stem()), config_files(config_files)
+    {
+        this->fd = inotify_init1(IN_CLOEXEC);
+    }
+
+    ~FileWatcher()
+    {
+        if(this->fd != -1)
+            ::close(this->fd);
+    }
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /// Starts watching the directories of the input, its subdirectory tree and the definition files.
+    bool start()
+    {
+        if(this->fd == -1 || !this->add_watch(input.parent_path()))
+            return false;
+
+        this->add_watch_recursive(this->subdir);
+
+        for(auto& path : this->config_files)
+            this->add_watch(path.parent_path());
+
+        return true;
+    }
+
+    /// Blocks until a relevant change happens.
+    ///
+    /// \returns whether any of the definition files changed, or `nullopt` on failure.
+    optional<bool> wait()
+    {
+        bool changed = false, config_changed = false;
+
+        // block until the first relevant event, then gather the ones that follow it closely.
+        while(true)
+        {
+            pollfd pfd = { this->fd, POLLIN, 0 };
+            int ready = ::poll(&pfd, 1, changed? settle_time_ms : -1);
+            if(ready < 0 && errno == EINTR)
+                continue;
+            if(ready < 0)
+                return nullopt;
+            if(ready == 0)
+                break;
+
+            alignas(inotify_event) char buffer[4096];
+            auto length = ::read(this->fd, buffer, sizeof(buffer));
+            if(length <= 0)
+                return nullopt;
+
+            for(char* p = buffer; p < buffer + length; )
+            {
+                auto& event = *reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + event.len;
+
+                if(event.mask & IN_IGNORED)
+                {
+                    this->dirs.erase(event.wd);
+                    continue;
+                }
+
+                auto it = this->dirs.find(event.wd);
+                if(it == this->dirs.end() || event.len == 0)
+                    continue;
+
+                auto path = it->second / event.name;
+
+                if((event.mask & IN_ISDIR) && (event.mask & (IN_CREATE | IN_MOVED_TO)) && is_within(path, this->subdir))
+                    this->add_watch_recursive(path);
+
+                if(std::find(this->config_files.begin(), this->config_files.end(), path) != this->config_files.end())
+                {
+                    changed = true;
+                    config_changed = true;
+                }
+                else if(path == this->input || is_within(path, this->subdir))
+                {
+                    changed = true;
+                }
+            }
+        }
+
+        return config_changed;
+    }
+
+private:
+    bool add_watch(const fs::path& dir)
+    {
+        int wd = inotify_add_watch(this->fd, dir.c_str(), watch_mask);
+        if(wd == -1)
+            return false;
+        this->dirs[wd] = dir;
+        return true;
+    }
+
+    void add_watch_recursive(const fs::path& dir)
+    {
+        std::error_code ec;
+        if(!fs::is_directory(dir, ec) || !this->add_watch(dir))
+            return;
+
+        for(auto it = fs::recursive_directory_iterator(dir, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec))
+        {
+            if(it->is_directory(ec))
+                this->add_watch(it->path());
+        }
+    }
+
+private:
+    int                                 fd = -1;
+    fs::path                            input;
+    fs::path                            subdir;
+    std::vector<fs::path>               config_files;
+    std::unordered_map<int, fs::path>   dirs;      //< watch descriptor to watched directory.
+};
+
+int watch(std::vector<std::string> args, const fs::path& input, const std::vector<fs::path>& config_files,
+          const fs::path& cwd, FILE* outstream, FILE* errstream)
+{
+    std::error_code ec;
+
+    std::vector<fs::path> watched_config_files;
+    for(auto& path : config_files)
+        watched_config_files.emplace_back(fs::absolute(path, ec).lexically_normal());
+
+    FileWatcher watcher(fs::absolute(input, ec).lexically_normal(), watched_config_files);
+    if(!watcher.start())
+    {
+        fprintf(errstream, "gta3sc: error: failed to watch '%s' for changes\n", input.generic_u8string().c_str());
+        return EXIT_FAILURE;
+    }
+
+    args.erase(std::remove(args.begin(), args.end(), "--watch"), args.end());
+    args.emplace(args.begin(), "compile");
+
+    SetupCache setups;
+
+    while(true)
+    {
+        // run_driver(...) modifies the arguments it parses.
+        auto args_copy = args;
+        std::vector<char*> argv;
+        argv.reserve(args_copy.size() + 1);
+        for(auto& arg : args_copy)
+            argv.emplace_back(&arg[0]);
+        argv.emplace_back(nullptr);
+
+        if(run_driver(argv.data(), cwd, outstream, errstream, &setups, true) == EXIT_SUCCESS)
+            fprintf(errstream, "gta3sc: compilation finished, watching for changes\n");
+        else
+            fprintf(errstream, "gta3sc: watching for changes\n");
+        fflush(errstream);
+
+        setups.trim_atoms();
+
+        auto config_changed = watcher.wait();
+        if(!config_changed)
+        {
+            fprintf(errstream, "gta3sc: error: failed to watch '%s' for changes\n", input.generic_u8string().c_str());
+            return EXIT_FAILURE;
+        }
+
+        if(*config_changed)
+            setups.clear();
+    }
+}
+
+#else
+
+int watch(std::vector<std::string> args, const fs::path& input, const std::vector<fs::path>& config_files,
+          const fs::path& cwd, FILE* outstream, FILE* errstream)
+{
+    fprintf(errstream, "gta3sc: error: --watch is not supported on this platform\n");
+    return EXIT_FAILURE;
+}
+
+#endif
@@ -0,0 +1,681 @@
+#include <stdinc.h>
+#include "object_file.hpp"
+#include "program.hpp"
+#include "system.hpp"
+#include "binary_cache.hpp"
+#include "builtin_config.hpp"
+
+//
+// Relocatable object format.
+//
+// All integers are little-endian and all strings are a u32 length followed by its characters.
+//
+//  header:
+//      char[8]         magic ("GTA3SCOB")
+//      u32             version
+//      u64             options hash
+//
+//  script:
+//      string          name
+//      string          path
+//      u8              type
+//      u32             mission id plus one, or zero if none
+//      u32             streamed id plus one, or zero if none
+//      u32             space of the global variables defined by the object
+//      u32             space of the local variables of the script
+//      u32             number of children
+//      string[]        children
+//      u32             number of models
+//      string[]        models
+//
+//  symbols:
+//      u32             count
+//      symbol[]        symbols (u8 kind, string name, u8 defined, u32 value)
+//
+//  code:
+//      u32             size
+//      u8[]            code
+//
+//  relocations:
+//      u32             count
+//      reloc[]         relocations (u8 kind, u8 size, u32 offset, u32 target, i32 addend)
+//
+//  objects:
+//      u32             count (zero except for the main script)
+//      string[]        paths of the objects of the other scripts
+//
+
+static constexpr char object_magic[8] = { 'G', 'T', 'A', '3', 'S', 'C', 'O', 'B' };
+static constexpr uint32_t object_version = 2;
+
+/// Index of the first global variable, past the GOTO at the top of the main script (see `scan_symbols`).
+static constexpr uint32_t first_global_var = 2;
+
+static auto object_reloc_kind(Relocation::Kind kind) -> ObjectFile::Reloc::Kind
+{
+    switch(kind)
+    {
+        case Relocation::Kind::Absolute:        return ObjectFile::Reloc::Kind::Absolute;
+        case Relocation::Kind::NegatedAbsolute: return ObjectFile::Reloc::Kind::NegatedAbsolute;
+        case Relocation::Kind::NegatedLocal:    return ObjectFile::Reloc::Kind::NegatedLocal;
+        default:                                Unreachable();
+    }
+}
+
+static auto label_reloc_kind(ObjectFile::Reloc::Kind kind) -> Relocation::Kind
+{
+    switch(kind)
+    {
+        case ObjectFile::Reloc::Kind::Absolute:        return Relocation::Kind::Absolute;
+        case ObjectFile::Reloc::Kind::NegatedAbsolute: return Relocation::Kind::NegatedAbsolute;
+        case ObjectFile::Reloc::Kind::NegatedLocal:    return Relocation::Kind::NegatedLocal;
+        default:                                       Unreachable();
+    }
+}
+
+/// Places the `size` lowest bytes of `value` at `bytes`.
+static void put_le(uint8_t* bytes, uint32_t value, size_t size)
+{
+    for(size_t i = 0; i < size; ++i)
+        bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+/// Gets the spelling the symbol declared at `where` was declared with, or `fallback` if unknown.
+static std::string declared_name(const weak_ptr<const SyntaxTree>& where, Atom fallback, const Options& options)
+{
+    auto node = where.lock();
+    if(node == nullptr || !node->has_text())
+        return fallback.name().to_string();
+
+    auto text = node->text();
+    if(node->type() == NodeType::Label)
+        return text.to_string();
+    if(auto opt_ident = Miss2Identifier::match(text, options))
+        return opt_ident->identifier.to_string();
+    return fallback.name().to_string();
+}
+
+std::vector<ObjectFile> ObjectFile::from_program(const std::vector<CodeGenerator>& gens, const SymTable& symbols,
+                                                 const fs::path& output, ProgramContext& program)
+{
+    std::vector<ObjectFile> objects(gens.size());
+
+    std::map<const Script*, uint32_t> unit_index;
+    for(size_t i = 0; i < gens.size(); ++i)
+        unit_index.emplace(gens[i].script.get(), uint32_t(i));
+
+    // The global variables of each script were placed one after the other (see `SymTable::merge`), thus the
+    // script defining a variable is found by its index.
+    std::vector<uint32_t> globals_base(gens.size());
+    uint32_t next_global = symbols.offset_global_vars / 4;
+    for(size_t i = 0; i < gens.size(); ++i)
+    {
+        globals_base[i] = next_global;
+        next_global += gens[i].script->size_global_vars;
+    }
+
+    auto global_var_unit = [&](const Var& var) {
+        auto it = std::upper_bound(globals_base.begin(), globals_base.end(), var.index);
+        return static_cast<uint32_t>(std::distance(globals_base.begin(), it) - 1);
+    };
+
+    // The names are spelled as declared, so that the objects do not depend on which spelling was interned first.
+    std::vector<std::string> label_names(symbols.label_table.size());
+    for(auto& kv : symbols.labels)
+        label_names[kv.second->id] = declared_name(kv.second->where, kv.first, program.opt);
+
+    std::vector<std::string> var_names(symbols.var_table.size());
+    for(auto& kv : symbols.global_vars)
+        var_names[kv.second->id] = declared_name(kv.second->where, kv.first, program.opt);
+
+    for(size_t i = 0; i < gens.size(); ++i)
+    {
+        auto& gen = gens[i];
+        auto& object = objects[i];
+        auto& script = *gen.script;
+
+        object.options_hash = hash_options(program.opt);
+        object.name = script.path.filename().generic_u8string();
+        object.path = script.path;
+        object.type = script.type;
+        object.mission_id = script.mission_id;
+        object.streamed_id = script.streamed_id;
+        object.size_global_vars = script.size_global_vars;
+
+        // only the locals of this script, the ones of its children are in their own objects.
+        object.maximum_local = 0;
+        for(auto& scope : script.scopes)
+        {
+            for(auto& var : scope->vars)
+                object.maximum_local = std::max(object.maximum_local, var.second->end_offset() / 4);
+        }
+
+        for(auto& child : script.children_scripts)
+            object.children.emplace_back(child.lock()->path.filename().generic_u8string());
+
+        for(auto& umodel : script.used_models())
+            object.models.emplace_back(umodel.first);
+
+        auto bytes = static_cast<const uint8_t*>(gen.buffer());
+        object.code.assign(bytes, bytes + gen.buffer_size());
+
+        // the start and top labels are unnamed, thus they are named after the script (names cannot have a colon).
+        label_names[script.start_label->id] = object.name + ":start";
+        label_names[script.top_label->id] = object.name + ":top";
+    }
+
+    // Every label and global variable is exported by the object of the script defining it.
+    struct Export
+    {
+        uint32_t    id;
+        Symbol      symbol;
+    };
+
+    std::vector<std::vector<Export>> exports(gens.size());
+
+    for(auto& label : symbols.label_table)
+    {
+        auto i = unit_index.at(label->script);
+        exports[i].emplace_back(Export { label->id, Symbol { Symbol::Kind::Label, label_names[label->id], true,
+                                                              label->code_position.value() } });
+    }
+
+    for(auto& kv : symbols.global_vars)
+    {
+        auto& var = *kv.second;
+        auto i = global_var_unit(var);
+        exports[i].emplace_back(Export { var.id, Symbol { Symbol::Kind::GlobalVar, var_names[var.id], true,
+                                                          var.index - globals_base[i] } });
+    }
+
+    for(size_t i = 0; i < gens.size(); ++i)
+    {
+        auto& gen = gens[i];
+        auto& object = objects[i];
+
+        // the symbol table is hashed by atoms, whose order may differ between compilations.
+        std::sort(exports[i].begin(), exports[i].end(), [](const Export& a, const Export& b) {
+            if(a.symbol.kind != b.symbol.kind)
+                return a.symbol.kind < b.symbol.kind;
+            if(a.symbol.value != b.symbol.value)
+                return a.symbol.value < b.symbol.value;
+            return iless()(a.symbol.name, b.symbol.name);
+        });
+
+        // symbols of the object by the id of their label or variable.
+        std::unordered_map<uint32_t, uint32_t> label_symbols, var_symbols;
+
+        for(auto& exp : exports[i])
+        {
+            auto& by_id = (exp.symbol.kind == Symbol::Kind::Label? label_symbols : var_symbols);
+            by_id.emplace(exp.id, uint32_t(object.symbols.size()));
+            object.symbols.emplace_back(std::move(exp.symbol));
+        }
+
+        for(auto& reloc : gen.relocations)
+        {
+            auto it = label_symbols.find(reloc.label);
+            if(it == label_symbols.end())
+            {
+                // labels made up by the compiler are local to the code generator, and other labels are imported.
+                auto symbol = gen.ir().is_local_label(reloc.label)?
+                    Symbol { Symbol::Kind::Label, std::string(), true, gen.label_position(reloc.label).second } :
+                    Symbol { Symbol::Kind::Label, label_names[reloc.label], false, 0 };
+                it = label_symbols.emplace(reloc.label, uint32_t(object.symbols.size())).first;
+                object.symbols.emplace_back(std::move(symbol));
+            }
+
+            object.relocations.emplace_back(Reloc { object_reloc_kind(reloc.kind), 4, reloc.offset, it->second, 0 });
+        }
+
+        for(auto& ref : gen.symbol_references)
+        {
+            if(ref.kind == SymbolReference::Kind::Model)
+            {
+                object.relocations.emplace_back(Reloc { Reloc::Kind::Model, ref.size, ref.offset, ref.target, 0 });
+                continue;
+            }
+
+            auto it = var_symbols.find(ref.target);
+            if(it == var_symbols.end())
+            {
+                it = var_symbols.emplace(ref.target, uint32_t(object.symbols.size())).first;
+                object.symbols.emplace_back(Symbol { Symbol::Kind::GlobalVar, var_names[ref.target], false, 0 });
+            }
+
+            object.relocations.emplace_back(Reloc { Reloc::Kind::GlobalVar, ref.size, ref.offset, it->second, ref.addend });
+        }
+    }
+
+    // The other objects are named after the output and their script, e.g. main.o and main.mission1.o.
+    auto stem = output.stem().generic_u8string();
+    insensitive_set<std::string> object_names { output.filename().generic_u8string() };
+    for(size_t i = 1; i < gens.size(); ++i)
+    {
+        auto name = stem + "." + gens[i].script->path.stem().generic_u8string() + ".o";
+        if(!object_names.emplace(name).second)
+            program.error(nocontext, "script '{}' would be compiled into the same object as another script",
+                          gens[i].script->path.generic_u8string());
+        objects[0].objects.emplace_back(fs::u8path(name));
+    }
+
+    return objects;
+}
+
+uint64_t ObjectFile::hash_options(const Options& options)
+{
+    uint8_t flags[] = {
+        uint8_t(options.header), options.headerless, options.use_local_offsets, options.streamed_scripts,
+    };
+    return fnv1a64(flags, sizeof(flags));
+}
+
+optional<ObjectFile> ObjectFile::read(const fs::path& path)
+{
+    size_t size = 0;
+    const void* data = map_file_readonly(path, size);
+    if(data == nullptr)
+        return nullopt;
+
+    auto guard = make_scope_guard([&] {
+        unmap_file(data, size);
+    });
+
+    try
+    {
+        CacheReader r(data, size);
+        ObjectFile object;
+
+        for(char c : object_magic)
+        {
+            if(r.u8() != uint8_t(c))
+                return nullopt;
+        }
+
+        if(r.u32() != object_version)
+            return nullopt;
+
+        object.options_hash = r.u64();
+        object.name = r.string().to_string();
+        object.path = fs::u8path(r.string().to_string());
+
+        auto type = r.u8();
+        if(type > uint8_t(ScriptType::Required))
+            throw CacheError();
+        object.type = static_cast<ScriptType>(type);
+
+        if(auto id = r.u32()) object.mission_id = static_cast<uint16_t>(id - 1);
+        if(auto id = r.u32()) object.streamed_id = static_cast<uint16_t>(id - 1);
+
+        object.size_global_vars = r.u32();
+        object.maximum_local = r.u32();
+
+        object.children.resize(r.count(4));
+        for(auto& child : object.children)
+            child = r.string().to_string();
+
+        object.models.resize(r.count(4));
+        for(auto& model : object.models)
+            model = r.string().to_string();
+
+        object.symbols.resize(r.count(10));
+        for(auto& symbol : object.symbols)
+        {
+            auto kind = r.u8();
+            if(kind > uint8_t(Symbol::Kind::GlobalVar))
+                throw CacheError();
+
+            symbol.kind = static_cast<Symbol::Kind>(kind);
+            symbol.name = r.string().to_string();
+            symbol.defined = (r.u8() != 0);
+            symbol.value = r.u32();
+
+            // only labels are anonymous, and those are never imported.
+            if(symbol.name.empty() && (symbol.kind != Symbol::Kind::Label || !symbol.defined))
+                throw CacheError();
+            if(symbol.defined && symbol.kind == Symbol::Kind::GlobalVar && symbol.value >= object.size_global_vars)
+                throw CacheError();
+        }
+
+        r.blob(object.code);
+
+        for(auto& symbol : object.symbols)
+        {
+            if(symbol.defined && symbol.kind == Symbol::Kind::Label && symbol.value > object.code.size())
+                throw CacheError();
+        }
+
+        object.relocations.resize(r.count(14));
+        for(auto& reloc : object.relocations)
+        {
+            auto kind = r.u8();
+            if(kind > uint8_t(Reloc::Kind::Model))
+                throw CacheError();
+
+            reloc.kind = static_cast<Reloc::Kind>(kind);
+            reloc.size = r.u8();
+            reloc.offset = r.u32();
+            reloc.target = r.u32();
+            reloc.addend = r.i32();
+
+            if(uint64_t(reloc.offset) + reloc.size > object.code.size())
+                throw CacheError();
+
+            switch(reloc.kind)
+            {
+                case Reloc::Kind::Absolute:
+                case Reloc::Kind::NegatedAbsolute:
+                case Reloc::Kind::NegatedLocal:
+                    if(reloc.size != 4 || reloc.target >= object.symbols.size()
+                        || object.symbols[reloc.target].kind != Symbol::Kind::Label)
+                        throw CacheError();
+                    break;
+                case Reloc::Kind::GlobalVar:
+                    if(reloc.size != 2 || reloc.target >= object.symbols.size()
+                        || object.symbols[reloc.target].kind != Symbol::Kind::GlobalVar)
+                        throw CacheError();
+                    break;
+                case Reloc::Kind::Model:
+                    if((reloc.size != 1 && reloc.size != 2 && reloc.size != 4) || reloc.target >= object.models.size())
+                        throw CacheError();
+                    break;
+                default:
+                    Unreachable();
+            }
+        }
+
+        object.objects.resize(r.count(4));
+        for(auto& object_path : object.objects)
+            object_path = fs::u8path(r.string().to_string());
+
+        if(!r.at_end())
+            throw CacheError();
+
+        return object;
+    }
+    catch(const CacheError&)
+    {
+        return nullopt;
+    }
+}
+
+bool ObjectFile::write(const fs::path& path) const
+{
+    CacheWriter w;
+
+    for(char c : object_magic)
+        w.u8(uint8_t(c));
+
+    w.u32(object_version);
+    w.u64(this->options_hash);
+    w.string(this->name);
+    w.string(this->path.generic_u8string());
+    w.u8(uint8_t(this->type));
+    w.u32(this->mission_id? uint32_t(*this->mission_id) + 1 : 0);
+    w.u32(this->streamed_id? uint32_t(*this->streamed_id) + 1 : 0);
+    w.u32(this->size_global_vars);
+    w.u32(this->maximum_local);
+
+    w.u32(uint32_t(this->children.size()));
+    for(auto& child : this->children)
+        w.string(child);
+
+    w.u32(uint32_t(this->models.size()));
+    for(auto& model : this->models)
+        w.string(model);
+
+    w.u32(uint32_t(this->symbols.size()));
+    for(auto& symbol : this->symbols)
+    {
+        w.u8(uint8_t(symbol.kind));
+        w.string(symbol.name);
+        w.u8(symbol.defined);
+        w.u32(symbol.value);
+    }
+
+    w.u32(uint32_t(this->code.size()));
+    w.bytes.append(reinterpret_cast<const char*>(this->code.data()), this->code.size());
+
+    w.u32(uint32_t(this->relocations.size()));
+    for(auto& reloc : this->relocations)
+    {
+        w.u8(uint8_t(reloc.kind));
+        w.u8(reloc.size);
+        w.u32(reloc.offset);
+        w.u32(reloc.target);
+        w.i32(reloc.addend);
+    }
+
+    w.u32(uint32_t(this->objects.size()));
+    for(auto& object_path : this->objects)
+        w.string(object_path.generic_u8string());
+
+    return write_cache_file(path, w.bytes);
+}
+
+optional<LinkedProgram> LinkedProgram::link(const fs::path& path, ProgramContext& program)
+{
+    LinkedProgram linked;
+    auto options_hash = ObjectFile::hash_options(program.opt);
+
+    auto read_object = [&](const fs::path& object_path)
+    {
+        auto object = ObjectFile::read(object_path);
+        if(!object)
+            program.error(nocontext, "failed to read object file '{}'", object_path.generic_u8string());
+        else if(object->options_hash != options_hash)
+            program.error(nocontext, "object file '{}' was compiled with different code generation options",
+                          object_path.generic_u8string());
+        else
+            linked.objects.emplace_back(std::move(*object));
+    };
+
+    auto is_main_type = [](ScriptType type) {
+        return type == ScriptType::Main || type == ScriptType::CustomScript || type == ScriptType::CustomMission;
+    };
+
+    read_object(path);
+    if(program.has_error())
+        return nullopt;
+
+    if(!is_main_type(linked.objects[0].type))
+    {
+        program.error(nocontext, "object file '{}' is not of a main script", path.generic_u8string());
+        return nullopt;
+    }
+
+    auto object_paths = linked.objects[0].objects;
+    for(auto& object_path : object_paths)
+        read_object(path.parent_path() / object_path);
+
+    if(program.has_error())
+        return nullopt;
+
+    auto& objects = linked.objects;
+
+    insensitive_map<std::string, uint32_t> object_index;
+    for(size_t i = 0; i < objects.size(); ++i)
+    {
+        if(!object_index.emplace(objects[i].name, uint32_t(i)).second)
+            program.error(nocontext, "script '{}' is in more than one object", objects[i].name);
+        else if(i != 0 && is_main_type(objects[i].type))
+            program.error(nocontext, "object of script '{}' is of a main script", objects[i].name);
+    }
+
+    // every required script must be the child of exactly one script.
+    std::vector<std::vector<uint32_t>> children(objects.size());
+    std::vector<bool> has_parent(objects.size());
+    for(size_t i = 0; i < objects.size(); ++i)
+    {
+        for(auto& child : objects[i].children)
+        {
+            auto it = object_index.find(child);
+            if(it == object_index.end() || objects[it->second].type != ScriptType::Required || has_parent[it->second])
+            {
+                program.error(nocontext, "script '{}' requires '{}', which is not in the objects", objects[i].name, child);
+                continue;
+            }
+
+            children[i].emplace_back(it->second);
+            has_parent[it->second] = true;
+        }
+    }
+
+    for(size_t i = 0; i < objects.size(); ++i)
+    {
+        if(objects[i].type == ScriptType::Required && !has_parent[i])
+            program.error(nocontext, "required script '{}' is not required by any script", objects[i].name);
+    }
+
+    if(program.has_error())
+        return nullopt;
+
+    // The global variables of the objects are placed one after the other.
+    std::vector<uint32_t> globals_base(objects.size());
+    uint64_t next_global = first_global_var;
+    for(size_t i = 0; i < objects.size(); ++i)
+    {
+        globals_base[i] = static_cast<uint32_t>(std::min<uint64_t>(next_global, UINT32_MAX));
+        next_global += objects[i].size_global_vars;
+    }
+
+    if(next_global > 65536 / 4)
+    {
+        program.error(nocontext, "reached maximum global variable limit ({})", 65536 / 4);
+        return nullopt;
+    }
+
+    linked.size_global_vars = static_cast<uint32_t>(next_global * 4);
+
+    // Labels are resolved to their object and position, and global variables to their index.
+    insensitive_map<std::string, Resolved> exports[2];
+    for(size_t i = 0; i < objects.size(); ++i)
+    {
+        for(auto& symbol : objects[i].symbols)
+        {
+            if(!symbol.defined || symbol.name.empty())
+                continue;
+
+            auto is_label = (symbol.kind == ObjectFile::Symbol::Kind::Label);
+            auto value = is_label? symbol.value : globals_base[i] + symbol.value;
+
+            auto it = exports[is_label].emplace(symbol.name, Resolved { uint32_t(i), value });
+            if(!it.second)
+            {
+                program.error(nocontext, "{} '{}' is defined by both '{}' and '{}'", is_label? "label" : "variable",
+                              symbol.name, objects[it.first->second.object].name, objects[i].name);
+            }
+        }
+    }
+
+    linked.symbols.resize(objects.size());
+    for(size_t i = 0; i < objects.size(); ++i)
+    {
+        for(auto& symbol : objects[i].symbols)
+        {
+            auto is_label = (symbol.kind == ObjectFile::Symbol::Kind::Label);
+
+            if(symbol.defined)
+            {
+                auto value = is_label? symbol.value : globals_base[i] + symbol.value;
+                linked.symbols[i].emplace_back(Resolved { uint32_t(i), value });
+                continue;
+            }
+
+            auto it = exports[is_label].find(symbol.name);
+            if(it == exports[is_label].end())
+            {
+                program.error(nocontext, "undefined reference to {} '{}' in '{}'", is_label? "label" : "variable",
+                              symbol.name, objects[i].name);
+                linked.symbols[i].emplace_back(Resolved { uint32_t(i), 0 });
+                continue;
+            }
+
+            linked.symbols[i].emplace_back(it->second);
+        }
+    }
+
+    // The models header lists the models of the objects in the order they are first used.
+    insensitive_map<std::string, int32_t> model_values;
+    linked.model_values.resize(objects.size());
+    for(size_t i = 0; i < objects.size(); ++i)
+    {
+        for(auto& model : objects[i].models)
+        {
+            auto it = model_values.emplace(model, -(1 + int32_t(linked.models.size())));
+            if(it.second)
+                linked.models.emplace_back(model);
+            linked.model_values[i].emplace_back(it.first->second);
+        }
+    }
+
+    // The mission local variables include the ones of the scripts required by the missions.
+    std::function<uint32_t(size_t)> maximum_local = [&](size_t i) {
+        auto value = objects[i].maximum_local;
+        for(auto child : children[i])
+            value = std::max(value, maximum_local(child));
+        return value;
+    };
+
+    linked.maximum_mission_local = 0;
+    for(size_t i = 0; i < objects.size(); ++i)
+    {
+        if(objects[i].type == ScriptType::Mission)
+            linked.maximum_mission_local = std::max(linked.maximum_mission_local, maximum_local(i));
+    }
+
+    if(program.has_error())
+        return nullopt;
+
+    return linked;
+}
+
+void LinkedProgram::relocate_into(size_t i, void* output, const std::vector<shared_ptr<Script>>& scripts,
+                                  ProgramContext& program) const
+{
+    auto& object = this->objects[i];
+    auto code = static_cast<uint8_t*>(output);
+    auto root_base = scripts[i]->root_script()->base.value();
+
+    if(!object.code.empty())
+        std::memcpy(code, object.code.data(), object.code.size());
+
+    for(auto& reloc : object.relocations)
+    {
+        switch(reloc.kind)
+        {
+            case ObjectFile::Reloc::Kind::Absolute:
+            case ObjectFile::Reloc::Kind::NegatedAbsolute:
+            case ObjectFile::Reloc::Kind::NegatedLocal:
+            {
+                auto& target = this->symbols[i][reloc.target];
+                auto label_offset = scripts[target.object]->code_offset.value() + target.value;
+                Relocation { label_reloc_kind(reloc.kind), reloc.offset, 0 }.apply(code, label_offset, root_base, program);
+                break;
+            }
+            case ObjectFile::Reloc::Kind::GlobalVar:
+            {
+                auto offset = int64_t(this->symbols[i][reloc.target].value) * 4 + reloc.addend;
+                if(offset < 0 || offset > UINT16_MAX)
+                    program.error(nocontext, "global variable offset out of range in '{}'", object.name);
+                put_le(code + reloc.offset, static_cast<uint32_t>(offset), reloc.size);
+                break;
+            }
+            case ObjectFile::Reloc::Kind::Model:
+            {
+                // the size of the value was chosen when compiling, thus the model index must still fit it.
+                auto value = this->model_values[i][reloc.target];
+                auto min_value = (reloc.size == 4? INT32_MIN : -(int64_t(1) << (8 * reloc.size - 1)));
+                if(value < min_value)
+                {
+                    program.error(nocontext, "model {} in '{}' is placed too far into the models header, recompile it",
+                                  object.models[reloc.target], object.name);
+                }
+                put_le(code + reloc.offset, static_cast<uint32_t>(value), reloc.size);
+                break;
+            }
+            default:
+                Unreachable();
+        }
+    }
+}
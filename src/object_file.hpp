@@ -0,0 +1,115 @@
+#pragma once
+#include <stdinc.h>
+#include "codegen.hpp"
+
+/// Relocatable object (`gta3sc compile -c`), turned into the final output by `gta3sc link`.
+///
+/// Each script file is compiled into an object of its own, holding its code with every reference to a label, global
+/// variable or model left unresolved (see `Reloc`). Such references go through the symbols of the object, which are
+/// either defined by it (exported) or by some other object of the program (imported), and matched by name.
+///
+/// The object of the main script also lists the objects of the other scripts, in the order they are placed. The link
+/// step lays the scripts out, assigns the global variable space and the models header, and resolves the relocations.
+struct ObjectFile
+{
+    /// A label or global variable referenced or defined by the object.
+    struct Symbol
+    {
+        enum class Kind : uint8_t
+        {
+            Label,
+            GlobalVar,
+        };
+
+        Kind                kind;
+        std::string         name;               //< Empty for labels made up by the compiler, which are never imported.
+        bool                defined;            //< Whether this object defines the symbol, otherwise it is imported.
+        uint32_t            value;              //< Position of a label relative to the code, or the index of a
+                                                //< global variable relative to the ones of the object.
+    };
+
+    /// A reference in the code to be resolved by the link step.
+    struct Reloc
+    {
+        enum class Kind : uint8_t
+        {
+            Absolute,           //< See `Relocation::Kind::Absolute`, `target` is a label symbol.
+            NegatedAbsolute,    //< See `Relocation::Kind::NegatedAbsolute`, `target` is a label symbol.
+            NegatedLocal,       //< See `Relocation::Kind::NegatedLocal`, `target` is a label symbol.
+            GlobalVar,          //< The offset of a global variable plus `addend`, `target` is a variable symbol.
+            Model,              //< The value of a model, `target` is the index of such model in `models`.
+        };
+
+        Kind                kind;
+        uint8_t             size;               //< Size of the value, in bytes.
+        uint32_t            offset;             //< Where the value goes, relative to the code.
+        uint32_t            target;
+        int32_t             addend;
+    };
+
+    uint64_t                    options_hash;
+    std::string                 name;               //< Identifies the script between the objects (its file name).
+    fs::path                    path;
+    ScriptType                  type;
+    optional<uint16_t>          mission_id;
+    optional<uint16_t>          streamed_id;
+    uint32_t                    size_global_vars;   //< Space, in words, of the global variables defined by the object.
+    uint32_t                    maximum_local;      //< Space, in words, of the local variables of the script.
+    std::vector<std::string>    children;           //< Names of the scripts required by this one.
+    std::vector<std::string>    models;             //< Unknown models used by the script.
+    std::vector<Symbol>         symbols;
+    std::vector<uint8_t>        code;
+    std::vector<Reloc>          relocations;
+    std::vector<fs::path>       objects;            //< For the main script, the objects of the other scripts, in the
+                                                    //< order of the scripts and relative to the directory of this one.
+
+    /// Builds the objects of the scripts of `gens`, generated with `Options::emit_object`.
+    ///
+    /// The first code generator must be of the main script, which is written into `output`. The other objects are
+    /// written next to it, into the paths listed by the main object.
+    static std::vector<ObjectFile> from_program(const std::vector<CodeGenerator>& gens, const SymTable& symbols,
+                                                const fs::path& output, ProgramContext& program);
+
+    /// Hashes the options that change how an object is linked, which must be the same when compiling and linking.
+    static uint64_t hash_options(const Options& options);
+
+    /// Reads the object at `path`.
+    ///
+    /// \returns the object, or `nullopt` if it could not be read or is not a valid object.
+    static optional<ObjectFile> read(const fs::path& path);
+
+    /// Writes this object into `path`.
+    bool write(const fs::path& path) const;
+};
+
+/// The objects of a program put together by the link step.
+struct LinkedProgram
+{
+    std::vector<ObjectFile>     objects;                //< The main object first, then the ones it lists.
+    uint32_t                    size_global_vars;       //< Including the 8 bytes of GOTO at the top.
+    uint32_t                    maximum_mission_local;
+    std::vector<std::string>    models;                 //< The models header.
+
+    /// Reads the main object at `path` and the objects it lists, checking they were compiled with the options of
+    /// `program`, then assigns the global variable space and the models header and resolves the symbols.
+    ///
+    /// \returns the linked program, or `nullopt` if it failed (with errors reported to `program`).
+    static optional<LinkedProgram> link(const fs::path& path, ProgramContext& program);
+
+    /// Copies the code of the `i`-th object into `output`, resolving its relocations.
+    ///
+    /// The scripts, in the same order as the objects, must already be placed (see `Script::compute_script_offsets`).
+    void relocate_into(size_t i, void* output, const std::vector<shared_ptr<Script>>& scripts,
+                       ProgramContext& program) const;
+
+private:
+    /// Where the symbols of an object are defined.
+    struct Resolved
+    {
+        uint32_t                object;                 //< For labels, the object the label is in.
+        uint32_t                value;                  //< Position of a label, or index of a global variable.
+    };
+
+    std::vector<std::vector<Resolved>>  symbols;        //< For each object, its symbols.
+    std::vector<std::vector<int32_t>>   model_values;   //< For each object, the value of its models.
+};
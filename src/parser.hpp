@@ -11,8 +11,10 @@
 ///
 #pragma once
 #include <stdinc.h>
+#include "annotation.hpp"
 
 struct ParserContext;
+class SyntaxArena;
 
 enum class Token
 {
@@ -206,17 +208,31 @@ public:
         Token  type;    //< Type of token
         size_t begin;   //< Offset for token in TokenStream::data
         size_t end;     //< Offset for token in TokenStream::data (end)
+        Atom   atom;    //< Interned identifier of Text, Command and Label (without the colon) tokens.
     };
 
     struct TextStream
     {
         const std::string   stream_name;  //< Name of this stream (usually name of the source file).
-        const std::string   data;         //< UTF-8 source file.
+        const string_view   data;         //< UTF-8 source file, kept alive by this stream.
         std::vector<size_t> line_offset;
         size_t              max_offset = 0;
 
+        /// Makes a stream of the source in `data`.
         explicit TextStream(std::string data, std::string name);
 
+        /// Makes a stream of the source in `data`, whose memory is owned by `storage`.
+        explicit TextStream(shared_ptr<const void> storage, string_view data, std::string name);
+
+        /// Makes a stream of the source file at `path`, which is mapped into memory instead of read whenever `map` is
+        /// set and it is possible.
+        ///
+        /// \warning accessing a mapping of a file truncated by someone else raises SIGBUS, thus processes which
+        /// outlive the files being edited (e.g. `--watch` or the compile server) must not map them.
+        ///
+        /// \returns the stream, or `nullopt` if the file could not be read.
+        static optional<TextStream> from_file(const fs::path& path, bool map = true);
+
         /// Gets the byte offset in this->text() that the specified line number (1-based) is in.
         ///
         /// \throws std::logic_error if lineno does not exist.
@@ -234,6 +250,11 @@ public:
 
         /// Gets the text in the stream in the specified range.
         string_view get_text(size_t begin, size_t end) const; 
+
+    private:
+        explicit TextStream(shared_ptr<const std::string> storage, std::string name);
+
+        shared_ptr<const void> storage;   //< Owner of the memory in `data`.
     };
 
     // Used for error messages.
@@ -259,8 +280,11 @@ public:
     /// Tokenizes the specified file.
     static std::shared_ptr<TokenStream> tokenize(ProgramContext&, const fs::path&);
 
-    /// Tokenizes the specified data.
-    static std::shared_ptr<TokenStream> tokenize(ProgramContext&, std::string data, const char* stream_name);
+    /// Interns the identifier of a token of `type` spelled as `text`, or gives the null atom if such token has none.
+    static Atom atom_for(Token type, const string_view& text);
+
+    /// Tokenizes the specified stream.
+    static std::shared_ptr<TokenStream> tokenize(ProgramContext&, TextStream stream);
 
     TokenStream(TokenStream&&);
     TokenStream(const TokenStream&) = delete;
@@ -269,24 +293,33 @@ public:
     std::string to_string() const;
 
 private:
+    friend class ScriptCache;
+
     ProgramContext&         program;
 
-    explicit TokenStream(ProgramContext&, const char* stream_name, std::string data, std::vector<TokenData>);
     explicit TokenStream(ProgramContext&, TextStream stream, std::vector<TokenData>);
 };
 
 ///////////////////////////////
 
-class SyntaxTree : public std::enable_shared_from_this<SyntaxTree>
+/// Abstract syntax tree node.
+///
+/// All the nodes of a tree are allocated in a single `SyntaxArena`, which is kept alive by any `shared_ptr`
+/// to any of its nodes. Nodes refer to each other through plain pointers.
+class SyntaxTree
 {
+private:
+    using ChildList = small_vector<SyntaxTree*, 4>;
+
 public:
-    using iterator       = std::vector<std::shared_ptr<SyntaxTree>>::iterator;
-    using const_iterator = std::vector<std::shared_ptr<SyntaxTree>>::const_iterator;
+    using iterator       = ChildList::iterator;
+    using const_iterator = ChildList::const_iterator;
 
 public:
+    /// Parses the tokens into a new syntax tree, or returns `nullptr` on failure.
     static std::shared_ptr<SyntaxTree> compile(ProgramContext&, const TokenStream& tstream);
     SyntaxTree(const SyntaxTree&) = delete;
-    SyntaxTree(SyntaxTree&&);
+    SyntaxTree(SyntaxTree&&) = delete;
     
     /// Gets the type of this node.
     NodeType type() const
@@ -298,10 +331,18 @@ public:
     string_view text() const
     {
         Expects(this->instream != nullptr);
-        auto source_data = this->instream->tstream.lock()->text.data.c_str();
+        auto source_data = this->instream->tstream.lock()->text.data.data();
         return string_view(source_data + this->token.begin, this->token.end - this->token.begin);
     }
 
+    /// Gets the interned identifier of `text()`.
+    Atom atom() const
+    {
+        if(this->token.atom)
+            return this->token.atom;
+        return Atom::intern(this->text());
+    }
+
     /// Checks if `text().empty()`.
     bool has_text() const
     {
@@ -310,7 +351,7 @@ public:
         return false;
     }
 
-    /// Iterator to childs (begin).
+    /// Iterator to childs (begin). Dereferences into a `SyntaxTree*`.
     iterator begin()
     {
         return this->childs.begin();
@@ -353,29 +394,33 @@ public:
     }
 
     /// Gets the parent node, or `nullptr` if none.
-    std::shared_ptr<SyntaxTree> parent() const
+    SyntaxTree* parent() const
     {
-        if(this->parent_)
-            return this->parent_.value().lock();
-        return nullptr;
+        return this->parent_;
     }
 
+    /// Gets a shared pointer to this node, which keeps the whole tree alive.
+    shared_ptr<SyntaxTree> shared_from_this();
+
+    /// Gets a shared pointer to this node, which keeps the whole tree alive.
+    shared_ptr<const SyntaxTree> shared_from_this() const;
+
     // Adds a child to this node.
-    void add_child(shared_ptr<SyntaxTree> child)
+    void add_child(SyntaxTree* child)
     {
-        Expects(child->parent_ == nullopt);
-        child->parent_ = std::weak_ptr<SyntaxTree>(this->shared_from_this());
-        this->childs.emplace_back(std::move(child));
+        Expects(child->parent_ == nullptr && child->arena == this->arena);
+        child->parent_ = this;
+        this->childs.emplace_back(child);
     }
 
     // Steals the childs from the other tree.
-    void take_childs(shared_ptr<SyntaxTree>& other)
+    void take_childs(SyntaxTree* other)
     {
         this->childs.reserve(this->childs.size() + other->childs.size());
         for(auto& child : other->childs)
         {
-            child->parent_ = std::weak_ptr<SyntaxTree>(this->shared_from_this());
-            this->childs.emplace_back(std::move(child));
+            child->parent_ = this;
+            this->childs.emplace_back(child);
         }
 
         other->childs.clear();
@@ -394,22 +439,23 @@ public:
         }
     }
 
-    /// Sets the annotation for this node.
+    /// Sets the annotation for this node. The type of `v` must be one of the `Annotation` alternatives.
     template<typename ValueType>
     void set_annotation(ValueType&& v)
     {
-        this->udata = std::forward<ValueType>(v);
+        this->udata.template emplace<std::decay_t<ValueType>>(std::forward<ValueType>(v));
     }
 
     /// Gets the annotation of this node, previosly set with `set_annotation`.
     ///
     /// Note: You can get a ref by using e.g. `<int&>` instead of `<int>`.
     ///
-    /// \throws bad_any_cast if there's no annotation on this node.
+    /// \throws bad_variant_access if there's no annotation of such type on this node.
     template<typename T>
     T annotation() const
     {
-        return any_cast<T>(this->udata);
+        using TNoRef = std::remove_cv_t<std::remove_reference_t<T>>;
+        return get<TNoRef>(this->udata);
     }
 
     /// Gets the annotation of this node, previosly set with `set_annotation`, or `nullopt` if not set.
@@ -418,8 +464,8 @@ public:
     template<typename T>
     optional<T> maybe_annotation() const
     {
-        using TNoRef = std::remove_reference_t<T>;
-        if(const TNoRef* p = any_cast<TNoRef>(&this->udata))
+        using TNoRef = std::remove_cv_t<std::remove_reference_t<T>>;
+        if(const TNoRef* p = this->udata.template target<TNoRef>())
             return *p;
         return nullopt;
     }
@@ -427,11 +473,11 @@ public:
     /// Checks if this node has been annotated.
     bool is_annotated() const
     {
-        return !this->udata.empty();
+        return bool(this->udata);
     }
 
-    /// Returns an `any` object associated with the annotation.
-    const any& annotation_any() const
+    /// Gets the annotation of this node, whatever its type is.
+    const Annotation& annotation_variant() const
     {
         return this->udata;
     }
@@ -439,7 +485,7 @@ public:
     /// Filename of the input stream associated with this SyntaxTree, or empty if none.
     std::string filename() const
     {
-        return this->instream? *this->instream->filename : "";
+        return this->instream? this->instream->filename : "";
     }
 
     /// Input stream associated with this SyntaxTree, or `nullptr` if none.
@@ -458,39 +504,114 @@ public:
     /// For debugging purposes.
     std::string to_string(size_t level = 0) const;
 
+    /// Deep copies this node (and its childs) into the same tree. The copy has no parent.
+    SyntaxTree* clone() const;
+
 protected:
     friend class TokenStream;
+    friend class SyntaxArena;
+    friend class ScriptCache;
     friend struct ParserContext;
 
     struct InputStream
     {
-        shared_ptr<std::string>     filename;   //< Name of the input file. Stored also here because tstream may get deallocated.
+        std::string                 filename;   //< Name of the input file. Stored also here because tstream may get deallocated.
         weak_ptr<const TokenStream> tstream;    //< Input token stream, if still allocated.
     };
 
 private:
-    NodeType                                    type_;  // const NodeType
-    TokenStream::TokenData                      token;      // invalid if (instream == nullptr)
-    shared_ptr<InputStream>                     instream;   // may be nullptr
-    std::vector<std::shared_ptr<SyntaxTree>>    childs;
-    optional<std::weak_ptr<SyntaxTree>>         parent_;
-    any                                         udata;
+    NodeType                    type_;      // const NodeType
+    TokenStream::TokenData      token;      // invalid if (instream == nullptr)
+    const InputStream*          instream;   // may be nullptr
+    SyntaxArena*                arena;      // arena owning this node
+    SyntaxTree*                 parent_ = nullptr;
+    ChildList                   childs;
+    Annotation                  udata;
+
+    explicit SyntaxTree(SyntaxArena& arena, NodeType type)
+        : type_(type), instream(nullptr), arena(&arena)
+    {
+    }
+
+    explicit SyntaxTree(SyntaxArena& arena, NodeType type, const InputStream& instream, const TokenStream::TokenData& token)
+        : type_(type), token(token), instream(&instream), arena(&arena)
+    {
+    }
+
+public:
+    ~SyntaxTree() = default;
+};
 
+/// Bump allocator owning all the nodes of a syntax tree (and its input stream information).
+///
+/// Nodes are never freed individually, only when the whole arena goes away.
+class SyntaxArena : public std::enable_shared_from_this<SyntaxArena>
+{
 public:
-    explicit SyntaxTree(NodeType type, any udata)
-        : type_(type), instream(nullptr), udata(std::move(udata))
+    explicit SyntaxArena(const TokenStream& tstream)
+    {
+        this->instream.filename = tstream.text.stream_name;
+        this->instream.tstream  = tstream.shared_from_this();
+    }
+
+    SyntaxArena(const SyntaxArena&) = delete;
+    SyntaxArena& operator=(const SyntaxArena&) = delete;
+
+    ~SyntaxArena()
+    {
+        for(auto& chunk : this->chunks)
+        {
+            for(size_t i = 0; i < chunk->used; ++i)
+                reinterpret_cast<SyntaxTree*>(&chunk->nodes[i])->~SyntaxTree();
+        }
+    }
+
+    /// Allocates a node without a token.
+    SyntaxTree* make_node(NodeType type)
+    {
+        return new (this->allocate()) SyntaxTree(*this, type);
+    }
+
+    /// Allocates a node associated with the specified token.
+    SyntaxTree* make_node(NodeType type, const TokenStream::TokenData& token)
     {
+        return new (this->allocate()) SyntaxTree(*this, type, this->instream, token);
     }
 
-    explicit SyntaxTree(NodeType type, shared_ptr<InputStream>& instream, const TokenStream::TokenData& token)
-        : type_(type), instream(instream), token(token)
+    /// Number of nodes allocated in this arena.
+    size_t size() const
     {
+        return this->chunks.empty()? 0 : (this->chunks.size() - 1) * chunk_size + this->chunks.back()->used;
     }
 
-    explicit SyntaxTree(NodeType type)
-        : type_(type), instream(nullptr)
+private:
+    static constexpr size_t chunk_size = 512;
+
+    struct Chunk
     {
+        std::aligned_storage_t<sizeof(SyntaxTree), alignof(SyntaxTree)> nodes[chunk_size];
+        size_t used = 0;
+    };
+
+    void* allocate()
+    {
+        if(this->chunks.empty() || this->chunks.back()->used == chunk_size)
+            this->chunks.emplace_back(new Chunk);
+        auto& chunk = *this->chunks.back();
+        return &chunk.nodes[chunk.used++];
     }
 
-    shared_ptr<SyntaxTree> clone() const;
+private:
+    SyntaxTree::InputStream                 instream;
+    std::vector<std::unique_ptr<Chunk>>     chunks;
 };
+
+inline shared_ptr<SyntaxTree> SyntaxTree::shared_from_this()
+{
+    return shared_ptr<SyntaxTree>(this->arena->shared_from_this(), this);
+}
+
+inline shared_ptr<const SyntaxTree> SyntaxTree::shared_from_this() const
+{
+    return shared_ptr<const SyntaxTree>(this->arena->shared_from_this(), this);
+}
@@ -1,6 +1,21 @@
 #include <stdinc.h>
 #include "parser.hpp"
 #include "program.hpp"
+#include "system.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GTA3SC_LEXER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(GTA3SC_LEXER_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define GTA3SC_LEXER_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 using TokenData = TokenStream::TokenData;
 
@@ -15,10 +30,11 @@ struct LexerContext
     bool in_dump_mode = false;              //< True if inside a DUMP...ENDDUMP block.
     size_t comment_nest_level = 0;          //< Nest level of /* comments */
     std::vector<TokenData> tokens;          //< Output tokens.
-    std::string            line_buffer;     //< Buffer used to parse a line, since we'll be mutating the line.
+    std::vector<std::pair<const char*, const char*>> comments;  //< /* comments */ of the line being lexed.
+    std::string            line_buffer;     //< Buffer for the few lines with a comment in the middle of its code.
 
-    explicit LexerContext(ProgramContext& program, std::string data, std::string stream_name) :
-        program(program), stream(std::move(data), std::move(stream_name))
+    explicit LexerContext(ProgramContext& program, TokenStream::TextStream stream) :
+        program(program), stream(std::move(stream))
     {
         cpp_stack.reserve(32);
         cpp_stack.emplace_back(true);
@@ -35,7 +51,8 @@ struct LexerContext
 
     void add_token(Token type, size_t begin_pos, size_t length)
     {
-        this->tokens.emplace_back(TokenData{ type, begin_pos, begin_pos + length });
+        Atom atom = TokenStream::atom_for(type, this->stream.data.substr(begin_pos, length));
+        this->tokens.emplace_back(TokenData{ type, begin_pos, begin_pos + length, atom });
     }
 
     void hint_will_push_tokens(size_t count)
@@ -143,22 +160,49 @@ static const std::pair<string_view, Token> expr_symbols[] = {
     DEFINE_SYMBOL(">", Token::Greater),
 };
 
+enum : uint8_t
+{
+    CHAR_SPACE      = 1 << 0,   //< ' ' and '\t'.
+    CHAR_WHITE      = 1 << 1,   //< Characters separating tokens.
+    CHAR_XDIGIT     = 1 << 2,   //< Hexadecimal digits.
+    CHAR_EXPR       = 1 << 3,   //< Characters of expression tokens, but the minus sign.
+};
+
+/// Classes (`CHAR_*` flags) of each character, shared by the character tests of the lexer.
+static const std::array<uint8_t, 256> lex_charclass = []
+{
+    std::array<uint8_t, 256> table = {};
+
+    for(uint8_t c : { ' ', '\t' })
+        table[c] |= CHAR_SPACE | CHAR_WHITE;
+    for(uint8_t c : { '(', ')', ',', '\r' })
+        table[c] |= CHAR_WHITE;
+    for(uint8_t c : { '+', '*', '/', '=', '<', '>' })
+        table[c] |= CHAR_EXPR;
+
+    for(int c = '0'; c <= '9'; ++c) table[c] |= CHAR_XDIGIT;
+    for(int c = 'A'; c <= 'F'; ++c) table[c] |= CHAR_XDIGIT;
+    for(int c = 'a'; c <= 'f'; ++c) table[c] |= CHAR_XDIGIT;
+
+    return table;
+}();
+
 /// Checks if `c` is a whitespace.
 static bool lex_iswhite(int c)
 {
-    return c == ' ' || c == '\t' || c == '(' || c == ')' || c == ',' || c == '\r';
+    return (lex_charclass[uint8_t(c)] & CHAR_WHITE) != 0;
 }
 
 /// Fast alternative to ::isspace.
 static bool lex_isspace2(int c)
 {
-    return c == ' ' || c == '\t';
+    return (lex_charclass[uint8_t(c)] & CHAR_SPACE) != 0;
 }
 
 /// Fast alternative to ::isxdigit
 static bool lex_isxdigit(int c)
 {
-    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+    return (lex_charclass[uint8_t(c)] & CHAR_XDIGIT) != 0;
 }
 
 /// Checks if `token` is equal `string` which has `length`.
@@ -194,7 +238,7 @@ static bool lex_isexprc(const char* it, const char* end)
         }
         return true;
     }
-    return (*it == '+' || *it == '*' || *it == '/' || *it == '=' || *it == '<' || *it == '>');
+    return (lex_charclass[uint8_t(*it)] & CHAR_EXPR) != 0;
 }
 
 /// Gets the next whitespace delimited token in `it`.
@@ -426,10 +470,15 @@ static void lex_dump(LexerContext& lexer, const char* begin, const char* end, si
     }
 }
 
-/// Tranforms comments into whitespaces.
-static void lex_comments(LexerContext& lexer, char* begin, char* end, size_t begin_pos)
+/// Finds the comments in a line, which are taken as whitespaces.
+///
+/// The ranges of the line within /* comments */ are pushed into `lexer.comments`.
+///
+/// Returns the end of the line before any // comment.
+static const char* lex_comments(LexerContext& lexer, const char* begin, const char* end, size_t begin_pos)
 {
     bool in_quotes = false;
+    const char* comment_begin = (lexer.comment_nest_level? begin : nullptr);
 
     for(auto it = begin; it != end; ++it)
     {
@@ -445,13 +494,15 @@ static void lex_comments(LexerContext& lexer, char* begin, char* end, size_t beg
             }
             else if(*it == '/' && *std::next(it) == '/')
             {
-                std::memset(it, ' ', end - it);
-                return;
+                if(comment_begin)
+                    lexer.comments.emplace_back(comment_begin, it);
+                return it;
             }
             else if(*it == '/' && *std::next(it) == '*')
             {
-                ++lexer.comment_nest_level;
-                *it++ = ' '; *it = ' ';
+                if(lexer.comment_nest_level++ == 0)
+                    comment_begin = it;
+                ++it;
             }
             else if(*it == '*' && *std::next(it) == '/')
             {
@@ -460,23 +511,30 @@ static void lex_comments(LexerContext& lexer, char* begin, char* end, size_t beg
                     lexer.error(begin_pos + std::distance(begin, it), "no comment to close");
                     ++it;
                 }
+                else if(--lexer.comment_nest_level == 0)
+                {
+                    ++it;
+                    lexer.comments.emplace_back(comment_begin, std::next(it));
+                    comment_begin = nullptr;
+                }
                 else
                 {
-                    --lexer.comment_nest_level;
-                    *it++ = ' '; *it = ' ';
+                    ++it;
                 }
             }
         }
-
-        if(lexer.comment_nest_level)
-            *it = ' ';
     }
+
+    if(comment_begin)
+        lexer.comments.emplace_back(comment_begin, end);
+
+    return end;
 }
 
 /// Processes the mini-preprocessor.
 ///
 /// Returns true in case we can keep reading this line, false otherwise.
-static bool lex_cpp(LexerContext& lexer, char* begin, char* end, size_t begin_pos)
+static bool lex_cpp(LexerContext& lexer, const char* begin, const char* end, size_t begin_pos)
 {
     auto next_char_it = std::find_if_not(begin, end, lex_isspace2);
     if(next_char_it != end && *next_char_it == '#')
@@ -546,14 +604,42 @@ static bool lex_cpp(LexerContext& lexer, char* begin, char* end, size_t begin_po
 }
 
 /// Lexes a line.
-static void lex_line(LexerContext& lexer, const char* source_data, size_t begin_pos, size_t end_pos)
+static void lex_line(LexerContext& lexer, const char* source_data, size_t line_pos, size_t end_pos)
 {
-    lexer.line_buffer.assign(source_data + begin_pos, source_data + end_pos);
-
     bool had_keycommand = false;
 
-    auto begin = (const char*)(&lexer.line_buffer[0]);
-    auto end = begin + lexer.line_buffer.size();
+    auto begin = source_data + line_pos;
+    auto end = lex_comments(lexer, begin, source_data + end_pos, line_pos);
+
+    // The line is lexed in place, with the comments around its code skipped over. Only when a comment is in the
+    // middle of the code the line is copied into a buffer, where the comment gets blanked out.
+    auto comment_it = lexer.comments.begin(), comment_end = lexer.comments.end();
+    while((begin = std::find_if_not(begin, end, lex_isspace2)) != end
+        && comment_it != comment_end && comment_it->first <= begin)
+    {
+        begin = (comment_it++)->second;
+    }
+    while((end = std::find_if_not(std::make_reverse_iterator(end), std::make_reverse_iterator(begin), lex_iswhite).base()) != begin
+        && comment_it != comment_end && std::prev(comment_end)->second >= end)
+    {
+        end = (--comment_end)->first;
+    }
+
+    size_t begin_pos = size_t(begin - source_data);
+
+    if(comment_it != comment_end && begin != end)
+    {
+        lexer.line_buffer.assign(begin, end);
+        auto buffer = &lexer.line_buffer[0];
+        for(; comment_it != comment_end; ++comment_it)
+            std::fill(buffer + (comment_it->first - begin), buffer + (comment_it->second - begin), ' ');
+
+        begin = buffer;
+        end = buffer + lexer.line_buffer.size();
+    }
+
+    lexer.comments.clear();
+
     auto it = begin;
 
     auto push_token = [&](const std::pair<const char*, size_t>& token, Token type) -> const char*
@@ -568,9 +654,7 @@ static void lex_line(LexerContext& lexer, const char* source_data, size_t begin_
         lexer.add_token(Token::NewLine, end_pos, 0);
     };
 
-    lex_comments(lexer, &lexer.line_buffer[0], &lexer.line_buffer[0] + lexer.line_buffer.size(), begin_pos);
-
-    if(!lex_cpp(lexer, &lexer.line_buffer[0], &lexer.line_buffer[0] + lexer.line_buffer.size(), begin_pos))
+    if(!lex_cpp(lexer, begin, end, begin_pos))
         return;
 
     it = std::find_if_not(it, end, lex_iswhite);
@@ -579,9 +663,9 @@ static void lex_line(LexerContext& lexer, const char* source_data, size_t begin_
     if(std::distance(it, end) == 0)
         return;
 
-    if(lexer.program.opt.pedantic && lexer.line_buffer.size() > 255)
+    if(lexer.program.opt.pedantic && end_pos - line_pos > 255)
     {
-        lexer.pedantic(begin_pos, "line is too long, miss2 only allows 255 characters [-pedantic]");
+        lexer.pedantic(line_pos, "line is too long, miss2 only allows 255 characters [-pedantic]");
     }
 
     if(lexer.in_dump_mode)
@@ -703,23 +787,106 @@ static void lex_line(LexerContext& lexer, const char* source_data, size_t begin_
 
 
 //
-// TokenStream
+// Newline indexing
+//
+// Building the line table is the one pass over every byte of a source which is not driven by its tokens, thus it
+// compares a whole vector of bytes against the newline at a time. The AVX2 version is chosen at runtime, since the
+// executable must run on any x86-64 processor, which always has SSE2. Other processors use memchr.
 //
 
-std::shared_ptr<TokenStream> TokenStream::tokenize(ProgramContext& program, std::string data_, const char* stream_name)
+/// Gets the index of the lowest bit set in the non-zero `mask`.
+static uint32_t lex_lowest_bit(uint32_t mask)
 {
-    LexerContext lexer(program, std::move(data_), stream_name);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return uint32_t(index);
+#else
+    return uint32_t(__builtin_ctz(mask));
+#endif
+}
 
-    auto begin = lexer.stream.data.c_str();
-    auto end = lexer.stream.data.c_str() + lexer.stream.data.size();
+/// Pushes the offset after each newline within the block at `pos`, as given by the bits of `mask`, into `offsets`.
+static void lex_push_newlines(uint32_t mask, size_t pos, std::vector<size_t>& offsets)
+{
+    for(; mask != 0; mask &= mask - 1)
+        offsets.emplace_back(pos + lex_lowest_bit(mask) + 1);
+}
 
-    for(auto it = begin; it != end; )
+#if defined(GTA3SC_LEXER_SSE2)
+/// Indexes the newlines of the whole 16 bytes blocks of `data` from `pos` onwards.
+///
+/// \returns the position of the first byte left unindexed.
+static size_t lex_index_newlines_sse2(const char* data, size_t pos, size_t size, std::vector<size_t>& offsets)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    for(; pos + 16 <= size; pos += 16)
     {
-        const char *line_start = it;
-        const char *line_end   = std::find(it, end, '\n');
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        lex_push_newlines(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline))), pos, offsets);
+    }
+    return pos;
+}
+#endif
+
+#if defined(GTA3SC_LEXER_AVX2)
+/// Indexes the newlines of the whole 32 bytes blocks of `data` from `pos` onwards.
+///
+/// \returns the position of the first byte left unindexed.
+__attribute__((target("avx2")))
+static size_t lex_index_newlines_avx2(const char* data, size_t pos, size_t size, std::vector<size_t>& offsets)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    for(; pos + 32 <= size; pos += 32)
+    {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        lex_push_newlines(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline))), pos, offsets);
+    }
+    return pos;
+}
+#endif
+
+/// Pushes the offset after each newline of `data` into `offsets`.
+static void lex_index_newlines(const char* data, size_t size, std::vector<size_t>& offsets)
+{
+    size_t pos = 0;
+
+#if defined(GTA3SC_LEXER_AVX2)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if(has_avx2)
+        pos = lex_index_newlines_avx2(data, pos, size, offsets);
+#endif
+
+#if defined(GTA3SC_LEXER_SSE2)
+    pos = lex_index_newlines_sse2(data, pos, size, offsets);
+#endif
+
+    for(const char* it = data + pos, *end = data + size;
+        (it = static_cast<const char*>(std::memchr(it, '\n', size_t(end - it)))) != nullptr; ++it)
+    {
+        offsets.emplace_back(size_t(it - data) + 1);
+    }
+}
+
+//
+// TokenStream
+//
+
+std::shared_ptr<TokenStream> TokenStream::tokenize(ProgramContext& program, TextStream stream)
+{
+    LexerContext lexer(program, std::move(stream));
 
-        lex_line(lexer, begin, std::distance(begin, line_start), std::distance(begin, line_end));
-        it = (line_end == end? line_end : std::next(line_end));
+    auto data = lexer.stream.data.data();
+    auto size = lexer.stream.data.size();
+    auto& lines = lexer.stream.line_offset;
+
+    // the line table already has where every line begins, and each ends right before the next one.
+    for(size_t i = 0; i < lines.size() && lines[i] < size; ++i)
+    {
+        size_t line_end = (i + 1 < lines.size()? lines[i + 1] - 1 : size);
+        lex_line(lexer, data, lines[i], line_end);
     }
 
     lexer.verify_nesting();
@@ -732,9 +899,9 @@ std::shared_ptr<TokenStream> TokenStream::tokenize(ProgramContext& program, std:
 
 std::shared_ptr<TokenStream> TokenStream::tokenize(ProgramContext& program, const fs::path& path)
 {
-    if(auto opt_data = read_file_utf8(path))
+    if(auto opt_stream = TextStream::from_file(path, program.opt.map_sources))
     {
-        return TokenStream::tokenize(program, *opt_data, path.generic_u8string().c_str());
+        return TokenStream::tokenize(program, std::move(*opt_stream));
     }
     else
     {
@@ -743,9 +910,13 @@ std::shared_ptr<TokenStream> TokenStream::tokenize(ProgramContext& program, cons
     }
 }
 
-TokenStream::TokenStream(ProgramContext& program, const char* stream_name, std::string data, std::vector<TokenData> tokens)
-    : program(program), text(std::move(data), stream_name), tokens(std::move(tokens))
+Atom TokenStream::atom_for(Token type, const string_view& text)
 {
+    if(type == Token::Text || type == Token::Command)
+        return Atom::intern(text);
+    else if(type == Token::Label && !text.empty())
+        return Atom::intern(text.substr(0, text.size() - 1));
+    return Atom();
 }
 
 TokenStream::TokenStream(ProgramContext& program, TextStream stream, std::vector<TokenData> tokens)
@@ -760,7 +931,17 @@ TokenStream::TokenStream(TokenStream&& rhs)
 }
 
 TokenStream::TextStream::TextStream(std::string data_, std::string name_)
-    : data(std::move(data_)), stream_name(std::move(name_))
+    : TextStream(std::make_shared<const std::string>(std::move(data_)), std::move(name_))
+{
+}
+
+TokenStream::TextStream::TextStream(shared_ptr<const std::string> storage_, std::string name_)
+    : TextStream(storage_, string_view(*storage_), std::move(name_))
+{
+}
+
+TokenStream::TextStream::TextStream(shared_ptr<const void> storage_, string_view data_, std::string name_)
+    : stream_name(std::move(name_)), data(data_), storage(std::move(storage_))
 {
     this->max_offset = this->data.size();
     if(!this->data.empty())
@@ -771,27 +952,37 @@ TokenStream::TextStream::TextStream(std::string data_, std::string name_)
         // pushes first line offset
         this->line_offset.emplace_back(0);
 
-        for(const char* it = this->data.c_str(); *it; ++it)
-        {
-            if(*it == '\n')
-            {
-                size_t pos = (it - this->data.c_str());
-                this->line_offset.emplace_back(pos + 1);
-            }
-        }
+        lex_index_newlines(this->data.data(), this->data.size(), this->line_offset);
 
         this->line_offset.shrink_to_fit();
     }
 }
 
+auto TokenStream::TextStream::from_file(const fs::path& path, bool map) -> optional<TextStream>
+{
+    size_t size = 0;
+    if(const void* data = map? map_file_readonly(path, size) : nullptr)
+    {
+        shared_ptr<const void> storage(data, [size](const void* data) { unmap_file(data, size); });
+        return TextStream(std::move(storage), string_view(static_cast<const char*>(data), size), path.generic_u8string());
+    }
+
+    // empty files cannot be mapped, and neither can some exotic ones, thus read those.
+    if(auto opt_data = read_file_utf8(path))
+        return TextStream(std::move(*opt_data), path.generic_u8string());
+
+    return nullopt;
+}
+
 std::string TokenStream::TextStream::get_line(size_t lineno) const
 {
     size_t offset = offset_for_line(lineno);
 
-    const char* start = this->data.c_str() + offset;
+    const char* start = this->data.data() + offset;
+    const char* limit = this->data.data() + this->data.size();
     const char* end;
 
-    for(end = start; *end && *end != '\n' && *end != '\r'; ++end) {
+    for(end = start; end != limit && *end != '\n' && *end != '\r'; ++end) {
     }
 
     return std::string(start, end);
@@ -827,8 +1018,7 @@ auto TokenStream::TextStream::linecol_from_offset(size_t offset) const -> std::p
 string_view TokenStream::TextStream::get_text(size_t begin, size_t end) const
 {
     Expects(begin <= end && end <= this->data.size());
-    auto data = this->data.c_str();
-    return string_view(data + begin, end - begin);
+    return this->data.substr(begin, end - begin);
 }
 
 std::string TokenStream::to_string() const
@@ -836,7 +1026,7 @@ std::string TokenStream::to_string() const
     std::string output;
     for(auto& token : this->tokens)
     {
-        auto string = std::string(this->text.data.c_str() + token.begin, this->text.data.c_str() + token.end);
+        auto string = this->text.get_text(token.begin, token.end).to_string();
         output += fmt::format("({}) '{}'\n", (int)(token.type), string);
     }
     return output;
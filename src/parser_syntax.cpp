@@ -16,14 +16,21 @@ struct ParserContext
 {
     ProgramContext&                      program;
     const TokenStream&                   tstream;
-    shared_ptr<SyntaxTree::InputStream>  instream;
+    shared_ptr<SyntaxArena>              arena;
 
     ParserContext(ProgramContext& program, const TokenStream& tstream) :
-        program(program), tstream(tstream)
+        program(program), tstream(tstream), arena(std::make_shared<SyntaxArena>(tstream))
     {
-        this->instream = std::make_shared<SyntaxTree::InputStream>();
-        this->instream->filename = std::make_shared<std::string>(tstream.text.stream_name);
-        this->instream->tstream = tstream.shared_from_this();
+    }
+
+    SyntaxTree* make_node(NodeType type)
+    {
+        return arena->make_node(type);
+    }
+
+    SyntaxTree* make_node(NodeType type, const TokenData& token)
+    {
+        return arena->make_node(type, token);
     }
 
     string_view get_text(const TokenData& token) const
@@ -34,17 +41,14 @@ struct ParserContext
 
 struct ParserSuccess
 {
-    shared_ptr<SyntaxTree> tree;
-
-    explicit ParserSuccess(std::nullptr_t)
-    {}
+    SyntaxTree* tree;   //< Allocated in the `ParserContext::arena`.
 
-    explicit ParserSuccess(shared_ptr<SyntaxTree> tree) :
-        tree(std::move(tree))
+    explicit ParserSuccess(std::nullptr_t) :
+        tree(nullptr)
     {}
 
-    explicit ParserSuccess(SyntaxTree* to_smart_ptr) :
-        tree(to_smart_ptr)
+    explicit ParserSuccess(SyntaxTree* tree) :
+        tree(tree)
     {}
 };
 
@@ -214,7 +218,7 @@ static ParserResult parse_until_if(RuleFunc rule,
                                    ParserContext& parser, token_iterator begin, token_iterator end,
                                    UntilCondition cond)
 {
-    shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::Block));
+    SyntaxTree* tree = parser.make_node(NodeType::Block);
     auto it = begin;
 
     ParserState state = ParserSuccess(nullptr);
@@ -259,7 +263,7 @@ static ParserResult parse_identifier(ParserContext& parser, token_iterator begin
     if(begin != end && begin->type == Token::Text)
     {
         if(Miss2Identifier::is_identifier(parser.get_text(*begin), parser.program.opt))
-            return std::make_pair(std::next(begin), ParserSuccess(new SyntaxTree(NodeType::Text, parser.instream, *begin)));
+            return std::make_pair(std::next(begin), ParserSuccess(parser.make_node(NodeType::Text, *begin)));
     }
     return std::make_pair(end, make_error(ParserStatus::GiveUp, begin));
 }
@@ -273,7 +277,7 @@ static ParserResult parse_integer(ParserContext& parser, token_iterator begin, t
 {
     if(begin != end && begin->type == Token::Integer)
     {
-        return std::make_pair(std::next(begin), ParserSuccess(new SyntaxTree(NodeType::Integer, parser.instream, *begin)));
+        return std::make_pair(std::next(begin), ParserSuccess(parser.make_node(NodeType::Integer, *begin)));
     }
     return std::make_pair(end, make_error(ParserStatus::GiveUp, begin));
 }
@@ -287,7 +291,7 @@ static ParserResult parse_float(ParserContext& parser, token_iterator begin, tok
 {
     if(begin != end && begin->type == Token::Float)
     {
-        return std::make_pair(std::next(begin), ParserSuccess(new SyntaxTree(NodeType::Float, parser.instream, *begin)));
+        return std::make_pair(std::next(begin), ParserSuccess(parser.make_node(NodeType::Float, *begin)));
     }
     return std::make_pair(end, make_error(ParserStatus::GiveUp, begin));
 }
@@ -325,7 +329,7 @@ static ParserResult parse_scope_statement(ParserContext& parser, token_iterator
 
         if(is<ParserSuccess>(state))
         {
-            shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::Scope, parser.instream, *begin));
+            SyntaxTree* tree = parser.make_node(NodeType::Scope, *begin);
             tree->add_child(get<ParserSuccess>(statements).tree);
             return std::make_pair(it, ParserSuccess(std::move(tree)));
         }
@@ -350,22 +354,22 @@ static ParserResult parse_argument(ParserContext& parser, token_iterator begin,
     }
     else if(begin->type == Token::Integer)
     {
-        shared_ptr<SyntaxTree> node(new SyntaxTree(NodeType::Integer, parser.instream, *begin));
+        SyntaxTree* node = parser.make_node(NodeType::Integer, *begin);
         return std::make_pair(std::next(begin), ParserSuccess(std::move(node)));
     }
     else if(begin->type == Token::Float)
     {
-        shared_ptr<SyntaxTree> node(new SyntaxTree(NodeType::Float, parser.instream, *begin));
+        SyntaxTree* node = parser.make_node(NodeType::Float, *begin);
         return std::make_pair(std::next(begin), ParserSuccess(std::move(node)));
     }
     else if(begin->type == Token::Text)
     {
-        shared_ptr<SyntaxTree> node(new SyntaxTree(NodeType::Text, parser.instream, *begin));
+        SyntaxTree* node = parser.make_node(NodeType::Text, *begin);
         return std::make_pair(std::next(begin), ParserSuccess(std::move(node)));
     }
     else if(begin->type == Token::String)
     {
-        shared_ptr<SyntaxTree> node(new SyntaxTree(NodeType::String, parser.instream, *begin));
+        SyntaxTree* node = parser.make_node(NodeType::String, *begin);
         return std::make_pair(std::next(begin), ParserSuccess(std::move(node)));
     }
     return std::make_pair(std::next(begin), make_error(ParserStatus::GiveUp, begin));
@@ -417,7 +421,7 @@ static ParserResult parse_expression_statement(ParserContext& parser, token_iter
 
                         if(is<ParserSuccess>(state))
                         {
-                            shared_ptr<SyntaxTree> tree(new SyntaxTree(opa.value(), parser.instream, *op_it));
+                            SyntaxTree* tree = parser.make_node(opa.value(), *op_it);
                             tree->add_child(get<ParserSuccess>(lhs).tree);
                             tree->add_child(get<ParserSuccess>(rhs).tree);
                             return std::make_pair(it, ParserSuccess(std::move(tree)));
@@ -516,7 +520,7 @@ static ParserResult parse_expression_statement(ParserContext& parser, token_iter
 
                     std::tie(std::ignore, ident) = parse_identifier(parser, id_it, end);
 
-                    shared_ptr<SyntaxTree> tree(new SyntaxTree(opa.value(), parser.instream, *op_it));
+                    SyntaxTree* tree = parser.make_node(opa.value(), *op_it);
                     tree->add_child(get<ParserSuccess>(ident).tree);
                     return std::make_pair(it, ParserSuccess(std::move(tree)));
                 }
@@ -595,8 +599,8 @@ static ParserResult parse_expression_statement(ParserContext& parser, token_iter
             {
                 if(is<ParserSuccess>(state))
                 {
-                    shared_ptr<SyntaxTree> state_tree = get<ParserSuccess>(state).tree;
-                    shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::Equal));
+                    SyntaxTree* state_tree = get<ParserSuccess>(state).tree;
+                    SyntaxTree* tree = parser.make_node(NodeType::Equal);
 
                     tree->add_child(state_tree->child(0).clone());
                     tree->add_child(state_tree);
@@ -658,8 +662,8 @@ static ParserResult parse_actual_command_statement(ParserContext& parser, token_
 
         if(is<ParserSuccess>(arguments))
         {
-            shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::Command, parser.instream, *begin));
-            tree->add_child(shared_ptr<SyntaxTree> { new SyntaxTree(NodeType::Text, parser.instream, *begin) });
+            SyntaxTree* tree = parser.make_node(NodeType::Command, *begin);
+            tree->add_child(parser.make_node(NodeType::Text, *begin));
             tree->take_childs(get<ParserSuccess>(arguments).tree);
             return std::make_pair(it, ParserSuccess(std::move(tree)));
         }
@@ -711,7 +715,7 @@ static ParserResult parse_command_statement(ParserContext& parser, token_iterato
 
         if(is<ParserSuccess>(state))
         {
-            shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::NOT, parser.instream, *begin));
+            SyntaxTree* tree = parser.make_node(NodeType::NOT, *begin);
             tree->add_child(get<ParserSuccess>(positive_command).tree);
             return std::make_pair(it, ParserSuccess(std::move(tree)));
         }
@@ -759,7 +763,7 @@ static ParserResult parse_keycommand_statement(ParserContext& parser, token_iter
                 return std::make_pair(it, std::move(state));
             }
 
-            return std::make_pair(std::next(it), ParserSuccess(new SyntaxTree(type, parser.instream, *begin)));
+            return std::make_pair(std::next(it), ParserSuccess(parser.make_node(type, *begin)));
         }
     }
     return std::make_pair(end, make_error(ParserStatus::GiveUp, begin));
@@ -802,8 +806,8 @@ static ParserResult parse_const_statement(ParserContext& parser, token_iterator
 
         if(is<ParserSuccess>(state))
         {
-            shared_ptr<SyntaxTree> tree(new SyntaxTree(type, parser.instream, *begin));
-            tree->add_child(shared_ptr<SyntaxTree> { new SyntaxTree(NodeType::Text, parser.instream, *begin) });
+            SyntaxTree* tree = parser.make_node(type, *begin);
+            tree->add_child(parser.make_node(NodeType::Text, *begin));
             tree->add_child(get<ParserSuccess>(identifier).tree);
             tree->add_child(get<ParserSuccess>(value).tree);
             return std::make_pair(it, ParserSuccess(std::move(tree)));
@@ -831,8 +835,8 @@ static ParserResult parse_label_statement(ParserContext& parser, token_iterator
         if(it != end && it->type == Token::NewLine)
             ++it;
 
-        TokenData label_token { begin->type, begin->begin, begin->end - 1 };
-        shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::Label, parser.instream, label_token));
+        TokenData label_token { begin->type, begin->begin, begin->end - 1, begin->atom };
+        SyntaxTree* tree = parser.make_node(NodeType::Label, label_token);
         return std::make_pair(it, ParserSuccess(std::move(tree)));
     }
     return std::make_pair(end, make_error(ParserStatus::GiveUp, begin));
@@ -883,7 +887,7 @@ static ParserResult parse_variable_declaration(ParserContext& parser, token_iter
 
             if(is<ParserSuccess>(idents))
             {
-                shared_ptr<SyntaxTree> tree(new SyntaxTree(type, parser.instream, *begin));
+                SyntaxTree* tree = parser.make_node(type, *begin);
                 tree->take_childs(get<ParserSuccess>(idents).tree);
                 return std::make_pair(it, ParserSuccess(std::move(tree)));
             }
@@ -934,7 +938,7 @@ static ParserResult parse_condition_list(ParserContext& parser, token_iterator b
     ParserState state = ParserSuccess(nullptr);
     ParserState command;
 
-    shared_ptr<SyntaxTree> tree;
+    SyntaxTree* tree = nullptr;
     bool is_andor = false;
 
     auto it = begin;
@@ -948,7 +952,7 @@ static ParserResult parse_condition_list(ParserContext& parser, token_iterator b
                 if(!is_andor)
                 {
                     is_andor = true;
-                    shared_ptr<SyntaxTree> newtree(new SyntaxTree(*opt_type));
+                    SyntaxTree* newtree = parser.make_node(*opt_type);
                     if(tree) newtree->add_child(std::move(tree));
                     tree = std::move(newtree);
                 }
@@ -1020,7 +1024,7 @@ static ParserResult parse_while_statement(ParserContext& parser, token_iterator
 
         if(is<ParserSuccess>(state))
         {
-            shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::WHILE, parser.instream, *begin));
+            SyntaxTree* tree = parser.make_node(NodeType::WHILE, *begin);
             tree->add_child(get<ParserSuccess>(conditions).tree);
             tree->add_child(get<ParserSuccess>(statements).tree);
             return std::make_pair(it, ParserSuccess(std::move(tree)));
@@ -1072,7 +1076,7 @@ static ParserResult parse_repeat_statement(ParserContext& parser, token_iterator
 
         if(is<ParserSuccess>(state))
         {
-            shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::REPEAT, parser.instream, *begin));
+            SyntaxTree* tree = parser.make_node(NodeType::REPEAT, *begin);
             tree->add_child(get<ParserSuccess>(counter).tree);
             tree->add_child(get<ParserSuccess>(variable).tree);
             tree->add_child(get<ParserSuccess>(statements).tree);
@@ -1134,7 +1138,7 @@ static ParserResult parse_switch_statement(ParserContext& parser, token_iterator
             if(is<ParserSuccess>(state))
             {
                 auto type = (begin->type == Token::CASE? NodeType::CASE : NodeType::DEFAULT);
-                shared_ptr<SyntaxTree> tree(new SyntaxTree(type, parser.instream, *begin));
+                SyntaxTree* tree = parser.make_node(type, *begin);
 
                 if(begin->type == Token::CASE)
                     tree->add_child(get<ParserSuccess>(argument).tree);
@@ -1176,7 +1180,7 @@ static ParserResult parse_switch_statement(ParserContext& parser, token_iterator
 
     if(is<ParserSuccess>(state))
     {
-        shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::SWITCH, parser.instream, *begin));
+        SyntaxTree* tree = parser.make_node(NodeType::SWITCH, *begin);
         tree->add_child(get<ParserSuccess>(argument).tree);
         tree->add_child(get<ParserSuccess>(cases).tree);
         return std::make_pair(it, ParserSuccess(std::move(tree)));
@@ -1205,7 +1209,7 @@ static ParserResult parse_if_statement(ParserContext& parser, token_iterator beg
         ParserState           conditions;
         ParserState           body_true;
         optional<ParserState> body_false;
-        token_iterator        it_else;
+        token_iterator        it_else {};
 
         auto it = std::next(begin);
 
@@ -1238,14 +1242,14 @@ static ParserResult parse_if_statement(ParserContext& parser, token_iterator beg
 
         if(is<ParserSuccess>(state))
         {
-            shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::IF, parser.instream, *begin));
+            SyntaxTree* tree = parser.make_node(NodeType::IF, *begin);
 
             tree->add_child(get<ParserSuccess>(conditions).tree);
             tree->add_child(get<ParserSuccess>(body_true).tree);
 
             if(body_false)
             {
-                shared_ptr<SyntaxTree> else_tree(new SyntaxTree(NodeType::ELSE, parser.instream, *it_else));
+                SyntaxTree* else_tree = parser.make_node(NodeType::ELSE, *it_else);
                 else_tree->add_child(get<ParserSuccess>(*body_false).tree);
                 tree->add_child(std::move(else_tree));
             }
@@ -1307,7 +1311,7 @@ static ParserResult parse_dump_statement(ParserContext& parser, token_iterator b
 
         if(is<ParserSuccess>(state))
         {
-            shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::DUMP, parser.instream, *begin));
+            SyntaxTree* tree = parser.make_node(NodeType::DUMP, *begin);
             tree->set_annotation(DumpAnnotation { std::move(bytes) });
             return std::make_pair(it, ParserSuccess(std::move(tree)));
         }
@@ -1361,20 +1365,15 @@ static ParserResult parse_statement(ParserContext& parser, token_iterator begin,
 // SyntaxTree
 //
 
-SyntaxTree::SyntaxTree(SyntaxTree&& rhs)
-    : type_(rhs.type_), token(std::move(rhs.token)), childs(std::move(rhs.childs)), parent_(std::move(rhs.parent_)),
-      udata(std::move(rhs.udata)), instream(std::move(rhs.instream))
-{
-    rhs.type_ = NodeType::Block;
-    rhs.parent_ = nullopt;
-}
-
-shared_ptr<SyntaxTree> SyntaxTree::clone() const
+SyntaxTree* SyntaxTree::clone() const
 {
-    shared_ptr<SyntaxTree> tree(new SyntaxTree(this->type_));
-    tree->token = this->token;
-    tree->instream = this->instream;
-    tree->udata = this->udata;
+    SyntaxTree* tree = this->instream? this->arena->make_node(this->type_, this->token) : this->arena->make_node(this->type_);
+    if(this->udata)
+    {
+        visit_one(this->udata, [&](const auto& annotation) {
+            tree->set_annotation(annotation);
+        });
+    }
 
     for(auto& child : this->childs)
         tree->add_child(child->clone());
@@ -1386,7 +1385,7 @@ std::shared_ptr<SyntaxTree> SyntaxTree::compile(ProgramContext& program, const T
 {
     ParserContext parser(program, tstream);
 
-    shared_ptr<SyntaxTree> tree(new SyntaxTree(NodeType::Block));
+    SyntaxTree* tree = parser.make_node(NodeType::Block);
 
     auto tokens_begin = tstream.tokens.data();
     auto tokens_end   = tstream.tokens.data() + tstream.tokens.size();
@@ -1428,7 +1427,7 @@ std::shared_ptr<SyntaxTree> SyntaxTree::compile(ProgramContext& program, const T
     if(!any_error)
     {
         //puts(tree->to_string().c_str());
-        return tree;
+        return shared_ptr<SyntaxTree>(parser.arena, tree);
     }
     return nullptr;
 }
@@ -129,7 +129,18 @@ void load_ide(const fs::path& filepath, bool is_default_ide, std::map<std::strin
     }
 }
 
-auto load_dat(const fs::path& filepath, bool is_default_dat) -> std::map<std::string, uint32_t, iless>
+FileStamp FileStamp::of(const fs::path& path)
+{
+    std::error_code ec;
+    FileStamp stamp;
+    stamp.path = path;
+    stamp.size = fs::file_size(path, ec);
+    stamp.mtime = fs::last_write_time(path, ec);
+    return stamp;
+}
+
+auto load_dat(const fs::path& filepath, bool is_default_dat, std::vector<FileStamp>* stamps)
+    -> std::map<std::string, uint32_t, iless>
 {
     std::string file_data;
     std::map<std::string, uint32_t, iless> output;
@@ -161,6 +172,7 @@ auto load_dat(const fs::path& filepath, bool is_default_dat) -> std::map<std::st
                 }
             }
 
+            if(stamps) stamps->emplace_back(FileStamp::of(gamedir / (buffer+4)));
             load_ide(gamedir / (buffer+4), is_default_dat, output);
         }
     }
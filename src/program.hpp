@@ -8,8 +8,10 @@
 #include "parser.hpp"
 #include "symtable.hpp"
 #include "commands.hpp"
+#include <future>
 
 class Options;
+class SetupCache;
 
 struct tag_nocontext_t {};
 constexpr tag_nocontext_t nocontext = {};
@@ -40,11 +42,31 @@ inline std::string format_error(const Options&, const char* type, const weak_ptr
 template<typename T, typename... Args>
 inline std::string format_error(const Options&, const char* type, const shared_ptr<T>& context_, const char* msg, Args&&... args);
 
+/// Size and modification time of a file, to tell whether it changed since the stamp was taken.
+struct FileStamp
+{
+    fs::path            path;
+    uintmax_t           size = uintmax_t(-1);
+    fs::file_time_type  mtime;
+
+    /// Takes the current stamp of the file at `path`, which may not exist.
+    static FileStamp of(const fs::path& path);
+
+    bool operator==(const FileStamp& rhs) const
+    {
+        return this->path == rhs.path && this->size == rhs.size && this->mtime == rhs.mtime;
+    }
+};
+
 /// \throws ConfigError on failure.
 extern void load_ide(const fs::path& filepath, bool is_default_ide, insensitive_map<std::string, uint32_t>& output);
 
+/// If `stamps` isn't `nullptr`, the stamps of the IDE files referenced by the DAT file are pushed into it,
+/// each taken before reading the file.
+///
 /// \throws ConfigError on failure.
-extern auto load_dat(const fs::path& filepath, bool is_default_dat) -> insensitive_map<std::string, uint32_t>;
+extern auto load_dat(const fs::path& filepath, bool is_default_dat, std::vector<FileStamp>* stamps = nullptr)
+    -> insensitive_map<std::string, uint32_t>;
 
 /////////////////////////
 
@@ -98,6 +120,8 @@ public:
     bool skip_cutscene = false;
     bool fsyntax_only = false;
     bool emit_ir2 = false;
+    bool emit_object = false;   //< Compiles into a relocatable object to be linked later (-c).
+    bool map_sources = true;    //< Maps the source files into memory instead of reading them (see `TextStream::from_file`).
     bool linear_sweep = true;
     bool relax_not = false;
     bool output_cleo = false;
@@ -123,6 +147,10 @@ public:
     optional<uint32_t> mission_var_limit;
     optional<uint32_t> switch_case_limit;
     optional<uint32_t> array_elem_limit;
+    uint32_t           jobs = 1;            //< Concurrency of the worker pool (-j). Zero means one job per core.
+
+    /// Directory of the build cache (--build-cache), or empty if not using one.
+    fs::path build_cache;
 
     /// Parses and pushes a --expect-var entry.
     bool push_expect_var(const string_view& info);
@@ -163,6 +191,7 @@ public:
     }
 
 private:
+    friend class ScriptCache;
     transparent_map<std::string, std::string> defines;
 public:
     std::vector<std::pair<std::vector<std::string>, uint32_t>> expect_vars;
@@ -172,18 +201,33 @@ class ProgramContext
 {
 public:
     const Options opt;          ///< Compiler options / flags.
-    const Commands commands;    ///< Commands, Entities and Enums
+    const Commands& commands;   ///< Commands, Entities and Enums
 
 public:
     /// If `logstream` is `nullptr`, does not perform logging.
-    explicit ProgramContext(Options opt, Commands commands, FILE* logstream = stderr) :
-        opt(std::move(opt)), commands(std::move(commands)), logstream(logstream)
+    /// `outstream` is where the output goes to when the output file is `-`.
+    ///
+    /// \note `commands` must outlive this context. It may be shared by many contexts.
+    explicit ProgramContext(Options opt, const Commands& commands, FILE* logstream = stderr, FILE* outstream = stdout) :
+        opt(std::move(opt)), commands(commands), logstream(logstream), outstream(outstream)
     {
     }
 
     ProgramContext(const ProgramContext&) = delete;
     ProgramContext(ProgramContext&&) = delete;
 
+    /// Stream the diagnostics are logged into, or `nullptr` if not logging.
+    FILE* log_stream() const
+    {
+        return this->logstream;
+    }
+
+    /// Stream the output goes to when the output file is `-`.
+    FILE* output_stream() const
+    {
+        return this->outstream;
+    }
+
     /// Checks whether the model `name` is from a IDE file.
     bool is_model_from_ide(const string_view& name) const;
 
@@ -218,16 +262,13 @@ public:
     template<typename Context, typename... Args>
     void error(const Context& context, const char* msg, Args&&... args)
     {
-        if(logstream) this->puts(format_error(this->opt, "error", context, msg, std::forward<Args>(args)...));
-
-        if(++error_count >= max_error)
-            this->fatal_error(nocontext, "too many errors");
+        this->report(Diagnostic { format_message("error", context, msg, std::forward<Args>(args)...), true });
     }
 
     template<typename Context, typename... Args>
     void note(const Context& context, const char* msg, Args&&... args)
     {
-        if(logstream) this->puts(format_error(this->opt, "note", context, msg, std::forward<Args>(args)...));
+        this->report(Diagnostic { format_message("note", context, msg, std::forward<Args>(args)...), false });
     }
 
     template<typename Context, typename... Args>
@@ -240,7 +281,7 @@ public:
         else
         {
             ++warn_count;
-            if(logstream) this->puts(format_error(this->opt, "warning", context, msg, std::forward<Args>(args)...));
+            this->report(Diagnostic { format_message("warning", context, msg, std::forward<Args>(args)...), false });
         }
     }
 
@@ -248,7 +289,7 @@ public:
     void fatal_error [[noreturn]] (const Context& context, const char* msg, Args&&... args)
     {
         ++fatal_count;
-        if(logstream) this->puts(format_error(this->opt, "fatal error", context, msg, std::forward<Args>(args)...));
+        this->report(Diagnostic { format_message("fatal error", context, msg, std::forward<Args>(args)...), false });
         throw ProgramFailure();
     }
 
@@ -282,9 +323,56 @@ public:
         return *opt;
     }
 
+    /// Calls `functor(i)` for each `i` in the range [begin, end) using the worker pool (see `Options::jobs`).
+    ///
+    /// The diagnostics given during each call are buffered and logged in index order after all calls finished,
+    /// so the output is the same as of a sequential loop. If a call throws, the diagnostics up to (and including)
+    /// such call are logged, and its exception is rethrown.
+    template<typename Functor>
+    void parallel_for(size_t begin, size_t end, Functor functor);
+
 private:
+    /// A formatted diagnostic message waiting to be logged.
+    struct Diagnostic
+    {
+        std::string message;        //< Empty if there's no `logstream`.
+        bool        is_error;       //< Whether this counts towards `max_error`.
+    };
+
+    using DiagnosticBuffer = std::vector<Diagnostic>;
+
+    /// Buffer the diagnostics of the current thread go to, or `nullptr` if they should be logged right away.
+    static DiagnosticBuffer*& diagnostic_buffer()
+    {
+        thread_local DiagnosticBuffer* buffer = nullptr;
+        return buffer;
+    }
+
+    template<typename Context, typename... Args>
+    std::string format_message(const char* type, const Context& context, const char* msg, Args&&... args)
+    {
+        if(!logstream) return std::string();
+        return format_error(this->opt, type, context, msg, std::forward<Args>(args)...);
+    }
+
+    void report(Diagnostic diag)
+    {
+        if(auto buffer = diagnostic_buffer())
+        {
+            buffer->emplace_back(std::move(diag));
+            return;
+        }
+
+        if(logstream)
+            this->puts(diag.message);
+
+        if(diag.is_error && ++error_count >= max_error)
+            this->fatal_error(nocontext, "too many errors");
+    }
+
     void puts(const std::string& msg)
     {
+        std::lock_guard<std::mutex> lock(this->puts_mutex);
         std::fprintf(logstream, "%s\n", msg.c_str());
     }
 
@@ -294,21 +382,58 @@ private:
     std::atomic<uint32_t> warn_count  {0};
 
     FILE*     logstream {nullptr};
+    FILE*     outstream {nullptr};
+    std::mutex puts_mutex;          //< Keeps messages logged from different threads from interleaving.
     uint32_t  max_error {UINT_MAX};
 
 
 protected:
     friend class Commands;
-    friend int main(int argc, char** argv);
+    friend int run_driver(char** argv, const fs::path& cwd, FILE* outstream, FILE* errstream, SetupCache* setups,
+                          bool long_lived);
     insensitive_map<std::string, uint32_t> default_models;
     insensitive_map<std::string, uint32_t> level_models;
 };
 
+template<typename Functor>
+inline void ProgramContext::parallel_for(size_t begin, size_t end, Functor functor)
+{
+    std::vector<DiagnosticBuffer> buffers(end - begin);
+    std::vector<std::exception_ptr> failures(end - begin);
+
+    ThreadPool::global().parallel_for(begin, end, [&](size_t i) {
+        auto& current_buffer = diagnostic_buffer();
+        auto previous_buffer = current_buffer;
+        current_buffer = &buffers[i - begin];
+
+        try
+        {
+            functor(i);
+        }
+        catch(...)
+        {
+            failures[i - begin] = std::current_exception();
+        }
+
+        current_buffer = previous_buffer;
+    });
+
+    for(size_t k = 0; k < buffers.size(); ++k)
+    {
+        for(auto& diag : buffers[k])
+            this->report(std::move(diag));
+
+        if(failures[k])
+            std::rethrow_exception(failures[k]);
+    }
+}
+
 ////////////////////////////////////////////////////////////
 
 // from main_compile.cpp and main_decompile.cpp
 
 extern int compile(fs::path input, fs::path output, ProgramContext&);
+extern int link_object(fs::path input, fs::path output, ProgramContext&);
 extern int decompile(fs::path input, fs::path output, ProgramContext&);
 
 extern bool decompile(const void* bytecode, size_t bytecode_size,
@@ -318,6 +443,139 @@ extern bool decompile(const void* bytecode, size_t bytecode_size,
 
 ////////////////////////////////////////////////////////////
 
+// from main.cpp, main_serve.cpp and main_watch.cpp
+
+/// Game configuration and data files loaded for a compilation.
+struct Setup
+{
+    Commands                                commands;
+    insensitive_map<std::string, uint32_t>  default_models;
+    insensitive_map<std::string, uint32_t>  level_models;
+    std::vector<FileStamp>                  inputs;         //< Stamps of the files loaded, taken before loading them.
+
+    /// Checks whether any of the files this setup was loaded from changed since then.
+    bool inputs_changed() const;
+};
+
+/// Setups already loaded, shared by every request made to the compile server.
+class SetupCache
+{
+public:
+    /// Gets the setup identified by `key`, loading it with `load()` if not loaded yet or if its files changed.
+    ///
+    /// The setup is loaded without holding the cache, thus other setups can be taken meanwhile. Concurrent
+    /// requests for the same setup wait for the one load.
+    ///
+    /// \throws whatever `load()` throws.
+    template<typename Functor>
+    shared_ptr<const Setup> get(const std::string& key, Functor load)
+    {
+        shared_ptr<Loading> stale;
+        while(true)
+        {
+            std::promise<shared_ptr<const Setup>> promise;
+            shared_ptr<Loading> loading;
+            bool is_loader = false;
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                auto& entry = this->setups[key];
+                if(entry == nullptr || entry == stale)
+                {
+                    entry = std::make_shared<Loading>(promise.get_future().share());
+                    is_loader = true;
+                }
+                loading = entry;
+            }
+
+            if(is_loader)
+            {
+                try
+                {
+                    promise.set_value(std::make_shared<const Setup>(load()));
+                }
+                catch(...)
+                {
+                    // let the next request try again.
+                    promise.set_exception(std::current_exception());
+                    this->forget(key, loading);
+                    throw;
+                }
+            }
+
+            auto setup = loading->get();
+            if(is_loader || !setup->inputs_changed())
+                return setup;
+
+            stale = std::move(loading);
+        }
+    }
+
+    /// Forgets every setup loaded so far (e.g. because the configuration files changed).
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->setups.clear();
+    }
+
+    /// Forgets every setup loaded so far and every identifier ever interned (see `AtomTable::clear`) if more than
+    /// `max_atoms` identifiers were interned.
+    ///
+    /// \warning no compilation may be running, neither during nor after this call, since their atoms are forgotten.
+    void trim_atoms()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if(AtomTable::global().size() > max_atoms)
+        {
+            this->setups.clear();
+            AtomTable::global().clear();
+        }
+    }
+
+    /// Number of interned identifiers above which `trim_atoms` forgets them.
+    static constexpr size_t max_atoms = 1 << 20;
+
+private:
+    using Loading = std::shared_future<shared_ptr<const Setup>>;
+
+    /// Removes the entry of `key` if it is still `loading`.
+    void forget(const std::string& key, const shared_ptr<Loading>& loading)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->setups.find(key);
+        if(it != this->setups.end() && it->second == loading)
+            this->setups.erase(it);
+    }
+
+private:
+    std::mutex                                      mutex;
+    std::map<std::string, shared_ptr<Loading>>      setups;
+};
+
+/// Runs the command line `argv` (without the program name), writing into `outstream` and `errstream`.
+///
+/// If `cwd` isn't empty, the relative paths in `argv` are relative to it. If `setups` isn't `nullptr`,
+/// configurations are taken from it instead of being loaded every time. If `long_lived`, the command runs in a
+/// process that outlives it (i.e. watch or server), which must not be brought down by the source files.
+extern int run_driver(char** argv, const fs::path& cwd, FILE* outstream, FILE* errstream, SetupCache* setups,
+                      bool long_lived);
+
+/// Compiles the command line `args` (without the action) every time the `input` script, a script
+/// in its subdirectory or one of the `config_files` changes. Only returns on failure to watch the files.
+extern int watch(std::vector<std::string> args, const fs::path& input, const std::vector<fs::path>& config_files,
+                 const fs::path& cwd, FILE* outstream, FILE* errstream);
+
+/// Runs the compile server (`gta3sc serve`) with the command line `argv`.
+extern int serve(char** argv);
+
+/// Runs the command line `argv` on the compile server listening at `socket_path`.
+///
+/// \returns the exit status of the command, or `nullopt` if the server could not be reached or cannot run the
+/// command (e.g. `--watch`), in which case it should be run locally.
+extern optional<int> run_on_server(const char* socket_path, char** argv);
+
+////////////////////////////////////////////////////////////
+
 template<typename... Args>
 inline std::string format_error(const Options& options,
                                 const char* type,
@@ -456,10 +714,10 @@ inline std::string format_error(const Options& opt, const char* type, const Synt
 
     if(!context->has_text())
     {
-        auto it = std::find_if(context->begin(), context->end(), [](const shared_ptr<SyntaxTree>& child) {
+        auto it = std::find_if(context->begin(), context->end(), [](const SyntaxTree* child) {
             return child->has_text();
         });
-        context = (it == context->end())? context : it->get();
+        context = (it == context->end())? context : *it;
     }
 
     if(context->token_stream().use_count() == 0)
@@ -3,22 +3,35 @@
 #include "commands.hpp"
 #include "program.hpp"
 #include "codegen.hpp"
+#include "script_cache.hpp"
 
 shared_ptr<Script> Script::create(fs::path path, ScriptType type, ProgramContext& program)
 {
-    if(auto tstream = TokenStream::tokenize(program, path))
+    shared_ptr<TokenStream> tstream;
+    shared_ptr<SyntaxTree> tree;
+
+    // The build cache keeps no diagnostics, thus the pedantic warnings of the lexer would be lost.
+    if(!program.opt.build_cache.empty() && !program.opt.pedantic)
     {
-        if(auto tree = SyntaxTree::compile(program, *tstream))
-        {
-            auto p = std::shared_ptr<Script>(new Script(program, type, std::move(path), std::move(tstream), std::move(tree)));
-            p->start_label = std::make_shared<Label>(nullptr, p->shared_from_this());
-            p->top_label = std::make_shared<Label>(nullptr, p->shared_from_this());
-            return p;
-        }
+        std::tie(tstream, tree) = ScriptCache::parse(program, path);
+    }
+    else if((tstream = TokenStream::tokenize(program, path)))
+    {
+        tree = SyntaxTree::compile(program, *tstream);
+    }
+
+    if(tree)
+    {
+        return std::shared_ptr<Script>(new Script(program, type, std::move(path), std::move(tstream), std::move(tree)));
     }
     return nullptr;
 }
 
+shared_ptr<Script> Script::from_object(fs::path path, ScriptType type, ProgramContext& program)
+{
+    return std::shared_ptr<Script>(new Script(program, type, std::move(path), nullptr, nullptr));
+}
+
 auto Script::from_subdir(const string_view& filename, const Script::SubDir& subdir,
                          ScriptType type, ProgramContext& program) const -> shared_ptr<Script>
 {
@@ -61,7 +74,6 @@ uint32_t Var::space_taken()
 
 bool Label::may_branch_from(const Script& other_script, ProgramContext& program) const
 {
-    auto script = this->script.lock();
     if(!script->uses_local_offsets())
         return true;
     return script->on_the_same_space_as(other_script);
@@ -81,7 +93,7 @@ auto Scope::output_type_from_node(const SyntaxTree& node) -> optional<OutputType
         return nullopt;
 }
 
-shared_ptr<Var> Scope::var_at(size_t index) const
+Var* Scope::var_at(size_t index) const
 {
     size_t offset = index * 4;
     for(auto& vpair : vars)
@@ -293,8 +305,8 @@ auto Script::compute_used_objects(const std::vector<shared_ptr<Script>>& scripts
 
 void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scripts, SymTable& symbols, ProgramContext& program)
 {
-    std::vector<std::pair<shared_ptr<const Scope>, size_t>> scope_num_inputs;
-    shared_ptr<const Scope> last_scope_entered;
+    std::vector<std::pair<const Scope*, size_t>> scope_num_inputs;
+    const Scope* last_scope_entered = nullptr;
     insensitive_map<std::string, shared_ptr<const SyntaxTree>> script_names;
 
     shared_ptr<SyntaxTree> node_set_progress_total;
@@ -307,7 +319,7 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
     int32_t count_progress = 0;
     int32_t count_respect = 0;
 
-    auto handle_script_input = [&program](const SyntaxTree& arg_node, const shared_ptr<Var>& lvar, bool is_cleo_call) -> bool
+    auto handle_script_input = [&program](const SyntaxTree& arg_node, Var* lvar, bool is_cleo_call) -> bool
     {
         if(auto opt_arg_var = get_base_var_annotation(arg_node))
         {
@@ -328,7 +340,7 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
                 return false;
             }
 
-            lvar->entity = argvar->entity;
+            lvar->entity = argvar->entity.load();
             return true;
         }
         else
@@ -341,7 +353,7 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
 
     auto send_input_vars = [&](const SyntaxTree::const_iterator& input_begin,
         const SyntaxTree::const_iterator& input_end,
-        shared_ptr<const Scope>& target_scope, bool is_cleo_call)
+        const Scope* target_scope, bool is_cleo_call)
     {
         size_t target_var_index = 0;
         for(auto arginput = input_begin; arginput != input_end; ++arginput)
@@ -389,7 +401,7 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
 
     auto recv_output_vars = [&](const SyntaxTree::const_iterator& output_begin,
         const SyntaxTree::const_iterator& output_end,
-        shared_ptr<const Scope>& target_scope, bool is_cleo_call)
+        const Scope* target_scope, bool is_cleo_call)
     {
         assert(is_cleo_call == true);
 
@@ -401,7 +413,7 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
                 auto& outvar = *opt_outvar;
                 auto& scope_output = (*target_scope->outputs)[i];
                 auto output_type = scope_output.first;
-                auto output_entity = scope_output.second.expired()? 0 : scope_output.second.lock()->entity;
+                EntityType output_entity = scope_output.second? scope_output.second->entity.load() : 0;
 
                 assert(output_type == Scope::OutputType::Int || output_type == Scope::OutputType::Float);
 
@@ -435,14 +447,14 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
 
         auto& arglabel_node = node.child(1);
 
-        auto opt_target_label = arglabel_node.maybe_annotation<const shared_ptr<Label>&>();
+        auto opt_target_label = arglabel_node.maybe_annotation<Label*>();
         if(!opt_target_label)
         {
             program.warning(arglabel_node, "target label is not a label identifier");
             return;
         }
 
-        auto& target_scope = (*opt_target_label)->scope;
+        auto target_scope = (*opt_target_label)->scope;
         if(!target_scope)
         {
             auto where = program.opt.scope_then_label? "before" : "after";
@@ -510,14 +522,14 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
         auto& arglabel_node = node.child(1);
         auto& argcount_node = node.child(2);
 
-        auto opt_target_label = arglabel_node.maybe_annotation<const shared_ptr<Label>&>();
+        auto opt_target_label = arglabel_node.maybe_annotation<Label*>();
         if(!opt_target_label)
         {
             program.warning(arglabel_node, "target label is not a label identifier");
             return;
         }
 
-        auto& target_scope = (*opt_target_label)->scope;
+        auto target_scope = (*opt_target_label)->scope;
         if(!target_scope)
         {
             auto where = program.opt.scope_then_label? "before" : "after";
@@ -614,9 +626,9 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
 
                 if(auto opt_var = get_base_var_annotation(**it))
                 {
-                    if(!output.second.expired())
+                    if(output.second)
                     {
-                        auto output_var = output.second.lock();
+                        auto output_var = output.second;
                         auto& return_var = *opt_var;
 
                         if(output_var->entity != return_var->entity)
@@ -715,7 +727,7 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
                 case NodeType::Scope:
                 {
                     // scope checking already happened at this point, so no need for handling entering/exiting
-                    last_scope_entered = node.annotation<shared_ptr<Scope>>();
+                    last_scope_entered = node.annotation<Scope*>();
                     return true;
                 }
 
@@ -807,7 +819,7 @@ void Script::handle_special_commands(const std::vector<shared_ptr<Script>>& scri
                                     program.error(node, "assignment of variable of type {} into one of type {}", type_b, type_a);
                                 }
 
-                                avar.entity = bvar.entity;
+                                avar.entity = bvar.entity.load();
                             }
                         }
                     }
@@ -879,7 +891,7 @@ void Script::compute_scope_outputs(const SymTable& symbols, ProgramContext& prog
                                             outputs.emplace_back((*opt_var)->type, *opt_var);
                                     }
                                     else
-                                        outputs.emplace_back(Scope::OutputType::TextLabel, weak_ptr<Var>());
+                                        outputs.emplace_back(Scope::OutputType::TextLabel, nullptr);
 
                                     if(outputs.back().first == Scope::OutputType::TextLabel)
                                         program.error(**it, "this output type is not supported");
@@ -891,11 +903,11 @@ void Script::compute_scope_outputs(const SymTable& symbols, ProgramContext& prog
                             }
                             else if((*it)->type() == NodeType::Integer)
                             {
-                                outputs.emplace_back(Scope::OutputType::Int, weak_ptr<Var>());
+                                outputs.emplace_back(Scope::OutputType::Int, nullptr);
                             }
                             else if((*it)->type() == NodeType::Float)
                             {
-                                outputs.emplace_back(Scope::OutputType::Float, weak_ptr<Var>());
+                                outputs.emplace_back(Scope::OutputType::Float, nullptr);
                             }
                             else if((*it)->type() == NodeType::String)
                             {
@@ -29,6 +29,9 @@ public:
     shared_ptr<Script> from_subdir(const string_view& filename, const SubDir& subdir,
                                    ScriptType type, ProgramContext& program) const;
 
+    /// Creates a `Script` whose code comes from a relocatable object, and as such has no syntax tree.
+    static shared_ptr<Script> from_object(fs::path path, ScriptType type, ProgramContext& program);
+
     /// Scans the subdirectory (recursively) named after the name of this script file.
     /// \returns map of (filename, filepath) to all script files found.
     auto scan_subdir() const -> SubDir;
@@ -112,19 +115,22 @@ public:
     /// Finds whether the unknown model `name` was used in this script, and its usage index.
     optional<int32_t> find_model(const string_view& name) const
     {
-        auto it = std::find_if(models.begin(), models.end(), [&](const auto& mpair) {
-            return iequal_to()(mpair.first, name);
-        });
+        std::lock_guard<std::mutex> lock(this->models_mutex);
+        auto it = this->find_model_unlocked(name);
         if(it != models.end())
             return it->second;
         return nullopt;
     }
 
     /// Does the same as `find_model`, except it adds the model if none was found.
+    ///
+    /// This may be called concurrently (e.g. while annotating scripts in parallel).
     int32_t add_or_find_model(const string_view& name)
     {
-        if(auto opt = this->find_model(name))
-            return *opt;
+        std::lock_guard<std::mutex> lock(this->models_mutex);
+        auto it = this->find_model_unlocked(name);
+        if(it != models.end())
+            return it->second;
         return this->models.emplace(models.end(), name.to_string(), models.size())->second;
     }
 
@@ -134,14 +140,21 @@ public:
         return this->models.at(i).second;
     }
 
+    /// \returns the unknown models used by this script, in the order of their usage index.
+    /// \warning This method is not thread-safe.
+    auto used_models() const -> const std::vector<std::pair<std::string, int32_t>>&
+    {
+        return this->models;
+    }
+
 public:
     const fs::path          path;
     const ScriptType        type;
     const shared_ptr<TokenStream> tstream;
     shared_ptr<SyntaxTree>  tree;
 
-    shared_ptr<Label>       top_label;      //< Label on the very top of the script, before any command.
-    shared_ptr<Label>       start_label;    //< Label to jump into when starting this script.
+    Label*                  top_label = nullptr;    //< Label on the very top of the script, before any command.
+    Label*                  start_label = nullptr;  //< Label to jump into when starting this script.
 
     /// The offset of this script, in bytes, in the fully compiled SCM.
     /// This value is made available before/during the code generation step.
@@ -166,8 +179,12 @@ public:
     /// This value is made available just before the AST annotation step.
     optional<uint16_t>      streamed_id;
 
+    /// The space, in words, taken by the global variables declared in this script.
+    /// This value is made available after the symbol scanning step.
+    uint32_t                size_global_vars = 0;
+
     /// All the scopes within this script.
-    std::vector<shared_ptr<Scope>> scopes;
+    std::vector<Scope*>     scopes;
 
     // Required scripts.
     std::vector<weak_ptr<const Script>> children_scripts;   //< Required scripts.
@@ -177,8 +194,16 @@ private:
     /// List of used models referenced by this script.
     /// This value is made available after the AST annotation step.
     std::vector<std::pair<std::string, int32_t>> models;
+    mutable std::mutex models_mutex;    //< Guards `models` during the AST annotation step.
 
 private:
+    auto find_model_unlocked(const string_view& name) const -> decltype(models)::const_iterator
+    {
+        return std::find_if(models.begin(), models.end(), [&](const auto& mpair) {
+            return iequal_to()(mpair.first, name);
+        });
+    }
+
     // Use Script::create or Script::from_subdir instead.
     explicit Script(ProgramContext& program, ScriptType type, fs::path path_,
         shared_ptr<TokenStream> tstream, shared_ptr<SyntaxTree> tree)
@@ -190,10 +215,11 @@ private:
 /// Information about a previously declared variable.
 struct Var
 {
+    VarId                     id = 0;///< Index of this variable in `SymTable::var_table`.
     weak_ptr<const SyntaxTree>where; //< Declaration node or expired() if none.
     const bool                global;
     const VarType             type;
-    EntityType                entity;///< The entity type of this variable. \note only avaiabile after Script::verify_special_commands(...). 
+    std::atomic<EntityType>   entity;///< The entity type of this variable. \note only avaiabile after Script::verify_special_commands(...). 
     uint32_t                  index; ///< Variable index (not offset). \note this value is not well-defined until the ir-generation step.
     const optional<uint32_t>  count; ///< If an array, the number of elements of it.
 
@@ -212,7 +238,7 @@ struct Var
     static uint32_t space_taken(VarType type, size_t count = 1);
 
     /// \returns the byte offset (index*4) on which this variable is in memory.
-    uint32_t offset() {
+    uint32_t offset() const {
         return index * 4;
     }
 
@@ -232,11 +258,12 @@ class Scope
 {
 public:
     using OutputType = VarType; // Int, Float, TextLabel=String; TextLabel16 is unused.
-    using OutputVector = std::vector<std::pair<OutputType, weak_ptr<Var>>>;
+    using OutputVector = std::vector<std::pair<OutputType, Var*>>;
 
 public:
-    insensitive_map<std::string, shared_ptr<Var>>   vars;       //< The variables in this scope.
-    
+    ScopeId                                         id = 0;     //< Index of this scope in `SymTable::scope_table`.
+    atom_map<Var*>                                  vars;       //< The variables in this scope.
+
     explicit Scope(weak_ptr<SyntaxTree> tree) :
         tree(std::move(tree))
     {}
@@ -244,8 +271,8 @@ public:
     /// Whether this is a call scope.
     bool is_call_scope() const { return this->outputs != nullopt; }
 
-    /// Returns the variable at the specified local index.
-    shared_ptr<Var> var_at(size_t index) const;
+    /// Returns the variable at the specified local index, or `nullptr` if none.
+    Var* var_at(size_t index) const;
 
 protected:
     weak_ptr<SyntaxTree>    tree;       //< The scope node (of type NodeType::Scope)
@@ -259,21 +286,14 @@ protected:
 /// Label information.
 struct Label
 {
-    shared_ptr<const Scope>   scope;        //< The scope of this label.
-    weak_ptr<const Script>    script;       //< The script of this label (weak to avoid circular reference)
+    LabelId                   id = 0;       //< Index of this label in `SymTable::label_table`.
+    const Scope*              scope;        //< The scope of this label (may be nullptr for none).
+    const Script*             script;       //< The script of this label.
     weak_ptr<const SyntaxTree>where;        //< Where this label was declared (may be expired() for unknown)
     optional<uint32_t>        code_position;//< Relative to `script->code_offset`.
 
-    explicit Label(weak_ptr<const SyntaxTree> where, shared_ptr<const Scope> scope, shared_ptr<const Script> script)
-        : where(std::move(where)), scope(std::move(scope)), script(std::move(script))
-    {}
-
-    explicit Label(shared_ptr<const Scope> scope, shared_ptr<const Script> script)
-        : Label(weak_ptr<const SyntaxTree>(), std::move(scope), std::move(script))
-    {}
-
-    explicit Label(shared_ptr<const Scope> scope, shared_ptr<const Script> script, uint32_t code_position)
-        : scope(std::move(scope)), script(std::move(script)), code_position(code_position)
+    explicit Label(weak_ptr<const SyntaxTree> where, const Scope* scope, const Script* script)
+        : scope(scope), script(script), where(std::move(where))
     {}
 
     /// \returns whether a branch from `other_script` into this label is possible.
@@ -282,14 +302,7 @@ struct Label
     ///  \returns the global offset for this label.
     uint32_t offset() const
     {
-        return script.lock()->code_offset.value() + this->code_position.value();
-    }
-
-    /// \returns the local offset for this label relative to `script->root_script()->base`.
-    uint32_t distance_from_base() const
-    {
-        auto script = this->script.lock();
-        return script->root_script()->header_size() + script->distance_from_root() + this->code_position.value();
+        return script->code_offset.value() + this->code_position.value();
     }
 };
 
@@ -0,0 +1,256 @@
+#include <stdinc.h>
+#include "script_cache.hpp"
+#include "program.hpp"
+#include "system.hpp"
+#include "binary_cache.hpp"
+#include "builtin_config.hpp"
+
+//
+// Build cache.
+//
+// Each script file gets its own entry in the cache directory, named after the hash of its absolute path.
+// An entry is only written for scripts that lexed and parsed without any diagnostic, so loading it needs
+// no diagnostic to be replayed. The cache is not used with -pedantic, since the lexer gives warnings then.
+//
+// All integers are little-endian and all strings are a u32 length followed by its characters.
+//
+//  header:
+//      char[8]         magic ("GTA3SCBC")
+//      u32             version
+//      u64             options hash
+//      string          source path
+//      u64             source size
+//      u64             source content hash
+//
+//  tokens:
+//      u32             count
+//      token[]
+//
+//      token: u8 type, u32 begin, u32 end (their atoms are interned again from the source)
+//
+//  nodes (in pre-order):
+//      u8 type, u8 flags, [token if NODE_HAS_TOKEN], [u32 size, u8 bytes[] if NODE_HAS_DUMP], u32 num_childs
+//
+
+extern const char* GTA3SC_GIT_SHA1;
+
+static constexpr char cache_magic[8] = { 'G', 'T', 'A', '3', 'S', 'C', 'B', 'C' };
+static constexpr uint32_t cache_version = 2;
+
+enum : uint8_t
+{
+    NODE_HAS_TOKEN  = 1 << 0,
+    NODE_HAS_DUMP   = 1 << 1,
+};
+
+// The last values of the enumerations in the cache, so that out of range values are rejected when loading.
+static constexpr uint8_t last_token = uint8_t(Token::ENDDUMP);
+static constexpr uint8_t last_node_type = uint8_t(NodeType::DUMP);
+
+// Deeper trees are parsed again instead of loaded, so that a bad cache cannot overflow the stack.
+static constexpr size_t max_node_depth = 1024;
+
+auto ScriptCache::parse(ProgramContext& program, const fs::path& path)
+    -> std::pair<shared_ptr<TokenStream>, shared_ptr<SyntaxTree>>
+{
+    auto opt_text = TokenStream::TextStream::from_file(path, program.opt.map_sources);
+    if(!opt_text)
+    {
+        program.error(nocontext, "failed to read file '{}'", path.generic_u8string());
+        return { nullptr, nullptr };
+    }
+
+    auto cache_file = cache_file_path(program.opt.build_cache, path);
+
+    auto cached = load(program, cache_file, path, *opt_text);
+    if(cached.second)
+        return cached;
+
+    auto tstream = TokenStream::tokenize(program, std::move(*opt_text));
+    if(!tstream)
+        return { nullptr, nullptr };
+
+    auto tree = SyntaxTree::compile(program, *tstream);
+    if(!tree)
+        return { nullptr, nullptr };
+
+    // failing to write is fine, the script just gets parsed again next time.
+    store(program, cache_file, path, *tstream, *tree);
+
+    return { std::move(tstream), std::move(tree) };
+}
+
+fs::path ScriptCache::cache_file_path(const fs::path& cache_dir, const fs::path& source_file)
+{
+    std::error_code ec;
+    auto key = fs::absolute(source_file, ec).generic_u8string();
+    return cache_dir / fmt::format("{:016x}.ast", fnv1a64(key.data(), key.size()));
+}
+
+uint64_t ScriptCache::options_hash(const Options& options)
+{
+    uint64_t hash = fnv1a64(GTA3SC_GIT_SHA1, std::strlen(GTA3SC_GIT_SHA1));
+
+    uint8_t flags = options.allow_underscore_identifiers;
+    hash = fnv1a64(&flags, sizeof(flags), hash);
+
+    for(auto& define : options.defines)
+    {
+        hash = fnv1a64(define.first.c_str(), define.first.size() + 1, hash);
+        hash = fnv1a64(define.second.c_str(), define.second.size() + 1, hash);
+    }
+
+    return hash;
+}
+
+auto ScriptCache::load(ProgramContext& program, const fs::path& cache_file, const fs::path& source_file,
+                       const TokenStream::TextStream& text) -> std::pair<shared_ptr<TokenStream>, shared_ptr<SyntaxTree>>
+{
+    size_t size = 0;
+    const void* cache_data = map_file_readonly(cache_file, size);
+    if(cache_data == nullptr)
+        return { nullptr, nullptr };
+
+    auto guard = make_scope_guard([&] {
+        unmap_file(cache_data, size);
+    });
+
+    try
+    {
+        CacheReader r(cache_data, size);
+
+        for(char c : cache_magic)
+        {
+            if(r.u8() != uint8_t(c))
+                return { nullptr, nullptr };
+        }
+
+        if(r.u32() != cache_version || r.u64() != options_hash(program.opt))
+            return { nullptr, nullptr };
+
+        if(r.string() != source_file.generic_u8string()
+            || r.u64() != text.data.size() || r.u64() != fnv1a64(text.data.data(), text.data.size()))
+            return { nullptr, nullptr };
+
+        // The token of a label node has no colon (unlike the label token it comes from), thus its identifier is
+        // all of its text.
+        auto read_token = [&](bool is_label_node)
+        {
+            auto type = r.u8();
+            if(type > last_token)
+                throw CacheError();
+
+            TokenStream::TokenData token;
+            token.type  = static_cast<Token>(type);
+            token.begin = r.u32();
+            token.end   = r.u32();
+
+            if(token.begin > token.end || token.end > text.data.size())
+                throw CacheError();
+            auto spelling = text.data.substr(token.begin, token.end - token.begin);
+            token.atom = is_label_node? Atom::intern(spelling) : TokenStream::atom_for(token.type, spelling);
+
+            return token;
+        };
+
+        std::vector<TokenStream::TokenData> tokens(r.count(9));
+        for(auto& token : tokens)
+            token = read_token(false);
+
+        auto tstream = shared_ptr<TokenStream>(new TokenStream(program, text, std::move(tokens)));
+
+        auto arena = std::make_shared<SyntaxArena>(*tstream);
+
+        std::function<SyntaxTree*(size_t)> read_node = [&](size_t depth)
+        {
+            auto type_value = r.u8();
+            auto flags      = r.u8();
+            if(type_value > last_node_type || (flags & ~(NODE_HAS_TOKEN | NODE_HAS_DUMP)) || depth >= max_node_depth)
+                throw CacheError();
+
+            auto type = static_cast<NodeType>(type_value);
+
+            SyntaxTree* node = (flags & NODE_HAS_TOKEN)? arena->make_node(type, read_token(type == NodeType::Label))
+                                                        : arena->make_node(type);
+
+            if(flags & NODE_HAS_DUMP)
+            {
+                DumpAnnotation dump;
+                r.blob(dump.bytes);
+                node->set_annotation(std::move(dump));
+            }
+
+            for(size_t i = 0, n = r.count(2); i < n; ++i)
+                node->add_child(read_node(depth + 1));
+
+            return node;
+        };
+
+        SyntaxTree* root = read_node(0);
+
+        if(!r.at_end())
+            throw CacheError();
+
+        return { std::move(tstream), shared_ptr<SyntaxTree>(arena, root) };
+    }
+    catch(const CacheError&)
+    {
+        return { nullptr, nullptr };
+    }
+}
+
+bool ScriptCache::store(ProgramContext& program, const fs::path& cache_file, const fs::path& source_file,
+                        const TokenStream& tstream, const SyntaxTree& tree)
+{
+    CacheWriter w;
+
+    for(char c : cache_magic)
+        w.u8(uint8_t(c));
+
+    w.u32(cache_version);
+    w.u64(options_hash(program.opt));
+
+    w.string(source_file.generic_u8string());
+    w.u64(tstream.text.data.size());
+    w.u64(fnv1a64(tstream.text.data.data(), tstream.text.data.size()));
+
+    auto write_token = [&](const TokenStream::TokenData& token)
+    {
+        w.u8(uint8_t(token.type));
+        w.u32(uint32_t(token.begin));
+        w.u32(uint32_t(token.end));
+    };
+
+    w.u32(uint32_t(tstream.tokens.size()));
+    for(auto& token : tstream.tokens)
+        write_token(token);
+
+    std::function<void(const SyntaxTree&)> write_node = [&](const SyntaxTree& node)
+    {
+        auto dump = node.maybe_annotation<const DumpAnnotation&>();
+
+        w.u8(uint8_t(node.type()));
+        w.u8((node.instream? NODE_HAS_TOKEN : 0) | (dump? NODE_HAS_DUMP : 0));
+
+        if(node.instream)
+            write_token(node.token);
+
+        if(dump)
+        {
+            w.u32(uint32_t(dump->bytes.size()));
+            for(auto byte : dump->bytes)
+                w.u8(byte);
+        }
+
+        w.u32(uint32_t(node.child_count()));
+        for(auto& child : node)
+            write_node(*child);
+    };
+
+    write_node(tree);
+
+    std::error_code ec;
+    fs::create_directories(cache_file.parent_path(), ec);
+
+    return write_cache_file(cache_file, w.bytes);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdinc.h>
+#include "parser.hpp"
+
+/// Build cache of the scripts front end (see `Options::build_cache`).
+///
+/// Lexing and parsing are the only compilation steps whose result depends on nothing but the script itself (and a few
+/// options), so the token stream and syntax tree of each script are saved and reused while the script is unchanged.
+class ScriptCache
+{
+public:
+    /// Tokenizes and parses the file at `path`, reusing its entry in the build cache if it is up to date.
+    ///
+    /// \returns the token stream and the syntax tree of the file, or `nullptr`s on failure.
+    static auto parse(ProgramContext& program, const fs::path& path)
+        -> std::pair<shared_ptr<TokenStream>, shared_ptr<SyntaxTree>>;
+
+private:
+    /// Gets the path to the cache entry of `source_file` in the `cache_dir` directory.
+    static fs::path cache_file_path(const fs::path& cache_dir, const fs::path& source_file);
+
+    /// Hashes the options that may change the output of the lexer or parser.
+    static uint64_t options_hash(const Options& options);
+
+    /// Loads the tokens and syntax tree of `text` (the contents of `source_file`) from `cache_file`.
+    static auto load(ProgramContext& program, const fs::path& cache_file, const fs::path& source_file,
+                     const TokenStream::TextStream& text) -> std::pair<shared_ptr<TokenStream>, shared_ptr<SyntaxTree>>;
+
+    /// Writes the tokens and syntax tree of `tstream` (the contents of `source_file`) into `cache_file`.
+    static bool store(ProgramContext& program, const fs::path& cache_file, const fs::path& source_file,
+                      const TokenStream& tstream, const SyntaxTree& tree);
+};
@@ -30,8 +30,11 @@
 #include "cpp/string_view.hpp"
 #include "cpp/small_vector.hpp"
 #include "cpp/icompare.hpp"
+#include "cpp/atom_table.hpp"
+#include "cpp/flat_hash_map.hpp"
 #include "cpp/contracts.hpp"
 #include "cpp/file.hpp"
+#include "cpp/thread_pool.hpp"
 
 #pragma warning(push)
 #pragma warning(disable : 4814) // warning: in C++14 'constexpr' will not imply 'const'; consider explicitly specifying 'const'
@@ -57,6 +60,28 @@ using insensitive_map = std::map<Key, Value, iless>;
 template<typename Key>
 using insensitive_set = std::set<Key, iless>;
 
+template<typename Key, typename Value>
+using insensitive_hash_map = flat_hash_map<Key, Value, ihash, iequal_to>;
+
+template<typename Value>
+using atom_map = flat_hash_map<Atom, Value>;
+
+/// Gets pointers to the entries of the `atom_map` sorted by their names (case-insensitively).
+///
+/// Use this whenever the iteration order is visible to the user (e.g. the order of diagnostics).
+template<typename AtomMap>
+auto sorted_by_name(AtomMap& map) -> std::vector<decltype(&*map.begin())>
+{
+    std::vector<decltype(&*map.begin())> entries;
+    entries.reserve(map.size());
+    for(auto& entry : map)
+        entries.emplace_back(&entry);
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return iless()(a->first.name(), b->first.name());
+    });
+    return entries;
+}
+
 class SyntaxTree;
 class ProgramContext;
 class Options;
@@ -71,6 +96,10 @@ struct CompiledScmHeader;
 class MultiFileHeaderList;
 struct Label;
 
+using LabelId = uint32_t;   //< Index of a label in `SymTable::label_table`.
+using VarId   = uint32_t;   //< Index of a variable in `SymTable::var_table`.
+using ScopeId = uint32_t;   //< Index of a scope in `SymTable::scope_table`.
+
 #ifndef _MSC_VER
 #   define __debugbreak()
 #endif
@@ -91,12 +120,13 @@ enum class VarType : uint8_t
     TextLabel16,
 };
 
-// for future parallelism
+/// Calls `functor(i)` for each `i` in [begin, end), in parallel on the global `ThreadPool` (see `-j`).
+///
+/// \warning `functor` must be thread-safe and must not give diagnostics, see `ProgramContext::parallel_for` for that.
 template<typename IndexType, typename Functor>
 inline void for_loop(IndexType begin, IndexType end, Functor functor)
 {
-    for(auto i = begin; i != end; ++i)
-        functor(i);
+    ThreadPool::global().parallel_for(begin, end, functor);
 }
 
 inline std::string escape_string(const string_view& string, char quotes, bool push_quotes)
@@ -32,7 +32,14 @@ void SymTable::apply_offset_to_vars(uint32_t indices)
         var.second->index += indices;
 }
 
-optional<shared_ptr<Var>> SymTable::find_var(const string_view& name, const shared_ptr<Scope>& current_scope) const
+optional<Var*> SymTable::find_var(const string_view& name, const Scope* current_scope) const
+{
+    if(auto atom = Atom::find(name))
+        return this->find_var(atom, current_scope);
+    return nullopt;
+}
+
+optional<Var*> SymTable::find_var(Atom name, const Scope* current_scope) const
 {
     auto it = global_vars.find(name);
     if(it != global_vars.end())
@@ -48,7 +55,14 @@ optional<shared_ptr<Var>> SymTable::find_var(const string_view& name, const shar
     return nullopt;
 }
 
-optional<shared_ptr<Label>> SymTable::find_label(const string_view& name) const
+optional<Label*> SymTable::find_label(const string_view& name) const
+{
+    if(auto atom = Atom::find(name))
+        return this->find_label(atom);
+    return nullopt;
+}
+
+optional<Label*> SymTable::find_label(Atom name) const
 {
     auto it = this->labels.find(name);
     if(it != this->labels.end())
@@ -56,6 +70,13 @@ optional<shared_ptr<Label>> SymTable::find_label(const string_view& name) const
     return nullopt;
 }
 
+void SymTable::compute_label_offsets()
+{
+    this->label_offsets.resize(this->label_table.size());
+    for(auto& label : this->label_table)
+        this->label_offsets[label->id] = label->offset();
+}
+
 optional<shared_ptr<Script>> SymTable::find_script(const string_view& filename) const
 {
     auto it = this->scripts.find(filename);
@@ -76,6 +97,13 @@ optional<uint16_t> SymTable::find_streamed_id(const string_view& stream_constant
 }
 
 optional<const UserConstant&> SymTable::find_constant(const string_view& name) const
+{
+    if(auto atom = Atom::find(name))
+        return this->find_constant(atom);
+    return nullopt;
+}
+
+optional<const UserConstant&> SymTable::find_constant(Atom name) const
 {
     auto it = this->constants.find(name);
     if(it != this->constants.end())
@@ -156,18 +184,22 @@ bool IncluderTable::add_script(ScriptType type, const SyntaxTree& command, Progr
     }
 }
 
-optional<shared_ptr<Var>> SymTable::highest_global_var() const
+/// Orders variables by where they end in memory, as used by `highest_global_var`.
+static bool is_below_var(Var& a, Var& b)
+{
+    if(a.index < b.index)
+        return true;
+    else if(a.index != b.index)
+        return false;
+    else
+        return a.space_taken() < b.space_taken();
+}
+
+optional<Var*> SymTable::highest_global_var() const
 {
     auto fn_comp = [](const auto& apair, const auto& bpair)
     {
-        const shared_ptr<Var>& a = apair.second;
-        const shared_ptr<Var>& b = bpair.second;
-        if(a->index < b->index)
-            return true;
-        else if(a->index != b->index)
-            return false;
-        else
-            return a->space_taken() < b->space_taken();
+        return is_below_var(*apair.second, *bpair.second);
     };
 
     auto it = std::max_element(this->global_vars.begin(), this->global_vars.end(), fn_comp);
@@ -187,77 +219,125 @@ void SymTable::build_script_table(const std::vector<shared_ptr<Script>>& scripts
     }
 }
 
-void SymTable::merge(SymTable&& t2, ProgramContext& program)
+void SymTable::merge(std::vector<SymTable>&& tables, ProgramContext& program)
 {
     auto& t1 = *this;
 
-    decltype(labels) int_labels;
-    decltype(global_vars) int_gvars;
-    decltype(constants) int_constants;
-
-    // finds items that are common in both
-    std::set_intersection(t1.labels.begin(), t1.labels.end(),
-        t2.labels.begin(), t2.labels.end(),
-        std::inserter(int_labels, int_labels.begin()),
-        t1.labels.value_comp());
-
-    // finds items that are common in both
-    std::set_intersection(t1.global_vars.begin(), t1.global_vars.end(),
-        t2.global_vars.begin(), t2.global_vars.end(),
-        std::inserter(int_gvars, int_gvars.begin()),
-        t1.global_vars.value_comp());
-
-    // finds items that are common in both
-    std::set_intersection(t1.constants.begin(), t1.constants.end(),
-        t2.constants.begin(), t2.constants.end(),
-        std::inserter(int_constants, int_constants.begin()),
-        t1.constants.value_comp());
-
-    for(auto& kv : int_labels)
+    // Size everything upfront, so the insertions below never rehash.
+    size_t num_scripts = t1.scripts.size(), num_labels = t1.labels.size();
+    size_t num_vars = t1.global_vars.size(), num_constants = t1.constants.size();
+    size_t num_label_table = t1.label_table.size(), num_var_table = t1.var_table.size();
+    size_t num_scope_table = t1.scope_table.size();
+    for(auto& t2 : tables)
     {
-        auto where1 = t1.labels.find(kv.first)->second->where;
-        auto where2 = t2.labels.find(kv.first)->second->where;
-        program.error(where2, "label name exists already");
-        program.note(where1, "previously defined here");
+        num_scripts += t2.scripts.size();
+        num_labels += t2.labels.size();
+        num_vars += t2.global_vars.size();
+        num_constants += t2.constants.size();
+        num_label_table += t2.label_table.size();
+        num_var_table += t2.var_table.size();
+        num_scope_table += t2.scope_table.size();
     }
 
-    for(auto& kv : int_gvars)
-    {
-        auto where1 = t1.global_vars.find(kv.first)->second->where;
-        auto where2 = t2.global_vars.find(kv.first)->second->where;
-        program.error(where2, "variable name exists already");
-        program.note(where1, "previously defined here");
-    }
+    t1.scripts.reserve(num_scripts);
+    t1.labels.reserve(num_labels);
+    t1.global_vars.reserve(num_vars);
+    t1.constants.reserve(num_constants);
+    t1.label_table.reserve(num_label_table);
+    t1.var_table.reserve(num_var_table);
+    t1.scope_table.reserve(num_scope_table);
 
-    for(auto& kv : int_constants)
+    // Tracked along the insertions instead of calling `size_global_vars` (which scans every variable) per table.
+    optional<Var*> highest_var = t1.highest_global_var();
+
+    // Entries of some table whose names are already taken, paired with the entry which took the name.
+    std::vector<std::pair<const std::pair<const Atom, Label*>*, const Label*>> label_clashes;
+    std::vector<std::pair<const std::pair<const Atom, Var*>*, const Var*>> var_clashes;
+    std::vector<std::pair<const std::pair<const Atom, UserConstant>*, const UserConstant*>> constant_clashes;
+
+    auto by_name = [](const auto& a, const auto& b) {
+        return iless()(a.first->first.name(), b.first->first.name());
+    };
+
+    // Tables are merged in order and the clashes of each one are reported in the order of their names,
+    // so the diagnostics are the same as of merging the tables one at a time.
+    for(auto& t2 : tables)
     {
-        auto where1 = t1.constants.find(kv.first)->second.where;
-        auto where2 = t2.constants.find(kv.first)->second.where;
-        program.error(where2, "user constant exists already");
-        program.note(where1, "previously defined here");
-    }
+        label_clashes.clear();
+        var_clashes.clear();
+        constant_clashes.clear();
 
-    // All error conditions checked, perform actual merge
+        uint32_t begin_t2_vars = (highest_var? (*highest_var)->end_offset() : t1.offset_global_vars) / 4;
+        t2.apply_offset_to_vars(begin_t2_vars);
 
-    uint32_t begin_t2_vars = t1.size_global_vars() / 4;
-    t2.apply_offset_to_vars(begin_t2_vars);
+        for(auto& kv : t2.labels)
+        {
+            auto it = t1.labels.emplace(kv.first, kv.second);
+            if(!it.second)
+                label_clashes.emplace_back(&kv, it.first->second);
+        }
 
-    t1.scripts.insert(std::make_move_iterator(t2.scripts.begin()),
-        std::make_move_iterator(t2.scripts.end()));
+        for(auto& kv : t2.global_vars)
+        {
+            auto it = t1.global_vars.emplace(kv.first, kv.second);
+            if(!it.second)
+                var_clashes.emplace_back(&kv, it.first->second);
+            else if(!highest_var || is_below_var(**highest_var, *kv.second))
+                highest_var = kv.second;
+        }
 
-    t1.labels.insert(std::make_move_iterator(t2.labels.begin()),
-        std::make_move_iterator(t2.labels.end()));
+        for(auto& kv : t2.constants)
+        {
+            auto it = t1.constants.emplace(kv.first, kv.second);
+            if(!it.second)
+                constant_clashes.emplace_back(&kv, &it.first->second);
+        }
 
-    t1.global_vars.insert(std::make_move_iterator(t2.global_vars.begin()),
-        std::make_move_iterator(t2.global_vars.end()));
+        std::sort(label_clashes.begin(), label_clashes.end(), by_name);
+        for(auto& clash : label_clashes)
+        {
+            program.error(clash.first->second->where, "label name exists already");
+            program.note(clash.second->where, "previously defined here");
+        }
+
+        std::sort(var_clashes.begin(), var_clashes.end(), by_name);
+        for(auto& clash : var_clashes)
+        {
+            program.error(clash.first->second->where, "variable name exists already");
+            program.note(clash.second->where, "previously defined here");
+        }
+
+        std::sort(constant_clashes.begin(), constant_clashes.end(), by_name);
+        for(auto& clash : constant_clashes)
+        {
+            program.error(clash.first->second.where, "user constant exists already");
+            program.note(clash.second->where, "previously defined here");
+        }
+
+        t1.scripts.insert(std::make_move_iterator(t2.scripts.begin()),
+            std::make_move_iterator(t2.scripts.end()));
+
+        // the symbols are moved along with their ownership, thus only their ids change.
+        for(auto& label : t2.label_table)
+        {
+            label->id = static_cast<LabelId>(t1.label_table.size());
+            t1.label_table.emplace_back(std::move(label));
+        }
 
-    t1.local_scopes.reserve(t1.local_scopes.size() + t2.local_scopes.size());
-    std::move(t2.local_scopes.begin(), t2.local_scopes.end(), std::back_inserter(t1.local_scopes));
+        for(auto& var : t2.var_table)
+        {
+            var->id = static_cast<VarId>(t1.var_table.size());
+            t1.var_table.emplace_back(std::move(var));
+        }
 
-    t1.constants.insert(std::make_move_iterator(t2.constants.begin()),
-        std::make_move_iterator(t2.constants.end()));
+        for(auto& scope : t2.scope_table)
+        {
+            scope->id = static_cast<ScopeId>(t1.scope_table.size());
+            t1.scope_table.emplace_back(std::move(scope));
+        }
 
-    t1.ictable.merge(std::move(t2.ictable), program);
+        t1.ictable.merge(std::move(t2.ictable), program);
+    }
 }
 
 void IncluderTable::merge(IncluderTable&& t2, ProgramContext& program)
@@ -301,28 +381,70 @@ void IncluderTable::merge(IncluderTable&& t2, ProgramContext& program)
     std::move(t2.streamed_names.begin(), t2.streamed_names.end(), std::back_inserter(t1.streamed_names));
 }
 
+/// Whether the declaration at `a` comes before the declaration at `b` in the source files.
+static bool is_declared_before(const weak_ptr<const SyntaxTree>& a, const weak_ptr<const SyntaxTree>& b)
+{
+    auto node_a = a.lock();
+    auto node_b = b.lock();
+    if(!node_a || !node_b)
+        return node_b != nullptr;
+
+    if(auto cmp = node_a->filename().compare(node_b->filename()))
+        return cmp < 0;
+    return node_a->get_token().begin < node_b->get_token().begin;
+}
+
+/// Calls `functor(begin, end)` for consecutive chunks of the range [0, count) using the worker pool.
+///
+/// \returns the results of the calls, in the order of the chunks.
+template<typename Functor>
+static auto parallel_chunks(size_t count, ProgramContext& program, Functor functor)
+    -> std::vector<decltype(functor(size_t(), size_t()))>
+{
+    const size_t chunk_size = 64;
+    std::vector<decltype(functor(size_t(), size_t()))> results((count + chunk_size - 1) / chunk_size);
+    program.parallel_for(0, results.size(), [&](size_t i) {
+        results[i] = functor(i * chunk_size, std::min(count, (i + 1) * chunk_size));
+    });
+    return results;
+}
+
 void SymTable::check_scope_collisions(ProgramContext& program) const
 {
-    // XXX this method would probably benefit from parallelism
+    // Each local variable is probed against the global variables hash table. The scopes are checked in chunks
+    // on the worker pool, while the collisions are reported afterwards, scope by scope, in the order they were
+    // declared.
 
-    decltype(global_vars) int_vars;
+    using Collision = std::pair<const Var*, const Var*>; // (local, global)
 
-    for(auto& scope : this->local_scopes)
+    auto collisions = parallel_chunks(scope_table.size(), program, [&](size_t begin, size_t end)
     {
-        int_vars.clear();
-
-        // finds items that are common in both
-        std::set_intersection(global_vars.begin(), global_vars.end(),
-            scope->vars.begin(), scope->vars.end(),
-            std::inserter(int_vars, int_vars.begin()),
-            global_vars.value_comp());
+        std::vector<std::vector<Collision>> chunk_collisions(end - begin);
+        for(size_t i = begin; i < end; ++i)
+        {
+            for(auto& kv : scope_table[i]->vars)
+            {
+                auto it = global_vars.find(kv.first);
+                if(it != global_vars.end())
+                    chunk_collisions[i - begin].emplace_back(kv.second, it->second);
+            }
+        }
+        return chunk_collisions;
+    });
 
-        for(auto& kv : int_vars)
+    for(auto& chunk_collisions : collisions)
+    {
+        for(auto& scope_collisions : chunk_collisions)
         {
-            auto where1 = global_vars.find(kv.first)->second->where;
-            auto where2 = scope->vars.find(kv.first)->second->where;
-            program.error(where2, "variable name exists already");
-            program.note(where1, "previously defined here");
+            std::sort(scope_collisions.begin(), scope_collisions.end(), [](const Collision& a, const Collision& b) {
+                return is_declared_before(a.first->where, b.first->where);
+            });
+
+            for(auto& collision : scope_collisions)
+            {
+                program.error(collision.first->where, "variable name exists already");
+                program.note(collision.second->where, "previously defined here");
+            }
         }
     }
 }
@@ -332,32 +454,86 @@ void SymTable::check_constant_collisions(ProgramContext& program) const
     if(!program.opt.constant_checks)
         return;
 
-    // XXX this method would probably benefit from parallelism
+    // Every variable and user constant is probed against the string constants on the worker pool.
+    // The collisions are then reported in the order they were declared.
 
     auto has_constant_with_name = [&](const string_view& name) {
         return program.commands.find_constant_all(name) || program.is_model_from_ide(name);
     };
 
+    std::vector<const std::pair<const Atom, Var*>*> vars;
+    vars.reserve(this->global_vars.size());
     for(auto& kv : this->global_vars)
+        vars.emplace_back(&kv);
+
+    std::vector<const std::pair<const Atom, UserConstant>*> constants;
+    constants.reserve(this->constants.size());
+    for(auto& kv : this->constants)
+        constants.emplace_back(&kv);
+
+    auto var_collisions = parallel_chunks(vars.size(), program, [&](size_t begin, size_t end)
     {
-        if(this->find_constant(kv.first) || has_constant_with_name(kv.first))
-            program.error(kv.second->where, "variable name exists already as a string constant");
-    }
+        std::vector<const Var*> chunk_collisions;
+        for(size_t i = begin; i < end; ++i)
+        {
+            if(this->find_constant(vars[i]->first) || has_constant_with_name(vars[i]->first.name()))
+                chunk_collisions.emplace_back(vars[i]->second);
+        }
+        return chunk_collisions;
+    });
 
-    for(auto& scope : this->local_scopes)
+    auto scope_collisions = parallel_chunks(scope_table.size(), program, [&](size_t begin, size_t end)
     {
-        for(auto& kv : scope->vars)
+        std::vector<std::vector<const Var*>> chunk_collisions(end - begin);
+        for(size_t i = begin; i < end; ++i)
         {
-            if(this->find_constant(kv.first) || has_constant_with_name(kv.first))
-                program.error(kv.second->where, "variable name exists already as a string constant");
+            for(auto& kv : scope_table[i]->vars)
+            {
+                if(this->find_constant(kv.first) || has_constant_with_name(kv.first.name()))
+                    chunk_collisions[i - begin].emplace_back(kv.second);
+            }
         }
-    }
+        return chunk_collisions;
+    });
 
-    for(auto& kv : this->constants)
+    auto constant_collisions = parallel_chunks(constants.size(), program, [&](size_t begin, size_t end)
     {
-        if(has_constant_with_name(kv.first))
-            program.error(kv.second.where, "user constant exists already as a string constant");
+        std::vector<const UserConstant*> chunk_collisions;
+        for(size_t i = begin; i < end; ++i)
+        {
+            if(has_constant_with_name(constants[i]->first.name()))
+                chunk_collisions.emplace_back(&constants[i]->second);
+        }
+        return chunk_collisions;
+    });
+
+    auto by_declaration = [](const auto* a, const auto* b) {
+        return is_declared_before(a->where, b->where);
+    };
+
+    std::vector<const Var*> collisions;
+    for(auto& chunk_collisions : var_collisions)
+        collisions.insert(collisions.end(), chunk_collisions.begin(), chunk_collisions.end());
+    std::sort(collisions.begin(), collisions.end(), by_declaration);
+    for(auto var : collisions)
+        program.error(var->where, "variable name exists already as a string constant");
+
+    for(auto& chunk_collisions : scope_collisions)
+    {
+        for(auto& collisions : chunk_collisions)
+        {
+            std::sort(collisions.begin(), collisions.end(), by_declaration);
+            for(auto var : collisions)
+                program.error(var->where, "variable name exists already as a string constant");
+        }
     }
+
+    std::vector<const UserConstant*> const_collisions;
+    for(auto& chunk_collisions : constant_collisions)
+        const_collisions.insert(const_collisions.end(), chunk_collisions.begin(), chunk_collisions.end());
+    std::sort(const_collisions.begin(), const_collisions.end(), by_declaration);
+    for(auto constant : const_collisions)
+        program.error(constant->where, "user constant exists already as a string constant");
 }
 
 //////////////////////////////////////////
@@ -425,10 +601,13 @@ void SymTable::scan_symbols(Script& script, ProgramContext& program)
 {
     std::function<bool(SyntaxTree&)> walker;
 
-    shared_ptr<Scope> current_scope;
+    Scope* current_scope = nullptr;
     shared_ptr<SyntaxTree> next_scoped_label;
     size_t global_index = 0, local_index = 0;
 
+    script.start_label = this->add_label(weak_ptr<const SyntaxTree>(), nullptr, &script);
+    script.top_label = this->add_label(weak_ptr<const SyntaxTree>(), nullptr, &script);
+
     auto token_to_vartype = [&](NodeType token_type)
     {
         switch(token_type)
@@ -456,17 +635,16 @@ void SymTable::scan_symbols(Script& script, ProgramContext& program)
 
     auto add_label = [&](SyntaxTree& node)
     {
-        auto label_name = node.text();
-        auto label_ptr = this->add_label(node.shared_from_this(), current_scope, script.shared_from_this());
+        auto label_ptr = this->add_named_label(node.shared_from_this(), current_scope, &script);
         if(!label_ptr)
         {
-            label_ptr = this->find_label(label_name).value();
+            label_ptr = this->find_label(node.atom()).value();
             program.error(node, "label name exists already");
             program.note(label_ptr->where, "previously defined here");
         }
 
         assert(label_ptr != nullptr);
-        node.set_annotation(std::move(label_ptr));
+        node.set_annotation(label_ptr);
     };
 
     walker = [&](SyntaxTree& node)
@@ -475,13 +653,11 @@ void SymTable::scan_symbols(Script& script, ProgramContext& program)
         {
             case NodeType::Label:
             {
-                auto label_name = node.text();
-
                 if(!current_scope && !program.opt.scope_then_label)
                 {
                     auto parent = node.parent();
-                    auto next = std::next(std::find(parent->begin(), parent->end(), node.shared_from_this()));
-                    assert(std::prev(next)->get() == std::addressof(node));
+                    auto next = std::next(std::find(parent->begin(), parent->end(), std::addressof(node)));
+                    assert(*std::prev(next) == std::addressof(node));
 
                     if(next != parent->end() && (*next)->type() == NodeType::Scope)
                     {
@@ -504,8 +680,8 @@ void SymTable::scan_symbols(Script& script, ProgramContext& program)
                 {
                     local_index = (!script.is_child_of_mission()? 0 : program.opt.mission_var_begin);
                     current_scope = this->add_scope(node);
-                    current_scope->vars.emplace("TIMERA", std::make_shared<Var>(false, VarType::Int, program.opt.timer_index + 0, nullopt));
-                    current_scope->vars.emplace("TIMERB", std::make_shared<Var>(false, VarType::Int, program.opt.timer_index + 1, nullopt));
+                    current_scope->vars.emplace(Atom::intern("TIMERA"), this->add_var(false, VarType::Int, program.opt.timer_index + 0, nullopt));
+                    current_scope->vars.emplace(Atom::intern("TIMERB"), this->add_var(false, VarType::Int, program.opt.timer_index + 1, nullopt));
                     script.scopes.emplace_back(current_scope);
                 }
                 else
@@ -520,7 +696,7 @@ void SymTable::scan_symbols(Script& script, ProgramContext& program)
                 }
 
                 node.child(0).depth_first(std::ref(walker));
-                node.set_annotation(std::move(current_scope));
+                node.set_annotation(current_scope);
                 return false;
             }
 
@@ -606,19 +782,21 @@ void SymTable::scan_symbols(Script& script, ProgramContext& program)
                             continue;
                         }
 
-                        auto pair = target.emplace(name, std::make_shared<Var>(varnode, global, vartype, index, count));
+                        auto pair = target.emplace(Atom::intern(name), nullptr);
+                        if(pair.second)
+                            pair.first->second = this->add_var(varnode->shared_from_this(), global, vartype, index, count);
                         auto var = pair.first->second;
 
                         if(!pair.second)
                         {
                             program.error(*varnode, "variable name exists already");
                             program.note(var->where, "previously defined here");
-                            varnode->set_annotation(std::move(var));
+                            varnode->set_annotation(var);
                         }
                         else
                         {
                             index += var->space_taken();
-                            varnode->set_annotation(std::move(var));
+                            varnode->set_annotation(var);
                         }
 
                         if(index > max_index)
@@ -651,9 +829,9 @@ void SymTable::scan_symbols(Script& script, ProgramContext& program)
                         Unreachable();
                 }();
 
-                if(!this->add_constant(node.shared_from_this(), node_ident.text().to_string(), value))
+                if(!this->add_constant(node.shared_from_this(), node_ident.atom(), value))
                 {
-                    auto& uconst = this->find_constant(node_ident.text()).value();
+                    auto& uconst = this->find_constant(node_ident.atom()).value();
                     program.error(node, "user constant exists already");
                     program.note(uconst.where, "previously defined here");
                 }
@@ -680,8 +858,8 @@ void Script::annotate_tree(const SymTable& symbols, ProgramContext& program)
     bool had_script_start  = false;
     bool had_script_end    = false;
     
-    shared_ptr<Scope> current_scope;
-    shared_ptr<Label> cutscene_skip;
+    Scope* current_scope = nullptr;
+    bool in_cutscene_skip = false;
     bool is_condition_block = false;
     uint32_t num_statements = 0;
     uint32_t num_directives = 0;
@@ -800,7 +978,7 @@ void Script::annotate_tree(const SymTable& symbols, ProgramContext& program)
                     current_scope = nullptr;
                 });
 
-                current_scope = node.annotation<shared_ptr<Scope>>();
+                current_scope = node.annotation<Scope*>();
                 node.child(0).depth_first(std::ref(walker));
                 return false;
             }
@@ -907,7 +1085,7 @@ void Script::annotate_tree(const SymTable& symbols, ProgramContext& program)
                 {
                     const Command& command = program.supported_or_fatal(node, commands.gosub_file,
                                                                         "GOSUB_FILE");
-                    shared_ptr<Label>  label  = symbols.find_label(node.child(1).text()).value();
+                    Label* label = symbols.find_label(node.child(1).atom()).value();
                     node.child(1).set_annotation(label);
                     node.child(2).set_annotation(label);
                     node.set_annotation(std::cref(command));
@@ -953,22 +1131,23 @@ void Script::annotate_tree(const SymTable& symbols, ProgramContext& program)
                             if(!program.opt.skip_cutscene)
                                 program.error(node, "{} not supported [-fskip-cutscene]", command_name);
 
-                            if(cutscene_skip)
+                            if(in_cutscene_skip)
                             {
                                 program.error(node, "{} inside another {}", command_name, command_name);
                             }
                             else
                             {
-                                cutscene_skip = std::make_shared<Label>(current_scope, this->shared_from_this());
-                                node.set_annotation(ReplacedCommandAnnotation { internal, {cutscene_skip} } );
+                                // the label to skip into is made up by the compiler (see `CompilerContext::compile_command`).
+                                in_cutscene_skip = true;
+                                node.set_annotation(ReplacedCommandAnnotation { internal, {} } );
                             }
                         }
                         else if(commands.equal(command, commands.skip_cutscene_end))
                         {
-                            if(!cutscene_skip)
+                            if(!in_cutscene_skip)
                                 program.error(node, "{} without SKIP_CUTSCENE_START", command_name);
                             else
-                                cutscene_skip = nullptr;
+                                in_cutscene_skip = false;
                         }
                         else if(commands.equal(command, commands.cleo_return))
                         {
@@ -1055,7 +1234,7 @@ void Script::annotate_tree(const SymTable& symbols, ProgramContext& program)
                 bool had_default = false;
                 bool last_statement_was_break = true;
 
-                shared_ptr<const SyntaxTree> last_case;
+                const SyntaxTree* last_case = nullptr;
                 auto& var = node.child(0);
 
                 const Command& switch_command = program.supported_or_fatal(node, commands.switch_, "SWITCH");
@@ -1222,9 +1401,9 @@ void Script::annotate_tree(const SymTable& symbols, ProgramContext& program)
                                 break;
                         }
 
-                        auto a_var = a.maybe_annotation<shared_ptr<Var>>();
-                        auto b_var = b.maybe_annotation<shared_ptr<Var>>();
-                        auto c_var = c.maybe_annotation<shared_ptr<Var>>();
+                        auto a_var = a.maybe_annotation<Var*>();
+                        auto b_var = b.maybe_annotation<Var*>();
+                        auto c_var = c.maybe_annotation<Var*>();
 
                         if(a_var && c_var && a_var == c_var) // Y = THING op Y
                         {
@@ -1373,7 +1552,7 @@ void Script::annotate_tree(const SymTable& symbols, ProgramContext& program)
                       to_string(this->type));
     }
 
-    if(cutscene_skip)
+    if(in_cutscene_skip)
     {
         program.error(*this, "missing SKIP_CUTSCENE_END");
     }
@@ -46,6 +46,10 @@ public:
 };
 
 /// Stores important symbols defined throught scripts (labels, vars, scopes).
+///
+/// The labels, variables and scopes are owned by this table, each one at the index given by its id. Their addresses
+/// are stable, thus the annotations in the syntax trees hold plain pointers to them, while ids are renumbered when
+/// tables are merged.
 class SymTable
 {
 public:
@@ -56,9 +60,9 @@ public:
         ictable(std::move(ictable))
     {}
 
-    /// Merges symbol table `t2` into this one.
+    /// Merges the symbol tables in `tables` into this one, in order.
     /// \warning this method is not exactly thread-safe.
-    void merge(SymTable&& t2, ProgramContext& program);
+    void merge(std::vector<SymTable>&& tables, ProgramContext& program);
 
     /// Construts a SymTable from the symbols in `script`.
     static SymTable from_script(Script& script, ProgramContext& program);
@@ -72,7 +76,7 @@ public:
     void build_script_table(const std::vector<shared_ptr<Script>>& scripts);
 
     /// \returns the highest global variable (based on index), or `nullopt` if no variable in this table.
-    optional<shared_ptr<Var>> highest_global_var() const;
+    optional<Var*> highest_global_var() const;
 
     /// \returns the size (in bytes) of the space required to store the global variables of this table.
     size_t size_global_vars() const;
@@ -83,10 +87,26 @@ public:
 
     /// \returns the variable `name` (either global or local within `current_scope`).
     /// \note `current_scope` may be nullptr for no scope, otherwise it must be a scope owned by this table.
-    optional<shared_ptr<Var>> find_var(const string_view& name, const shared_ptr<Scope>& current_scope) const;
+    optional<Var*> find_var(const string_view& name, const Scope* current_scope) const;
+    optional<Var*> find_var(Atom name, const Scope* current_scope) const;
 
     /// Finds the specified label in this table.
-    optional<shared_ptr<Label>> find_label(const string_view& name) const;
+    optional<Label*> find_label(const string_view& name) const;
+    optional<Label*> find_label(Atom name) const;
+
+    /// Gets the label or variable of the given id.
+    Label& label(LabelId id)                { return *this->label_table[id]; }
+    const Label& label(LabelId id) const    { return *this->label_table[id]; }
+    const Var& var(VarId id) const          { return *this->var_table[id]; }
+
+    /// Number of labels in this table. Ids from this one onwards are free to be used by the labels a script makes
+    /// up during compilation (see `CompilerContext::make_internal_label`).
+    LabelId num_labels() const { return static_cast<LabelId>(this->label_table.size()); }
+
+    /// Resolves the global offset of every label in this table into `label_offsets`.
+    ///
+    /// The scripts must already be placed (see `Script::compute_script_offsets`).
+    void compute_label_offsets();
 
     /// Finds the specified script in this table.
     optional<shared_ptr<Script>> find_script(const string_view& filename) const;
@@ -96,6 +116,7 @@ public:
 
     /// Finds the specified user defined string constant.
     optional<const UserConstant&> find_constant(const string_view& name) const;
+    optional<const UserConstant&> find_constant(Atom name) const;
 
     /// Checks whether local variables in scopes collides with global variables.
     void check_scope_collisions(ProgramContext& program) const;
@@ -108,22 +129,42 @@ protected:
 
     bool add_script(ScriptType type, const SyntaxTree& command, ProgramContext& program);
 
-    shared_ptr<Scope> add_scope(SyntaxTree& tree)
+    Scope* add_scope(SyntaxTree& tree)
+    {
+        auto scope = new Scope(tree.shared_from_this());
+        scope->id = static_cast<ScopeId>(this->scope_table.size());
+        this->scope_table.emplace_back(scope);
+        return scope;
+    }
+
+    template<typename... Args>
+    Var* add_var(Args&&... args)
     {
-        return *local_scopes.emplace(local_scopes.end(), new Scope(tree.shared_from_this()));
+        auto pvar = new Var(std::forward<Args>(args)...);
+        pvar->id = static_cast<VarId>(this->var_table.size());
+        this->var_table.emplace_back(pvar);
+        return pvar;
     }
 
-    shared_ptr<Label> add_label(const shared_ptr<const SyntaxTree>& node, shared_ptr<const Scope> scope, shared_ptr<const Script> script)
+    Label* add_label(weak_ptr<const SyntaxTree> node, const Scope* scope, const Script* script)
     {
-        auto it = this->labels.emplace(node->text().to_string(), std::make_shared<Label>(node, scope, script));
+        auto label = new Label(std::move(node), scope, script);
+        label->id = static_cast<LabelId>(this->label_table.size());
+        this->label_table.emplace_back(label);
+        return label;
+    }
+
+    Label* add_named_label(const shared_ptr<const SyntaxTree>& node, const Scope* scope, const Script* script)
+    {
+        auto it = this->labels.emplace(node->atom(), nullptr);
         if(it.second == false)
             return nullptr;
-        return it.first->second;
+        return (it.first->second = add_label(node, scope, script));
     }
 
-    optional<const UserConstant&> add_constant(const shared_ptr<const SyntaxTree>& node, std::string name, variant<int32_t, float> value)
+    optional<const UserConstant&> add_constant(const shared_ptr<const SyntaxTree>& node, Atom name, variant<int32_t, float> value)
     {
-        auto it = this->constants.emplace(std::move(name), UserConstant { std::move(value), node });
+        auto it = this->constants.emplace(name, UserConstant { std::move(value), node });
         if(it.second == false)
             return nullopt;
         return it.first->second;
@@ -134,20 +175,25 @@ public:
     // IMPORTANT! Make sure whenever you add any new field to this object, to update merge() accordingly !!!!!!!!//
     //!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!//
 
-    insensitive_map<std::string, shared_ptr<Script>> scripts;
-    insensitive_map<std::string, shared_ptr<Label>>  labels;
-    insensitive_map<std::string, shared_ptr<Var>>    global_vars;
-    insensitive_map<std::string, UserConstant>       constants;
-    std::vector<std::shared_ptr<Scope>>              local_scopes;
+    insensitive_hash_map<std::string, shared_ptr<Script>> scripts;
+    atom_map<Label*>                                      labels;
+    atom_map<Var*>                                        global_vars;
+    atom_map<UserConstant>                                constants;
+
+    std::vector<std::unique_ptr<Label>>                   label_table;  //< Every label, by `LabelId`.
+    std::vector<std::unique_ptr<Var>>                     var_table;    //< Every variable (global or local), by `VarId`.
+    std::vector<std::unique_ptr<Scope>>                   scope_table;  //< Every scope, by `ScopeId`.
+
+    std::vector<uint32_t>                                 label_offsets;//< Global offset of each label, see `compute_label_offsets`.
 
     IncluderTable ictable;
 
     uint32_t offset_global_vars = 0;
 };
 
-inline auto get_base_var_annotation(const SyntaxTree& var_node) -> optional<shared_ptr<Var>>
+inline auto get_base_var_annotation(const SyntaxTree& var_node) -> optional<Var*>
 {
-    if(auto opt = var_node.maybe_annotation<const shared_ptr<Var>&>())
+    if(auto opt = var_node.maybe_annotation<Var*>())
         return *opt;
     else if(auto opt = var_node.maybe_annotation<const ArrayAnnotation&>())
         return opt->base;
@@ -8,7 +8,11 @@
 #elif defined(__unix__)
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #elif defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/syslimits.h>
 #include <unistd.h>
@@ -97,6 +101,34 @@ const fs::path& config_path()
     return conf_path;
 }
 
+static fs::path find_user_cache_path()
+{
+#if defined(_WIN32)
+    if(const wchar_t* local_app_data = _wgetenv(L"LOCALAPPDATA"))
+        return fs::path(local_app_data) / L"gta3sc";
+    return fs::path();
+#elif defined(__APPLE__)
+    if(const char* home_path = std::getenv("HOME"))
+        return fs::path(home_path) / "Library/Caches/gta3sc";
+    return fs::path();
+#elif defined(__unix__)
+    const char* xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+    if(xdg_cache_home != NULL && fs::path(xdg_cache_home).is_absolute())
+        return fs::path(xdg_cache_home) / "gta3sc";
+    if(const char* home_path = std::getenv("HOME"))
+        return fs::path(home_path) / ".cache/gta3sc";
+    return fs::path();
+#else
+#   error find_user_cache_path not implemented for this platform.
+#endif
+}
+
+const fs::path& user_cache_path()
+{
+    static fs::path cache_path = find_user_cache_path();
+    return cache_path;
+}
+
 bool allocate_file(FILE* f, uint64_t size)
 {
 #if defined(_WIN32)
@@ -130,3 +162,133 @@ bool allocate_file(FILE* f, uint64_t size)
 #   error allocate_file not implemented for this platform.
 #endif
 }
+
+const void* map_file_readonly(const fs::path& path, size_t& size)
+{
+#if defined(_WIN32)
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(hFile == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER ll;
+    if(!GetFileSizeEx(hFile, &ll) || ll.QuadPart == 0 || uint64_t(ll.QuadPart) > SIZE_MAX)
+    {
+        CloseHandle(hFile);
+        return nullptr;
+    }
+
+    HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(hFile);
+    if(hMapping == NULL)
+        return nullptr;
+
+    const void* data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(hMapping); // the view keeps the mapping alive
+    if(data == nullptr)
+        return nullptr;
+
+    size = size_t(ll.QuadPart);
+    return data;
+
+#elif defined(__unix__) || defined(__APPLE__)
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd == -1)
+        return nullptr;
+
+    struct stat st;
+    if(fstat(fd, &st) == -1 || st.st_size == 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if(data == MAP_FAILED)
+        return nullptr;
+
+    size = size_t(st.st_size);
+    return data;
+#else
+#   error map_file_readonly not implemented for this platform.
+#endif
+}
+
+bool map_file_writable(const fs::path& path, size_t size, void*& data)
+{
+    data = nullptr;
+
+#if defined(_WIN32)
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    if(size == 0)
+    {
+        CloseHandle(hFile);
+        return true;
+    }
+
+    LARGE_INTEGER ll;
+    ll.QuadPart = size;
+
+    if(!SetFilePointerEx(hFile, ll, NULL, FILE_BEGIN) || !SetEndOfFile(hFile))
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READWRITE, 0, 0, NULL);
+    CloseHandle(hFile);
+    if(hMapping == NULL)
+        return false;
+
+    data = MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, 0);
+    CloseHandle(hMapping); // the view keeps the mapping alive
+    return (data != nullptr);
+
+#elif defined(__unix__) || defined(__APPLE__)
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if(fd == -1)
+        return false;
+
+    if(size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    // reserve the disk space up front, since running out of it while writing into the mapping raises SIGBUS.
+#if defined(__linux__)
+    bool allocated = !posix_fallocate(fd, 0, off_t(size));
+#else
+    bool allocated = (ftruncate(fd, off_t(size)) != -1);
+#endif
+    if(!allocated)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if(mapping == MAP_FAILED)
+        return false;
+
+    data = mapping;
+    return true;
+#else
+#   error map_file_writable not implemented for this platform.
+#endif
+}
+
+void unmap_file(const void* data, size_t size)
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#elif defined(__unix__) || defined(__APPLE__)
+    munmap(const_cast<void*>(data), size);
+#else
+#   error unmap_file not implemented for this platform.
+#endif
+}
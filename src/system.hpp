@@ -7,7 +7,22 @@
 /// Returns the path that static configuration is in.
 extern const fs::path& config_path();
 
+/// Returns the path that caches of the current user are kept in (e.g. `$XDG_CACHE_HOME/gta3sc`), or an empty path
+/// if there is none. The directory may not exist yet.
+extern const fs::path& user_cache_path();
+
 /// Allocates size for a file.
 /// \warning the behaviour is undefined if the file isn't empty.
 /// \note the file offset after this call is at the top of the file.
 extern bool allocate_file(FILE*, uint64_t);
+
+/// Maps the file at `path` into memory, for reading only.
+/// \returns the address of the mapping, or `nullptr` on failure (or if the file is empty). `size` receives its size.
+extern const void* map_file_readonly(const fs::path& path, size_t& size);
+
+/// Creates (or truncates) the file at `path` with `size` zeroed bytes and maps it into memory, for writing.
+/// \returns whether it succeeded. `data` receives the address of the mapping, or `nullptr` if the file is empty.
+extern bool map_file_writable(const fs::path& path, size_t size, void*& data);
+
+/// Unmaps a mapping made with `map_file_readonly` or `map_file_writable`.
+extern void unmap_file(const void* data, size_t size);
@@ -0,0 +1,71 @@
+#!/usr/bin/env python
+#
+# Runs a shell command line with a compile server of its own (see src/main_serve.cpp).
+#
+# Usage: Serve.py <gta3sc> <command>
+#
+# The server is reachable through the GTA3SC_SERVER environment variable of the command. Before the command runs,
+# the server is sent a request by hand to make sure it speaks the protocol, thus the command isn't silently run
+# without it. The exit code is the one of the command.
+#
+import os
+import shutil
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+def send_request(path, args):
+    client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    client.connect(path)
+    try:
+        data = struct.pack("<I", len(args))
+        for arg in [*args, os.getcwd()]:
+            arg = arg.encode("utf-8")
+            data += struct.pack("<I", len(arg)) + arg
+        client.sendall(data)
+
+        response = b""
+        while True:
+            chunk = client.recv(4096)
+            if not chunk:
+                break
+            response += chunk
+    finally:
+        client.close()
+
+    frames = []
+    while response:
+        channel, length = struct.unpack("<BI", response[:5])
+        frames.append((channel, response[5:5+length]))
+        response = response[5+length:]
+    return frames
+
+def main(gta3sc, command):
+    tempdir = tempfile.mkdtemp()
+    path = os.path.join(tempdir, "socket")
+    server = subprocess.Popen([gta3sc, "serve", "--socket=" + path])
+    try:
+        for _ in range(100):
+            if os.path.exists(path):
+                break
+            time.sleep(0.1)
+        else:
+            sys.stderr.write("Serve.py: the server did not start\n")
+            return 1
+
+        frames = send_request(path, ["query-config-path"])
+        if not frames or frames[-1] != (0, struct.pack("<i", 0)):
+            sys.stderr.write("Serve.py: bad response from the server: {}\n".format(frames))
+            return 1
+
+        return subprocess.call(command, shell=True, env=dict(os.environ, GTA3SC_SERVER=path))
+    finally:
+        server.kill()
+        server.wait()
+        shutil.rmtree(tempdir, ignore_errors=True)
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1], sys.argv[2]))
@@ -0,0 +1,70 @@
+#!/usr/bin/env python
+#
+# Runs a single watch cycle of gta3sc (see src/main_watch.cpp).
+#
+# Usage: Watch.py <gta3sc> <script> <output> <edited-script> [<args>...]
+#
+# Compiles <script> into <output> with --watch, then copies <edited-script> over <script> and waits for the
+# output to be compiled again. The exit code is 0 if the output changed, 1 if it didn't or the watch timed out.
+#
+import queue
+import shutil
+import subprocess
+import sys
+import threading
+
+TIMEOUT = 60
+
+def wait_compilation(lines):
+    try:
+        while True:
+            line = lines.get(timeout=TIMEOUT)
+            if line is None:
+                sys.stderr.write("Watch.py: gta3sc exited while watching\n")
+                return False
+            sys.stderr.write(line)
+            if "watching for changes" in line:
+                return True
+    except queue.Empty:
+        sys.stderr.write("Watch.py: timed out waiting for a compilation\n")
+        return False
+
+def read_lines(stream, lines):
+    for line in iter(stream.readline, ""):
+        lines.put(line)
+    lines.put(None)
+
+def main(gta3sc, script, output, edited, args):
+    watcher = subprocess.Popen([gta3sc, script, "--watch", "-o", output] + args,
+                               stderr=subprocess.PIPE, universal_newlines=True)
+    try:
+        lines = queue.Queue()
+        reader = threading.Thread(target=read_lines, args=(watcher.stderr, lines))
+        reader.daemon = True
+        reader.start()
+
+        if not wait_compilation(lines):
+            return 1
+
+        with open(output, "rb") as f:
+            before = f.read()
+
+        shutil.copyfile(edited, script)
+
+        if not wait_compilation(lines):
+            return 1
+
+        with open(output, "rb") as f:
+            after = f.read()
+
+        if before == after:
+            sys.stderr.write("Watch.py: the output did not change\n")
+            return 1
+
+        return 0
+    finally:
+        watcher.kill()
+        watcher.wait()
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1], sys.argv[2], sys.argv[3], sys.argv[4], sys.argv[5:]))
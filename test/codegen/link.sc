@@ -0,0 +1,28 @@
+// Tests linking a relocatable object gives the same output as compiling the script directly.
+// RUN: rm -rf "%/T/link" && mkdir -p "%/T/link/direct" "%/T/link/linked" "%/T/link/local" "%/T/link/cs"
+//
+// # Streamed scripts (SCM and IMG)
+// RUN: %gta3sc %S/streaming.sc --config=gtasa --guesser -o "%/T/link/direct/main.scm"
+// RUN: %gta3sc %S/streaming.sc --config=gtasa --guesser -c -o "%/T/link/linked/main.o"
+// RUN: %gta3sc --config=gtasa --guesser "%/T/link/linked/main.o" -o "%/T/link/linked/main.scm"
+// RUN: cmp "%/T/link/direct/main.scm" "%/T/link/linked/main.scm"
+// RUN: cmp "%/T/link/direct/script.img" "%/T/link/linked/script.img"
+//
+// # Missions with local offsets
+// RUN: %gta3sc %S/0002-multifile-local-offsets.sc --config=gta3 -mlocal-offsets -o "%/T/link/local/direct.scm"
+// RUN: %gta3sc %S/0002-multifile-local-offsets.sc --config=gta3 -mlocal-offsets -c -o "%/T/link/local/main.o"
+// RUN: %gta3sc --config=gta3 -mlocal-offsets "%/T/link/local/main.o" -o "%/T/link/local/linked.scm"
+// RUN: cmp "%/T/link/local/direct.scm" "%/T/link/local/linked.scm"
+//
+// # Required scripts of a custom script
+// RUN: %gta3sc %S/0006-require-label-offset.sc --config=gtasa --guesser --cs -o "%/T/link/cs/direct.cs"
+// RUN: %gta3sc %S/0006-require-label-offset.sc --config=gtasa --guesser --cs -c -o "%/T/link/cs/main.o"
+// RUN: %gta3sc --config=gtasa --guesser --cs "%/T/link/cs/main.o" -o "%/T/link/cs/linked.cs"
+// RUN: cmp "%/T/link/cs/direct.cs" "%/T/link/cs/linked.cs"
+//
+// # Objects are only linked with the options they were compiled with
+// RUN: %not %gta3sc --config=gta3 "%/T/link/local/main.o" -o "%/T/link/local/bad.scm" 2>&1 | %FileCheck %s
+// CHECK-L: was compiled with different code generation options
+
+WAIT 0
+TERMINATE_THIS_SCRIPT
@@ -0,0 +1,29 @@
+// Tests linking the objects of scripts that share global variables and models, which are only placed when linking.
+// RUN: rm -rf "%/T/link_symbols" && mkdir -p "%/T/link_symbols"
+// RUN: %gta3sc %s --config=gta3 -o "%/T/link_symbols/direct.scm"
+// RUN: %gta3sc %s --config=gta3 -c -o "%/T/link_symbols/main.o"
+// RUN: test -f "%/T/link_symbols/main.ext.o" && test -f "%/T/link_symbols/main.mission.o"
+// RUN: %gta3sc --config=gta3 "%/T/link_symbols/main.o" -o "%/T/link_symbols/linked.scm"
+// RUN: cmp "%/T/link_symbols/direct.scm" "%/T/link_symbols/linked.scm"
+//
+// # Every object of the program is needed
+// RUN: rm "%/T/link_symbols/main.ext.o"
+// RUN: %not %gta3sc --config=gta3 "%/T/link_symbols/main.o" -o "%/T/link_symbols/bad.scm" 2>&1 | %FileCheck %s
+// CHECK-L: failed to read object file
+
+VAR_INT counter
+VAR_FLOAT speed
+
+GOSUB_FILE ext_start ext.sc
+
+REQUEST_MODEL CAR_A
+REQUEST_MODEL CAR_B
+
+counter = shared_flag
+speed = 1.0
+
+LOAD_AND_LAUNCH_MISSION mission.sc
+
+main_loop:
+WAIT 0
+GOTO main_loop
@@ -0,0 +1,8 @@
+ext_start:
+VAR_INT shared_flag
+
+REQUEST_MODEL CAR_C
+REQUEST_MODEL CAR_A
+
+shared_flag = counter
+RETURN
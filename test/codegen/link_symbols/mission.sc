@@ -0,0 +1,13 @@
+MISSION_START
+{
+LVAR_INT local_a local_b
+
+REQUEST_MODEL CAR_D
+REQUEST_MODEL CAR_B
+
+local_a = shared_flag
+local_b = counter
+speed = 2.0
+GOSUB ext_start
+}
+MISSION_END
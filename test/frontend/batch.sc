@@ -0,0 +1,23 @@
+// Tests every entry of a batch manifest is compiled as if on its own, that a failing entry fails the batch, and that
+// an entry cannot watch for changes.
+// RUN: rm -rf "%/T/batch" && mkdir -p "%/T/batch"
+// RUN: %gta3sc %s --config=gta3 -emit-ir2 -o "%/T/batch/single.ir2"
+// RUN: %gta3sc %s --config=gta3 -emit-ir2 -DOTHER -o "%/T/batch/single_other.ir2"
+// RUN: echo "%s -o %/T/batch/first.ir2" > "%/T/batch/good.txt"
+// RUN: echo "# comment" >> "%/T/batch/good.txt"
+// RUN: echo "%s -o %/T/batch/second.ir2 -DOTHER" >> "%/T/batch/good.txt"
+// RUN: %gta3sc --config=gta3 -emit-ir2 --batch="%/T/batch/good.txt"
+// RUN: cmp "%/T/batch/single.ir2" "%/T/batch/first.ir2"
+// RUN: cmp "%/T/batch/single_other.ir2" "%/T/batch/second.ir2"
+// RUN: echo "./batch/bad.sc -o %/T/batch/bad.ir2" >> "%/T/batch/good.txt"
+// RUN: %not %gta3sc --config=gta3 -emit-ir2 --batch="%/T/batch/good.txt" 2>&1 | %FileCheck %s
+// CHECK-L: bad.sc:1:6: error: no variable with this name
+// CHECK-L: gta3sc: error: 1 of 3 batch entries failed
+// RUN: echo "%s -o %/T/batch/watch.ir2 --watch" > "%/T/batch/watch.txt"
+// RUN: %not timeout 60 %gta3sc --config=gta3 -emit-ir2 --batch="%/T/batch/watch.txt" 2>&1 | grep "watch.txt:1: error: --watch cannot be used in a batch entry"
+
+WAIT 0
+#ifdef OTHER
+WAIT 1
+#endif
+TERMINATE_THIS_SCRIPT
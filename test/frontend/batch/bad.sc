@@ -0,0 +1,2 @@
+WAIT undeclared_var
+TERMINATE_THIS_SCRIPT
@@ -0,0 +1,24 @@
+// Tests scripts loaded from the build cache compile the same as freshly parsed ones, and that changed scripts are parsed again.
+// RUN: rm -rf "%/T/build_cache" && mkdir -p "%/T/build_cache/main"
+// RUN: cp %s "%/T/build_cache/main.sc" && cp ./build_cache/ext1.sc "%/T/build_cache/main/ext1.sc"
+// RUN: %gta3sc "%/T/build_cache/main.sc" --config=gta3 -emit-ir2 --build-cache="%/T/build_cache/cache" -o "%/T/build_cache/first.ir2"
+// RUN: %gta3sc "%/T/build_cache/main.sc" --config=gta3 -emit-ir2 --build-cache="%/T/build_cache/cache" -o "%/T/build_cache/second.ir2"
+// RUN: %gta3sc "%/T/build_cache/main.sc" --config=gta3 -emit-ir2 -o "%/T/build_cache/uncached.ir2"
+// RUN: cmp "%/T/build_cache/first.ir2" "%/T/build_cache/second.ir2"
+// RUN: cmp "%/T/build_cache/first.ir2" "%/T/build_cache/uncached.ir2"
+//
+// # A cache with a token type out of range is ignored, and the script parsed again.
+// RUN: python ./build_cache/corrupt_token.py "%/T/build_cache/cache"
+// RUN: %gta3sc "%/T/build_cache/main.sc" --config=gta3 -emit-ir2 --build-cache="%/T/build_cache/cache" -o "%/T/build_cache/corrupted.ir2"
+// RUN: cmp "%/T/build_cache/first.ir2" "%/T/build_cache/corrupted.ir2"
+// RUN: sed "s/WAIT 1/WAIT 2/" ./build_cache/ext1.sc > "%/T/build_cache/main/ext1.sc"
+// RUN: %gta3sc "%/T/build_cache/main.sc" --config=gta3 -emit-ir2 --build-cache="%/T/build_cache/cache" -o - | %FileCheck %s
+// CHECK-L: WAIT 0i8
+// CHECK-NEXT-L: GOSUB_FILE @MAIN_1 @MAIN_1
+// CHECK-NEXT-L: TERMINATE_THIS_SCRIPT
+// CHECK-NEXT-L: MAIN_1:
+// CHECK-NEXT-L: WAIT 2i8
+
+WAIT 0
+GOSUB_FILE ext1_label ext1.sc
+TERMINATE_THIS_SCRIPT
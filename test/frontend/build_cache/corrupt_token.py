@@ -0,0 +1,12 @@
+# Sets the type of the first token of every script in the build cache at argv[1] out of range.
+import glob
+import struct
+import sys
+
+for path in glob.glob(sys.argv[1] + '/*.ast'):
+    with open(path, 'r+b') as f:
+        data = f.read()
+        # magic, version, options hash, source path, source size, source hash, token count
+        path_size = struct.unpack_from('<I', data, 20)[0]
+        f.seek(8 + 4 + 8 + 4 + path_size + 8 + 8 + 4)
+        f.write(b'\xff')
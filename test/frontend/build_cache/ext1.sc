@@ -0,0 +1,3 @@
+ext1_label:
+WAIT 1
+RETURN
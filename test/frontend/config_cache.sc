@@ -0,0 +1,25 @@
+// Tests the precompiled configuration is rebuilt whenever a XML definition file changes.
+// RUN: mkdir "%/T/config_cache" || echo _
+// RUN: cp ./Inputs/test.xml "%/T/config_cache/test.xml"
+// RUN:      %gta3sc %s --config=gta3 -fsyntax-only --add-config="%/T/config_cache/test.xml" 2>&1
+// RUN:      %gta3sc %s --config=gta3 -fsyntax-only --add-config="%/T/config_cache/test.xml" 2>&1
+// RUN: cp ./Inputs/override.xml "%/T/config_cache/test.xml"
+// RUN: %not %gta3sc %s --config=gta3 -fsyntax-only --add-config="%/T/config_cache/test.xml" 2>&1 | grep "expected float"
+// RUN: %not %gta3sc %s --config=gta3 -fsyntax-only --add-config="%/T/config_cache/test.xml" --no-config-cache 2>&1 | grep "expected float"
+//
+// # The precompiled configurations go into the cache directory of the user, and the ones built from XML files which
+// # no longer exist are removed whenever another one is written, unless written by another compiler revision.
+// RUN: rm -rf "%/T/config_cache/user" && mkdir -p "%/T/config_cache/user"
+// RUN: cp ./Inputs/test.xml "%/T/config_cache/user/a.xml" && cp ./Inputs/test.xml "%/T/config_cache/user/b.xml"
+// RUN: env XDG_CACHE_HOME="%/T/config_cache/user/cache" %gta3sc %s --config=gta3 -fsyntax-only --add-config="%/T/config_cache/user/a.xml"
+// RUN: env XDG_CACHE_HOME="%/T/config_cache/user/cache" %gta3sc %s --config=gta3 -fsyntax-only --add-config="%/T/config_cache/user/b.xml"
+// RUN: test $(ls "%/T/config_cache/user/cache/gta3sc/gta3" | grep -c "^commands-.*\.cache$") -eq 2
+// RUN: touch "%/T/config_cache/user/a.xml"
+// RUN: env XDG_CACHE_HOME="%/T/config_cache/user/cache" %gta3sc %s --config=gta3 -fsyntax-only --add-config="%/T/config_cache/user/a.xml"
+// RUN: rm "%/T/config_cache/user/b.xml"
+// RUN: printf 'GTA3SCCC\003\000\000\000\001\002\003\004\005\006\007\010' > "%/T/config_cache/user/cache/gta3sc/gta3/commands-other.cache"
+// RUN: env XDG_CACHE_HOME="%/T/config_cache/user/cache" %gta3sc %s --config=gta3 -fsyntax-only --add-config="%/T/config_cache/user/a.xml" --add-config="%/T/config_cache/user/a.xml"
+// RUN: test $(ls "%/T/config_cache/user/cache/gta3sc/gta3" | grep -c "^commands-.*\.cache$") -eq 3
+// RUN: test -f "%/T/config_cache/user/cache/gta3sc/gta3/commands-other.cache"
+
+TEST_COMMAND 0 0
@@ -0,0 +1,19 @@
+// Scripts are read in parallel with -j, but their diagnostics must still come in the sequential order.
+// RUN: %dis %gta3sc %s --config=gta3 -fsyntax-only -j4 2>&1 | %FileCheck %s
+// CHECK-L: ext1.sc:2:8: error: too many arguments
+// CHECK-L: ext2.sc:2:8: error: too many arguments
+// CHECK-L: ext3.sc:2:8: error: too many arguments
+// CHECK-L: sub1.sc:2:8: error: too many arguments
+// CHECK-L: miss1.sc:2:8: error: too many arguments
+// CHECK-L: miss2.sc:2:8: error: too many arguments
+// CHECK-L: miss3.sc:2:8: error: too many arguments
+// CHECK-L: miss4.sc:2:8: error: too many arguments
+// CHECK-L: gta3sc: compilation failed
+GOSUB_FILE ext1 ext1.sc
+GOSUB_FILE ext2 ext2.sc
+LAUNCH_MISSION sub1.sc
+LOAD_AND_LAUNCH_MISSION miss1.sc
+LOAD_AND_LAUNCH_MISSION miss2.sc
+LOAD_AND_LAUNCH_MISSION miss3.sc
+LOAD_AND_LAUNCH_MISSION miss4.sc
+TERMINATE_THIS_SCRIPT
@@ -0,0 +1,4 @@
+ext1:
+WAIT 0 0
+GOSUB_FILE ext3 ext3.sc
+RETURN
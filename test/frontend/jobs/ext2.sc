@@ -0,0 +1,3 @@
+ext2:
+WAIT 0 0
+RETURN
@@ -0,0 +1,3 @@
+ext3:
+WAIT 0 0
+RETURN
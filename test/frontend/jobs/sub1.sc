@@ -0,0 +1,3 @@
+MISSION_START
+WAIT 0 0
+MISSION_END
@@ -0,0 +1,11 @@
+// Tests the output may be a pipe or a device, and that no partial output is left behind when writing it fails.
+// RUN: rm -rf "%/T/output_file" && mkdir -p "%/T/output_file/fail/script.img"
+// RUN: %gta3sc %s --config=gta3 -o "%/T/output_file/main.scm"
+// RUN: %gta3sc %s --config=gta3 -o /dev/stdout | cat > "%/T/output_file/piped.scm"
+// RUN: cmp "%/T/output_file/main.scm" "%/T/output_file/piped.scm"
+// RUN: %not %gta3sc ../codegen/streaming.sc --config=gtasa --guesser -o "%/T/output_file/fail/main.scm"
+// RUN: test ! -e "%/T/output_file/fail/main.scm"
+
+VAR_INT n
+n = 1
+WAIT 0
@@ -0,0 +1,11 @@
+// Tests a compilation run through the compile server gives the same output as when run directly, and that the
+// server notices when a configuration file it has loaded changes.
+// RUN: rm -rf "%/T/serve" && mkdir -p "%/T/serve"
+// RUN: cp ./Inputs/test.xml "%/T/serve/test.xml"
+// RUN: %gta3sc %s --config=gta3 -emit-ir2 --add-config="%/T/serve/test.xml" -o "%/T/serve/direct.ir2"
+// RUN: %on-server '%gta3sc %s --config=gta3 -emit-ir2 --add-config="%/T/serve/test.xml" -o "%/T/serve/served.ir2" && \
+// RUN:     cmp "%/T/serve/direct.ir2" "%/T/serve/served.ir2" && \
+// RUN:     cp ./Inputs/override.xml "%/T/serve/test.xml" && \
+// RUN:     %not %gta3sc %s --config=gta3 -fsyntax-only --add-config="%/T/serve/test.xml" 2>&1 | grep "expected float"'
+
+TEST_COMMAND 0 0
@@ -0,0 +1,13 @@
+// Tests objects built by the compile server spell the symbols as declared, whichever spelling the server saw first.
+// RUN: rm -rf "%/T/serve_spelling" && mkdir -p "%/T/serve_spelling/direct" "%/T/serve_spelling/served"
+// RUN: %gta3sc %s --config=gta3 -c -o "%/T/serve_spelling/direct/main.o"
+// RUN: %on-server '%gta3sc ./serve_spelling/upper.sc --config=gta3 -fsyntax-only && \
+// RUN:     %gta3sc %s --config=gta3 -c -o "%/T/serve_spelling/served/main.o" && \
+// RUN:     cmp "%/T/serve_spelling/direct/main.o" "%/T/serve_spelling/served/main.o"'
+
+VAR_INT Player_Count
+
+Main_Loop:
+WAIT 0
+Player_Count = 1
+GOTO main_loop
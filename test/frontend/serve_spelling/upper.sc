@@ -0,0 +1,6 @@
+VAR_INT PLAYER_COUNT
+
+MAIN_LOOP:
+WAIT 0
+PLAYER_COUNT = 1
+GOTO MAIN_LOOP
@@ -0,0 +1,8 @@
+// Tests the compile server refuses to watch for changes, even when asked to by an entry of a batch.
+// RUN: rm -rf "%/T/serve_watch" && mkdir -p "%/T/serve_watch"
+// RUN: echo "%s -o %/T/serve_watch/main.scm --watch" > "%/T/serve_watch/manifest.txt"
+// RUN: %on-server '%not timeout 60 %gta3sc --config=gta3 --batch="%/T/serve_watch/manifest.txt" 2>&1 | %FileCheck %s'
+// CHECK-L: gta3sc: error: 1 of 1 batch entries failed
+
+WAIT 0
+TERMINATE_THIS_SCRIPT
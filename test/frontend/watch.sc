@@ -0,0 +1,10 @@
+// Tests the options watching for changes conflicts with, and that a change to the watched script compiles it again.
+// RUN: rm -rf "%/T/watch" && mkdir -p "%/T/watch"
+// RUN: cp %s "%/T/watch/main.sc"
+// RUN: %not %gta3sc "%/T/watch/main.o" --config=gta3 --watch 2>&1 | grep "error: --watch is only available when compiling"
+// RUN: %not %gta3sc --config=gta3 --watch --batch="%/T/watch/manifest.txt" 2>&1 | grep "error: --watch cannot be used together with --batch"
+// RUN: %not %gta3sc "%/T/watch/main.sc" --config=gta3 --watch -c 2>&1 | grep "error: --watch cannot be used together with -c"
+// RUN: %watch "%/T/watch/main.sc" "%/T/watch/main.scm" ./watch/edited.sc --config=gta3 -Wno-expect-var --build-cache="%/T/watch/cache"
+
+WAIT 0
+TERMINATE_THIS_SCRIPT
@@ -0,0 +1,2 @@
+WAIT 100
+TERMINATE_THIS_SCRIPT
@@ -19,6 +19,7 @@ SAVE_STRING_TO_DEBUG_FILE "// expected-error {{terminating}}
 
 /* 0 */ x = /* ?? */ 0 /* + ?? */
 x = 0 // + ??
+x/* ?? */=/* ?? */0
 
 TERMINATE_THIS_SCRIPT
 
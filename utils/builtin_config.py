@@ -0,0 +1,297 @@
+#!/usr/bin/env python3
+"""
+Translates the bundled XML definition files into C++ tables (see src/builtin_config.hpp).
+
+Usage: builtin_config.py <output.cpp> <symbol> <config_dir> <xml_file>...
+
+Each XML file becomes a BuiltinXml holding its enums, commands and alternators exactly as
+Commands::from_xml would read them. At runtime, any XML file whose contents match one of these
+tables is loaded from it instead of being parsed.
+"""
+import os
+import re
+import sys
+import xml.etree.ElementTree as etree
+
+FNV64_OFFSET = 0xcbf29ce484222325
+FNV64_PRIME  = 0x100000001b3
+MASK64       = 0xFFFFFFFFFFFFFFFF
+
+ARG_TYPES = {
+    "PARAM": "Param",
+    "LABEL": "Label",
+    "INT": "Integer",
+    "FLOAT": "Float",
+    "TEXT_LABEL": "TextLabel",
+    "TEXT_LABEL16": "TextLabel16",
+    "TEXT_LABEL32": "TextLabel32",
+    "STRING": "String",
+    "CONSTANT": "Constant",
+}
+
+# Must match the flags in src/builtin_config.hpp
+CMD_SUPPORTED, CMD_INTERNAL, CMD_EXTENSION, CMD_HAS_ID, CMD_HAS_HASH = (1 << i for i in range(5))
+(ARG_OPTIONAL, ARG_IS_OUTPUT, ARG_IS_REF, ARG_ALLOW_CONSTANT, ARG_ALLOW_GLOBAL_VAR,
+ ARG_ALLOW_LOCAL_VAR, ARG_ALLOW_TEXT_LABEL, ARG_ALLOW_POINTER, ARG_PRESERVE_CASE) = (1 << i for i in range(9))
+
+class ConfigError(Exception):
+    pass
+
+def fnv1a64(data, hash=FNV64_OFFSET):
+    for byte in bytearray(data):
+        hash ^= byte
+        hash = (hash * FNV64_PRIME) & MASK64
+    return hash
+
+def c_stol(string, bits, signed):
+    """Behaves like std::stoi/std::stoul with base zero."""
+    m = re.match(r"\s*([+-]?)(0[xX][0-9a-fA-F]+|0[0-7]*|[1-9][0-9]*)", string)
+    if not m:
+        raise ConfigError("couldn't convert string to int: {}".format(string))
+    digits = m.group(2)
+    if digits[:2] in ("0x", "0X"):
+        value = int(digits[2:], 16)
+    elif digits.startswith("0") and len(digits) > 1:
+        value = int(digits[1:], 8)
+    else:
+        value = int(digits, 10)
+    if m.group(1) == "-":
+        value = -value
+    if signed and not (-(1 << (bits-1)) <= value < (1 << (bits-1))):
+        raise ConfigError("couldn't convert string to int: {}".format(string))
+    return value & ((1 << bits) - 1) if not signed else value
+
+def xml_to_bool(value, default):
+    if value is None:
+        return default
+    if value == "true":
+        return True
+    if value == "false":
+        return False
+    raise ConfigError("boolean is not 'true' or 'false', it is '{}'".format(value))
+
+def c_string(value):
+    if value is None:
+        return "nullptr"
+    out = []
+    for byte in bytearray(value.encode("utf-8")):
+        c = chr(byte)
+        if c in "\\\"":
+            out.append("\\" + c)
+        elif 0x20 <= byte < 0x7F:
+            out.append(c)
+        else:
+            out.append("\\{:03o}".format(byte))
+    return '"' + "".join(out) + '"'
+
+class XmlFile:
+    def __init__(self, path, data):
+        self.path = path
+        self.size = len(data)
+        self.hash = fnv1a64(data)
+        self.enums = []         # (name, is_global, [(name, value)])
+        self.commands = []      # (name, flags, id, hash, [(type, flags, entity, enum)])
+        self.alternators = []   # (name, [alternative])
+
+        root = etree.fromstring(data)
+        if root.tag != "GTA3Script":
+            return
+
+        for section in root:
+            if section.tag == "Constants":
+                for node in section:
+                    if node.tag == "Enum":
+                        self.enums.append(self.parse_enum(node))
+            elif section.tag == "Commands":
+                for node in section:
+                    if node.tag == "Command":
+                        self.commands.append(self.parse_command(node))
+            elif section.tag == "Alternators":
+                for node in section:
+                    if node.tag == "Alternator":
+                        self.alternators.append(self.parse_alternator(node))
+
+    @staticmethod
+    def parse_enum(node):
+        name = node.get("Name")
+        if name is None:
+            raise ConfigError("missing 'Name' attribute on '<Enum>' node")
+
+        constants = []
+        current_value = 0
+        for value_node in node:
+            value_name = value_node.get("Name")
+            if value_name is None:
+                raise ConfigError("missing 'Name' attribute on '<Constant>' node")
+            if value_node.get("Value") is not None:
+                current_value = c_stol(value_node.get("Value"), 32, True)
+            constants.append((value_name, current_value))
+            current_value += 1
+
+        return (name, xml_to_bool(node.get("Global"), False), constants)
+
+    @staticmethod
+    def parse_command(node):
+        name = node.get("Name")
+        if name is None or (node.get("ID") is None and node.get("Hash") is None):
+            raise ConfigError("missing 'Name' or 'ID'/'Hash' attribute on '<Command>' node")
+
+        args = []
+        args_node = node.find("Args")
+        if args_node is not None:
+            for arg_node in args_node.findall("Arg"):
+                if arg_node.get("Type") is None:
+                    raise ConfigError("missing 'Type' attribute on '<Arg>' node")
+                if arg_node.get("Type") not in ARG_TYPES:
+                    raise ConfigError("unexpected 'Type' attribute: {}".format(arg_node.get("Type")))
+
+                arg_type = ARG_TYPES[arg_node.get("Type")]
+                is_output = xml_to_bool(arg_node.get("Out"), False)
+                is_label = (arg_type == "Label")
+
+                flags = 0
+                flags |= ARG_OPTIONAL if xml_to_bool(arg_node.get("Optional"), False) else 0
+                flags |= ARG_IS_OUTPUT if is_output else 0
+                flags |= ARG_IS_REF if xml_to_bool(arg_node.get("Ref"), False) else 0
+                flags |= ARG_ALLOW_CONSTANT if xml_to_bool(arg_node.get("AllowConst"), not is_output) else 0
+                flags |= ARG_ALLOW_GLOBAL_VAR if xml_to_bool(arg_node.get("AllowGlobalVar"), not is_label) else 0
+                flags |= ARG_ALLOW_LOCAL_VAR if xml_to_bool(arg_node.get("AllowLocalVar"), not is_label) else 0
+                flags |= ARG_ALLOW_TEXT_LABEL if xml_to_bool(arg_node.get("AllowTextLabel"), False) else 0
+                flags |= ARG_ALLOW_POINTER if xml_to_bool(arg_node.get("AllowPointer"), False) else 0
+                flags |= ARG_PRESERVE_CASE if xml_to_bool(arg_node.get("PreserveCase"), False) else 0
+
+                args.append((arg_type, flags, arg_node.get("Entity"), arg_node.get("Enum")))
+
+        flags = 0
+        flags |= CMD_SUPPORTED if xml_to_bool(node.get("Supported"), True) else 0
+        flags |= CMD_INTERNAL if xml_to_bool(node.get("Internal"), False) else 0
+        flags |= CMD_EXTENSION if xml_to_bool(node.get("Extension"), False) else 0
+
+        cmdid, cmdhash = 0, 0
+        if node.get("Hash") is not None:
+            flags |= CMD_HAS_HASH
+            cmdhash = c_stol(node.get("Hash"), 32, False)
+        if node.get("ID") is not None:
+            flags |= CMD_HAS_ID
+            cmdid = c_stol(node.get("ID"), 32, True) & 0x7FFF
+
+        return (name, flags, cmdid, cmdhash, args)
+
+    @staticmethod
+    def parse_alternator(node):
+        name = node.get("Name")
+        if name is None:
+            raise ConfigError("missing 'Name' attribute on '<Alternator>' node")
+
+        alternatives = []
+        for alt_node in node:
+            if alt_node.get("Name") is None:
+                raise ConfigError("missing 'Name' attribute on '<Alternative>' node")
+            alternatives.append(alt_node.get("Name"))
+
+        return (name, alternatives)
+
+
+def generate(out, symbol, files):
+    out.write("// Generated by utils/builtin_config.py. Do not edit.\n")
+    out.write("#include <stdinc.h>\n")
+    out.write("#include \"builtin_config.hpp\"\n\n")
+    out.write("namespace {\n\n")
+
+    for n, xml in enumerate(files):
+        ident = "{}_{}".format(symbol, n)
+        out.write("// {}\n".format(xml.path))
+
+        if xml.enums:
+            out.write("constexpr BuiltinXml::Constant {}_constants[] = {{\n".format(ident))
+            for _, _, constants in xml.enums:
+                for name, value in constants:
+                    out.write("    {{ {}, {} }},\n".format(c_string(name), value))
+            out.write("};\n")
+
+            out.write("constexpr BuiltinXml::Enum {}_enums[] = {{\n".format(ident))
+            first = 0
+            for name, is_global, constants in xml.enums:
+                out.write("    {{ {}, {}, {}, {} }},\n".format(c_string(name), "true" if is_global else "false",
+                                                           first, len(constants)))
+                first += len(constants)
+            out.write("};\n")
+
+        if xml.commands:
+            out.write("constexpr BuiltinXml::Arg {}_args[] = {{\n".format(ident))
+            for command in xml.commands:
+                for arg_type, flags, entity, enum in command[4]:
+                    out.write("    {{ ArgType::{}, 0x{:03x}, {}, {} }},\n".format(arg_type, flags,
+                                                                             c_string(entity), c_string(enum)))
+            out.write("};\n")
+
+            out.write("constexpr BuiltinXml::Command {}_commands[] = {{\n".format(ident))
+            first = 0
+            for name, flags, cmdid, cmdhash, args in xml.commands:
+                out.write("    {{ {}, 0x{:02x}, 0x{:04x}, 0x{:08x}, {}, {} }},\n".format(c_string(name), flags, cmdid,
+                                                                                    cmdhash, first, len(args)))
+                first += len(args)
+            out.write("};\n")
+
+        if xml.alternators:
+            out.write("constexpr const char* {}_alternatives[] = {{\n".format(ident))
+            for _, alternatives in xml.alternators:
+                for name in alternatives:
+                    out.write("    {},\n".format(c_string(name)))
+            out.write("};\n")
+
+            out.write("constexpr BuiltinXml::Alternator {}_alternators[] = {{\n".format(ident))
+            first = 0
+            for name, alternatives in xml.alternators:
+                out.write("    {{ {}, {}, {} }},\n".format(c_string(name), first, len(alternatives)))
+                first += len(alternatives)
+            out.write("};\n")
+
+        out.write("\n")
+
+    out.write("} // namespace\n\n")
+    out.write("extern const BuiltinXml {}[] = {{\n".format(symbol))
+    for n, xml in enumerate(files):
+        ident = "{}_{}".format(symbol, n)
+        fields = [
+            c_string(xml.path),
+            "0x{:x}".format(xml.size),
+            "0x{:016x}".format(xml.hash),
+            "{}_constants".format(ident) if xml.enums else "nullptr",
+            "{}_enums".format(ident) if xml.enums else "nullptr",
+            str(len(xml.enums)),
+            "{}_args".format(ident) if xml.commands else "nullptr",
+            "{}_commands".format(ident) if xml.commands else "nullptr",
+            str(len(xml.commands)),
+            "{}_alternatives".format(ident) if xml.alternators else "nullptr",
+            "{}_alternators".format(ident) if xml.alternators else "nullptr",
+            str(len(xml.alternators)),
+        ]
+        out.write("    {\n        " + ",\n        ".join(fields) + ",\n    },\n")
+    out.write("};\n")
+    out.write("extern const size_t {}_count = {};\n".format(symbol, len(files)))
+
+
+def main(argv):
+    if len(argv) < 4:
+        sys.stderr.write("Usage: builtin_config.py <output.cpp> <symbol> <config_dir> <xml_file>...\n")
+        return 1
+
+    output, symbol, config_dir = argv[1], argv[2], argv[3]
+
+    try:
+        files = []
+        for path in argv[4:]:
+            with open(os.path.join(config_dir, path), "rb") as f:
+                files.append(XmlFile(path, f.read()))
+    except (ConfigError, etree.ParseError) as e:
+        sys.stderr.write("builtin_config.py: error: {}: {}\n".format(path, e))
+        return 1
+
+    with open(output + ".tmp", "w") as out:
+        generate(out, symbol, files)
+    os.replace(output + ".tmp", output)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))